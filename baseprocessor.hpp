@@ -2,48 +2,155 @@
 #define BASEPROCESSOR_HPP
 
 #include <thread>
+#include <atomic>
+#include <complex>
 
-#include "conditionalsafequeue.hpp"
+#include "sampleblock.hpp"
+#include "spscring.hpp"
+#include "ports.hpp"
 
-class BaseProcessor {
+/// @brief Steuerung eines Verarbeitungsknotens unabhaengig vom Eingangstyp, damit der
+///        FlowGraph Knoten fuer Abtastwerte und fuer STFT-Frames gemeinsam halten kann.
+class ProcessorNode {
+public:
+    /// @brief Verhalten von dataIn(), wenn der Verbraucher nicht nachkommt
+    enum class Overflow {
+        Block,      // Erzeuger wartet (nur sinnvoll, wenn der Erzeuger warten darf)
+        DropOldest, // Rueckstand verwerfen: der Verbraucher wirft ab halbem Fuellstand die aeltesten
+                    // Bloecke bis auf ein Viertel weg. Ein voller Puffer (process() haengt) verwirft
+                    // wie DropNewest den neuen Block, der Erzeuger darf im SpscRing nicht entnehmen.
+        DropNewest, // neuer Block wird verworfen, solange der Puffer voll ist
+        Decimate    // ab halbem Fuellstand wird nur jeder n-te Block eingereiht
+    };
+
+    /// @brief Zaehler des Knotens (Momentaufnahme)
+    struct Statistics {
+        uint64_t received;
+        uint64_t processed;
+        uint64_t dropped;
+        uint64_t queued;
+    };
+
+    virtual ~ProcessorNode() = default;
+
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+    virtual bool isRunning() const = 0;
+    virtual Statistics getStatistics() const = 0;
+};
+
+
+/// @brief Verarbeitungsknoten: eigener Thread, der Eingaenge vom Typ T aus einem SpscRing
+///        holt und an process() uebergibt. Der Thread schlaeft, solange keine Daten anliegen.
+///        Abgeleitete Klassen muessen stop() in ihrem Destruktor aufrufen.
+template <typename T>
+class BasicProcessor : public ProcessorNode, public InputPort<T> {
     void run() {
-        std::vector<std::complex<float>> data;
+        T data;
 
-        while( _running) {
-            if( _puff.try_pop( data)) {
-                process( data);
+        while( _running && _puff.pop( data)) {
+            // Rueckstand: aeltere Bloecke verwerfen, bis nur noch ein Viertel ansteht
+            if( _policy == Overflow::DropOldest && _puff.size() > _puff.capacity() / 2) {
+                while( _puff.size() > _puff.capacity() / 4 && _puff.try_pop( data))
+                    ++_dropped;
             }
+            process( data);
+            data = T();
+            ++_processed;
         }
     }
 
-    virtual void process( const std::vector<std::complex<float>> &input) = 0;
+    /// @brief Verarbeitung im eigenen Thread, der Eingang darf ueber den Aufruf hinaus gehalten werden
+    virtual void process( const T &input) = 0;
 
 public:
-    BaseProcessor() {
+    /// @param capacity Anzahl Eintraege im Eingangspuffer
+    /// @param policy Verhalten bei vollem Eingangspuffer
+    BasicProcessor( uint64_t capacity = 256, Overflow policy = Overflow::DropNewest)
+        : _running( false), _policy( policy), _decimation( 2), _puff( capacity),
+          _received( 0), _processed( 0), _dropped( 0), _decimation_cnt( 0) {
 
     }
+    virtual ~BasicProcessor() {
+        this->disconnectInput();
+        BasicProcessor::stop();
+    }
 
-    bool start() {
+    /// @brief startet den Verarbeitungsthread
+    /// @return false, wenn der Thread bereits laeuft
+    bool start() override {
+        if( _fred.joinable()) return false;
+        _puff.reset();
         _running = true;
-        _fred = std::thread( &BaseProcessor::process, this);
+        _fred = std::thread( &BasicProcessor::run, this);
         return _fred.joinable();
-    };
-    bool stop() {
+    }
+
+    /// @brief weckt den Thread, wartet auf sein Ende und verwirft anstehende Eintraege
+    void stop() override {
+        if( ! _fred.joinable()) return;
         _running = false;
+        _puff.abort();
+        _fred.join();
+        _puff.clear();
+    }
 
-    };
+    bool isRunning() const override { return _running;}
+
+    /// @brief setzt das Verhalten bei Ueberlauf
+    /// @param decimation Overflow::Decimate: jeder decimation-te Eintrag wird eingereiht
+    void setOverflowPolicy( Overflow policy, uint64_t decimation = 2) {
+        _policy = policy;
+        _decimation = std::max<uint64_t>( decimation, 1);
+    }
+    Overflow getOverflowPolicy() const { return _policy;}
+
+    Statistics getStatistics() const override {
+        return { _received, _processed, _dropped, _puff.size()};
+    }
 
-    void dataIn( std::vector<std::complex<float>> input) {
-        if( input.empty()) return;
-        _puff.push( input);
+    /// @brief reiht den geteilten Eingang ein, ohne die Daten zu kopieren
+    ///        (genau ein Erzeuger-Thread)
+    void dataIn( const T &input) override {
+        if constexpr( requires { input->empty();}) {
+            if( ! input || input->empty()) return;
+        }
+        if( ! _running) return;
+        ++_received;
+
+        switch( _policy) {
+        case Overflow::Block:
+            if( ! _puff.push( input)) ++_dropped;
+            return;
+        case Overflow::Decimate:
+            if( _puff.size() >= _puff.capacity() / 2 && _decimation_cnt++ % _decimation) {
+                ++_dropped;
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+        // DropNewest, Decimate und DropOldest: den Rueckstand baut nur der Verbraucher ab, voll
+        // bleibt voll, bis er wieder entnimmt
+        if( ! _puff.try_push( input))
+            ++_dropped;
     }
 
 
 private:
 
     std::atomic<bool> _running;
-    ConditionSafeQueue<std::complex<float>> _puff;
+    std::atomic<Overflow> _policy;
+    std::atomic<uint64_t> _decimation;
+    SpscRing<T> _puff;
     std::thread _fred;
+
+    std::atomic<uint64_t> _received, _processed, _dropped;
+    uint64_t _decimation_cnt;
 };
 
+/// @brief Knoten auf dem Sample-Pfad (geteilte complex<float> Bloecke)
+using BaseProcessor = BasicProcessor<SampleBlockPtr<std::complex<float>>>;
+
 #endif // BASEPROCESSOR_HPP
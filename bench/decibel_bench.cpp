@@ -0,0 +1,104 @@
+// Durchsatz der Umrechnung Leistung -> dB: die bisherige Kette Tools::abs + Tools::log10
+// und 10 * log10() aus der libm gegen die zur Laufzeit gewaehlten Kernel aus decibel.hpp,
+// je Gliederzahl der Reihe mit Fehler gegen 10 * log10() in double
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "decibel.hpp"
+#include "tools.hpp"
+
+namespace {
+
+/// @brief Tools::log10 vor dem fusionierten Kernel: skalar, .at() und isinf() je Wert
+void
+loopLog10( std::vector<float> &input) {
+    for( uint64_t w = 0; w < input.size(); ++w) {
+        if( std::isinf( input.at( w)))
+            input[ w] = -120.;
+        else
+            input[ w] = 10 * std::log10( input.at( w));
+    }
+}
+
+/// @return Werte je Sekunde [MS/s]
+template<typename Convert>
+double measure( Convert &&convert, uint64_t leng, double min_secs = 0.5) {
+    using clock = std::chrono::steady_clock;
+    convert();      // Caches und Seiten vorwaermen
+    uint64_t rounds = 0;
+    const clock::time_point start = clock::now();
+    double secs = 0.;
+    do {
+        for( int w = 0; w < 16; ++w) convert();
+        rounds += 16;
+        secs = std::chrono::duration<double>( clock::now() - start).count();
+    } while( secs < min_secs);
+    return static_cast<double>( rounds * leng) / secs / 1e6;
+}
+
+} // namespace
+
+
+int main( int argc, char *argv[]) {
+    // Vorgabe: ein Spektrum der Carrier-Erkennung
+    const uint64_t leng = argc > 1 ? std::strtoull( argv[ 1], nullptr, 0) : 4096;
+    std::vector<std::complex<float>> input( leng);
+    std::vector<float> output( leng), magnitude( leng);
+    std::vector<double> reference( leng);
+    std::mt19937 rng( 1);
+    // Betraege ueber viele Dekaden, wie in einem Spektrum mit Traegern und Rauschen
+    std::uniform_real_distribution<float> decade( -6.f, 3.f), phase( 0.f, 6.2831853f);
+    for( std::complex<float> &x : input)
+        x = std::polar( std::pow( 10.f, decade( rng)), phase( rng));
+
+    double level = 0.;
+    for( uint64_t w = 0; w < leng; ++w) {
+        reference[ w] = 10. * std::log10( std::norm( std::complex<double>( input[ w])));
+        level = std::max( level, std::abs( reference[ w]));
+    }
+
+    // bisher in Sonarview: Betrag, dann Tools::log10 auf den Betraegen
+    const auto chain = [ &] {
+        Tools::abs<std::complex<float>, float>( input, magnitude);
+        loopLog10( magnitude);
+    };
+    const double base = measure( chain, leng);
+    const double libm = measure( [ &] {
+        for( uint64_t w = 0; w < leng; ++w)
+            output[ w] = 10.f * std::log10( std::norm( input[ w]));
+    }, leng);
+    std::cout << "Laenge " << leng << ", CPU: " << Simd::name( Simd::detect()) << std::endl;
+    std::cout << "  Tools::abs + Tools::log10\t" << base << " MS/s" << std::endl;
+    std::cout << "  10 * log10()\t" << libm << " MS/s (x" << libm / base << ")" << std::endl;
+
+    for( const Simd::Level lvl : { Simd::Level::Scalar, Simd::Level::SSE2, Simd::Level::AVX2, Simd::Level::AVX512}) {
+        if( lvl > Simd::detect()) break;
+        Simd::limit() = lvl;
+        // skalar rechnet die libm, die Gliederzahl spielt keine Rolle
+        for( int terms = 1; terms <= ( lvl == Simd::Level::Scalar ? 1 : 4); ++terms) {
+            Decibel::Coefficients co;
+            co.terms = terms;
+            const double rate = measure( [ &] { Decibel::fromNorm( input.data(), output.data(), leng, co);}, leng);
+            double error = 0.;
+            for( uint64_t w = 0; w < leng; ++w)
+                error = std::max( error, std::abs( output[ w] - reference[ w]));
+            std::cout << "  " << Simd::name( lvl);
+            if( lvl == Simd::Level::Scalar)
+                std::cout << " (libm)\t";
+            else
+                std::cout << ", " << terms << " Glieder\t";
+            std::cout << rate << " MS/s (x" << rate / base << "), Fehler " << error << " dB";
+            if( lvl != Simd::Level::Scalar)
+                std::cout << " (Grenze " << Decibel::maxError( terms, level) << ")";
+            std::cout << std::endl;
+        }
+    }
+    return EXIT_SUCCESS;
+}
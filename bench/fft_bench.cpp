@@ -0,0 +1,100 @@
+// Durchsatz der FFT: pocketfft::c2c mit neuer shape je Aufruf (bisheriger Wrapper) gegen
+// FFT mit Plaenen aus FFTPlanCache, einzeln und als Stapel. Zwei Lasten: Wasserfall
+// (viele Frames gleicher Laenge) und Carrier-Extraktion (je Peak ein neues FFT-Objekt,
+// wechselnde Laengen)
+
+#include <chrono>
+#include <complex>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "fft.hpp"
+
+namespace {
+
+/// @return Transformationen je Sekunde [1/s]
+template<typename Transform>
+double measure( Transform &&transform, uint64_t count, double min_secs = 0.5) {
+    using clock = std::chrono::steady_clock;
+    transform();    // Caches, Plaene und Seiten vorwaermen
+    uint64_t rounds = 0;
+    const clock::time_point start = clock::now();
+    double secs = 0.;
+    do {
+        for( int w = 0; w < 4; ++w) transform();
+        rounds += 4;
+        secs = std::chrono::duration<double>( clock::now() - start).count();
+    } while( secs < min_secs);
+    return static_cast<double>( rounds * count) / secs;
+}
+
+/// @brief wie FFT::fft() vor dem Plan-Cache
+void c2c( const pocketfft::shape_t &shape, const std::complex<float> *input, std::complex<float> *output) {
+    const pocketfft::stride_t stride = { sizeof( std::complex<float>)};
+    pocketfft::c2c<float>( shape, stride, stride, { 0}, pocketfft::FORWARD, input, output, 1.f);
+}
+
+void print( const char *name, double rate, double base) {
+    std::cout << "  " << name << "\t" << rate / 1e3 << " k/s (x" << rate / base << ")" << std::endl;
+}
+
+} // namespace
+
+
+int main( int argc, char *argv[]) {
+    // Vorgabe: Wasserfall mit 4096er FFT, 64 Frames je Aufruf
+    const uint64_t leng = argc > 1 ? std::strtoull( argv[ 1], nullptr, 0) : 4096;
+    const uint64_t frames = argc > 2 ? std::strtoull( argv[ 2], nullptr, 0) : 64;
+    std::vector<std::complex<float>> input( leng * frames), output( leng * frames);
+    std::mt19937 rng( 1);
+    std::normal_distribution<float> dist;
+    for( std::complex<float> &x : input)
+        x = { dist( rng), dist( rng)};
+
+    std::cout << "Wasserfall: Laenge " << leng << ", " << frames << " Frames" << std::endl;
+    const pocketfft::shape_t shape = { leng};
+    const double base = measure( [ &] {
+        for( uint64_t frame = 0; frame < frames; ++frame)
+            c2c( shape, input.data() + frame * leng, output.data() + frame * leng);
+    }, frames);
+    print( "pocketfft::c2c", base, base);
+    FFT fft( leng);
+    print( "FFT::fft", measure( [ &] {
+        for( uint64_t frame = 0; frame < frames; ++frame)
+            fft.fft( input.data() + frame * leng, output.data() + frame * leng);
+    }, frames), base);
+    print( "FFT::fftBatch, 1 Thread", measure( [ &] {
+        fft.fftBatch( input.data(), output.data(), frames, 1);
+    }, frames), base);
+    print( "FFT::fftBatch, alle Kerne", measure( [ &] {
+        fft.fftBatch( input.data(), output.data(), frames, 0);
+    }, frames), base);
+
+    // Carrier-Extraktion: Bandbreite je Peak verschieden, je Peak ein neues FFT-Objekt
+    const std::vector<uint64_t> lengs = { 96, 128, 250, 256, 384, 500, 512, 1000};
+    std::cout << "Carrier-Extraktion: " << lengs.size() << " Laengen, je Aufruf neues FFT-Objekt" << std::endl;
+    const double base_ddc = measure( [ &] {
+        for( const uint64_t n : lengs)
+            c2c( { n}, input.data(), output.data());
+    }, lengs.size());
+    print( "pocketfft::c2c", base_ddc, base_ddc);
+    print( "FFT( n).fft", measure( [ &] {
+        for( const uint64_t n : lengs) {
+            FFT ddc( n);
+            ddc.fft( input.data(), output.data());
+        }
+    }, lengs.size()), base_ddc);
+
+    // mehr Laengen als Plaene im Cache: jeder Aufruf legt einen Plan an
+    FFTPlanCache::setCapacity( lengs.size() / 2);
+    print( "FFT( n).fft, Cache zu klein", measure( [ &] {
+        for( const uint64_t n : lengs) {
+            FFT ddc( n);
+            ddc.fft( input.data(), output.data());
+        }
+    }, lengs.size()), base_ddc);
+    std::cout << "  Plaene im Cache: " << FFTPlanCache::size() << " von " << FFTPlanCache::capacity() << std::endl;
+    return EXIT_SUCCESS;
+}
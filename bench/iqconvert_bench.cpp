@@ -0,0 +1,62 @@
+// Durchsatz der int16 -> cf32 Wandlung: skalarer Kernel gegen die zur Laufzeit gewaehlten
+// Vektor-Kernel, mit und ohne DC-/IQ-Korrektur (der Kernel rechnet sie immer mit)
+
+#include <chrono>
+#include <complex>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "iqconvert.hpp"
+
+namespace {
+
+/// @return Abtastwerte je Sekunde [MS/s]
+template<typename Convert>
+double measure( Convert &&convert, uint64_t leng, double min_secs = 0.5) {
+    using clock = std::chrono::steady_clock;
+    convert();      // Caches und Seiten vorwaermen
+    uint64_t rounds = 0;
+    const clock::time_point start = clock::now();
+    double secs = 0.;
+    do {
+        for( int w = 0; w < 16; ++w) convert();
+        rounds += 16;
+        secs = std::chrono::duration<double>( clock::now() - start).count();
+    } while( secs < min_secs);
+    return static_cast<double>( rounds * leng) / secs / 1e6;
+}
+
+} // namespace
+
+
+int main( int argc, char *argv[]) {
+    // Vorgabe: ein USB-Transfer (16384 Abtastwerte), passt in den L1/L2
+    const uint64_t leng = argc > 1 ? std::strtoull( argv[ 1], nullptr, 0) : 16 * 1024;
+    std::vector<std::complex<int16_t>> input( leng);
+    std::vector<std::complex<float>> output( leng);
+    std::mt19937 rng( 1);
+    std::uniform_int_distribution<int> dist( -32768, 32767);
+    for( std::complex<int16_t> &x : input)
+        x = { static_cast<int16_t>( dist( rng)), static_cast<int16_t>( dist( rng))};
+
+    IQConvert::Coefficients co;
+    IQConverter corrected;
+    corrected.setDCOffset( { 0.01f, -0.02f});
+    corrected.setIQImbalance( 1.02f, 0.01f);
+    corrected.setDCTracking( 0.01f);
+
+    std::cout << "Laenge " << leng << ", CPU: " << Simd::name( Simd::detect()) << std::endl;
+    double scalar = 0.;
+    for( const Simd::Level lvl : { Simd::Level::Scalar, Simd::Level::SSE2, Simd::Level::AVX2, Simd::Level::AVX512}) {
+        if( lvl > Simd::detect()) break;
+        Simd::limit() = lvl;
+        const double plain = measure( [ &] { IQConvert::convert( input.data(), output.data(), leng, co);}, leng);
+        const double conv = measure( [ &] { corrected.convert( input.data(), output.data(), leng);}, leng);
+        if( lvl == Simd::Level::Scalar) scalar = plain;
+        std::cout << "  " << Simd::name( lvl) << "\t" << plain << " MS/s (x" << plain / scalar << "), IQConverter mit Korrektur "
+                  << conv << " MS/s" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -6,7 +6,14 @@
 #include <execution>
 #include <fstream>
 #include <chrono>
-#include <format>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <limits>
+#include <cmath>
 
 
 // provides Interface
@@ -14,12 +21,11 @@
 
 #include "dsp.hpp"
 #include "fft.hpp"
-#include "fftwindows.hpp"
+#include "firfilter.hpp"
+#include "stft.hpp"
+#include "psd.hpp"
 #include "peakdetection.hpp"
-
-#ifndef DEBUG
-#define DEBUG
-#endif
+#include "sigmf.hpp"
 
 
 /// @brief holds one signal and its metadata
@@ -30,176 +36,285 @@ struct Carrier {
     double samp_rate;       // [HZ]
     double band_width;      // [Hz]
     double rel_band_width;  // bins
+    float level_db;         // hoechster Pegel der gemittelten psd [dBFS]
+    uint64_t sample_start;  // Stromposition der Quelle (StftFrame::sample_index)
+    uint64_t sample_count;  // Dauer in Abtastwerten der Quelle
     std::chrono::system_clock::time_point start_time;
     std::vector<std::complex<float>> samples;
 };
 
 
 
-/// @brief Carrierdetection inherits from threaded BaseProcessor
-///        ongoing in function process()
-class CarrierDetection : public BaseProcessor {
+/// @brief Carrierdetection inherits from threaded BasicProcessor, consumes the frames of
+///        a shared StftProcessor in function process()
+class CarrierDetection : public BasicProcessor<StftFrame> {
 
 public:
     ///@brief
-    /// @param psd_leng determines the fft_leng
-    /// @param psd_avg amount of overlayed psds for calculating mean
+    /// @param psd_avg time constant of the exponential psd average [frames]
     /// @param threshold_db peak over sourounding area
-    CarrierDetection( uint64_t psd_leng, uint64_t psd_avg, uint64_t threshold_db = 6.)
-        : _psd_leng( psd_leng), _psd_avg( psd_avg),  _threshold_db( threshold_db), _psd_cnt( 0){
-        _fft.setLeng( psd_leng);
+    /// @param out_path prefix of the extracted carrier files (i.e. a directory ending with '/')
+    CarrierDetection( uint64_t psd_avg, uint64_t threshold_db = 6.,
+                      const std::string &out_path = "")
+        : BasicProcessor<StftFrame>( 256, Overflow::DropOldest),
+          _psd_avg( psd_avg), _threshold_db( threshold_db),
+          _out_path( out_path), _next_frame( 0), _samp_rate( 0), _center_freq( 0), _extracted( 0),
+          _trigger_level( -std::numeric_limits<float>::infinity()),
+          _psd( 0, PsdAverage::Mode::Exponential, psd_avg) {
     }
-
-    // @brief add Data to internal buffer and starts detection
-    void dataIn( const std::vector<std::complex<float>> &input) {
-        _puff.push( input);
+    ~CarrierDetection() {
+        stop();
     }
 
     /// @brief return Peaks if exists
-    std::vector<Carrier> getPeaks() const { return _carriers;}
+    std::vector<Carrier> getPeaks() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return _carriers;
+    }
+
+    /// @brief Abtastrate und Mittenfrequenz fuer die Umrechnung bins -> Hz
+    void setSampleRate( double samp_rate) { _samp_rate = samp_rate;}
+    void setCenterFrequency( double center_freq) { _center_freq = center_freq;}
+
+    /// @brief Anzahl bisher in Dateien geschriebener Carrier
+    uint64_t getExtractedCount() const { return _extracted;}
+
+    /// @brief wird fuer jeden abgeschlossenen Carrier im Verarbeitungsthread aufgerufen,
+    ///        z.B. fuer Annotationen im laufenden Mitschnitt (Recorder::annotate())
+    void setFinishedCallback( const std::function<void( const Carrier &)> &func) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _finished = func;
+    }
+
+    /// @brief wird fuer jeden neu erkannten Carrier mit level_db >= level aufgerufen, z.B.
+    ///        als Trigger einer Aufnahme mit Vorlauf (TriggeredRecorder::trigger())
+    /// @param level Mindestpegel [dBFS], -inf: jeder neue Carrier
+    void setNewCarrierCallback( const std::function<void( const Carrier &)> &func,
+                                float level = -std::numeric_limits<float>::infinity()) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _new_carrier = func;
+        _trigger_level = level;
+    }
 
 private:
-    /// @brief  Processes data from _puff: windowin, psd based peak detection, consecutive
+    /// @brief  Processes one STFT frame: psd based peak detection, consecutive
     ///         channelizing via suiteable iffts
-    void process( const std::vector<std::complex<float>> &data) override {
-        // append to logical structure
-        _buffer.insert( _buffer.end(), data.begin(), data.end());
-
-        uint64_t buffer_consumed = 0; // increased at the bottom
-        while( _buffer.size() - buffer_consumed >= _fft.leng()) {
-            _win.vonHannWindow( _buffer.data() + buffer_consumed, _buffer_win.data(), _fft.leng());
-            _fft.fft(_buffer_win, _buffer_fft);
-            std::transform( std::execution::par_unseq, _buffer_fft.begin(),
-                            _buffer_fft.end(), _buffer_psd.begin(),
-                            []( const std::complex<float> &samp)
-                            { return std::norm( samp);});
-
-            std::vector<Peak> peaks;
-            findPeaks( _buffer_psd, peaks);
-#ifdef DEBUG
-            std::cerr << "Peaks found: " << peaks.size() << std::endl;
-#endif
-            // extract peaks as carriers
-            std::vector<Carrier> carriers;
-            carriers = ddcCarriers( _buffer_fft, peaks);
-
-            // set all current carriers to false for further notice
-            // handle inactive carriers later on
+    void process( const StftFrame &frame) override {
+        const uint64_t leng = frame.leng();
+        if( ! leng) return;
+        const std::complex<float> *spectrum = frame.spectrum->data();
+
+        // gemittelte psd in dBFS, einzelne Rauschspitzen fallen so nicht als Peak auf
+        _psd.push( frame);
+        _psd.get( _buffer_psd);
+
+        std::vector<Peak> peaks;
+        findPeaks( _buffer_psd, peaks, static_cast<float>( _threshold_db));
+        // extract peaks as carriers
+        std::vector<Carrier> carriers = ddcCarriers( spectrum, leng, frame.hop, frame.sample_index, peaks);
+
+        std::lock_guard<std::mutex> lock( _mutexer);
+        // verworfene Frames (Rueckstand, DropOldest): die Ausschnitte wuerden ueber die
+        // Luecke hinweg aneinandergehaengt, laufende Carrier enden deshalb davor
+        if( frame.index != _next_frame) {
             for( auto &carrier : _carriers)
                 carrier.active = false;
-            // check for previsous carriers in range and append them if match
-            for( auto &carrier : carriers)
-                checkForCarriersIdent( carrier);
-
-            // extract all inactive carriers to file and pop from queue
             extractFinishedCarriers();
-
-            // overlapped: step just a part of the fft size forward to prevent side effects
-            buffer_consumed += _overl_step;
         }
-        // discard all consumed samples
-        _buffer.erase( _buffer.begin(), _buffer.begin() + buffer_consumed);
+        _next_frame = frame.index + 1;
+        // set all current carriers to false for further notice
+        // handle inactive carriers later on
+        for( auto &carrier : _carriers)
+            carrier.active = false;
+        // check for previsous carriers in range and append them if match
+        for( auto &carrier : carriers)
+            checkForCarriersIdent( carrier);
+
+        // extract all inactive carriers to file and pop from queue
+        extractFinishedCarriers();
     }
 
 
-    /// @brief Check if peak-pos and peak-bw allready exists
-    void checkForCarriersIdent( const Carrier signal) {
+    /// @brief Check if a carrier at the peak position allready exists: the centres must lie
+    ///        within each others band (at least +-1 bin)
+    void checkForCarriersIdent( const Carrier &signal) {
+        const double leng = static_cast<double>( _buffer_psd.size());
         for( auto &carrier : _carriers) {
-            if(    signal.rel_band_width < carrier.rel_band_width * 1.1
-                && signal.rel_band_width < carrier.rel_band_width * .9) {
-
-                std::cerr << signal.rel_band_width << " :: " << carrier.rel_band_width << std::endl;
-
-                if(    signal.rel_freq < carrier.rel_freq + carrier.rel_band_width * .1
-                    && signal.rel_freq > carrier.rel_freq - carrier.rel_band_width * .1) {
-                    std::cerr << "ident true for: "<< signal.rel_freq << " :: " << carrier.rel_freq << std::endl;
-
-                    if( carrier.active)
-                        std::cerr << "carrier already active, possible overlap" << std::endl;
-                    carrier.active = true;
-                    // already existing carrier - only add samples
-                    carrier.samples.insert( carrier.samples.end(),
-                                   signal.samples.begin(), signal.samples.end());
-                    std::cerr << "found corresponding carrier !" << std::endl;
-                    return;
-                }
-
-                else if(    signal.rel_freq < carrier.rel_freq + carrier.rel_band_width * .5
-                         && signal.rel_freq > carrier.rel_freq - carrier.rel_band_width * .5)
-                    std::cerr << "!!! Something curious carrier on carrier detection" << std::endl;
-            }
-
+            const double tolerance = std::max( 1., 0.5 * std::max( carrier.rel_band_width, signal.rel_band_width));
+            // Abstand zyklisch, Carrier koennen ueber DC liegen
+            const double dist = std::abs( signal.rel_freq - carrier.rel_freq);
+            if( std::min( dist, leng - dist) > tolerance)
+                continue;
+            // schon in diesem Frame fortgesetzt, moegliche Ueberlappung
+            if( carrier.active)
+                continue;
+            carrier.active = true;
+            // already existing carrier - only add samples
+            carrier.samples.insert( carrier.samples.end(),
+                                    signal.samples.begin(), signal.samples.end());
+            carrier.sample_count = signal.sample_start + signal.sample_count - carrier.sample_start;
+            carrier.level_db = std::max( carrier.level_db, signal.level_db);
+            return;
         }
+        // new carrier
+        _carriers.push_back( signal);
+        _carriers.back().active = true;
+        if( _new_carrier && signal.level_db >= _trigger_level)
+            _new_carrier( signal);
     }
 
     /// @brief Direct Down Convert Carriers: extract time signal from given frequency vector,
     /// therefor estimate extraction fft_leng and low-pass filter through detected peaks
     /// @param input fft vector
+    /// @param fft_leng bins of input
+    /// @param hop stft step between two frames, only the new part of each frame is kept
+    /// @param sample_index stream position of the frame
     /// @param peaks to corresponding frequency vector
     /// @return Carriers same leng as peaks
     std::vector<Carrier>
-    ddcCarriers( std::vector<std::complex<float>> &input,
-                     const std::vector<Peak> &peaks, uint64_t rel_invers_overlap = 4) {
+    ddcCarriers( const std::complex<float> *input, uint64_t fft_leng, uint64_t hop, uint64_t sample_index,
+                 const std::vector<Peak> &peaks, uint64_t rel_invers_overlap = 4) {
         std::vector<Carrier> carriers;
         carriers.reserve( peaks.size());
-        const uint64_t fft_leng = input.size();
         for( const Peak &pk : peaks) {
 			Carrier car;
-            // car.rel_freq =
-            car.rel_band_width = static_cast<double>( pk.pos_right - pk.pos_left) / static_cast<double>( fft_leng);
-            car.rel_freq = static_cast<double>( pk.pos_left) + car.rel_band_width * 0.5;
+            car.active = true;
+            car.rel_band_width = static_cast<double>( pk.pos_right - pk.pos_left);
+            car.level_db = pk.magnitude;
+            // Peaks ueber DC haben pos_right >= fft_leng
+            car.rel_freq = std::fmod( static_cast<double>( pk.pos_left) + car.rel_band_width * 0.5,
+                                      static_cast<double>( fft_leng));
+            car.samp_rate = _samp_rate;
+            // bins -> Hz, bin 0 ist die Mittenfrequenz
+            const double bin_hz = _samp_rate / static_cast<double>( fft_leng);
+            const double rel_freq_signed = car.rel_freq < fft_leng / 2 ? car.rel_freq : car.rel_freq - fft_leng;
+            car.origin_freq = _center_freq + rel_freq_signed * bin_hz;
+            car.band_width = car.rel_band_width * bin_hz;
             car.start_time = std::chrono::system_clock::now();
+            // die behaltenen Abtastwerte stammen aus der Mitte des Frames
+            car.sample_start = sample_index + ( fft_leng - std::min( hop, fft_leng)) / 2;
+            car.sample_count = hop;
 
             // estimate extract_fft_leng of necessary extraction window with the following requirements
             // - rel_inverse_overlap is divider,
-            uint64_t extract_fft_leng = Tools::nextPow2( std::ceil( static_cast<double>( fft_leng) * 1.25 * car.band_width * 2.));
-            while( extract_fft_leng < fft_leng && fft_leng % extract_fft_leng != 0 && fft_leng % rel_invers_overlap != 0) {
-                ++extract_fft_leng;
+            // nextPow2() liefert den Exponenten
+            uint64_t extract_fft_leng = uint64_t( 1) << Tools::nextPow2( std::ceil( 1.25 * car.rel_band_width * 2.));
+            extract_fft_leng = std::min( std::max<uint64_t>( extract_fft_leng, rel_invers_overlap), fft_leng);
+            car.samp_rate = _samp_rate * static_cast<double>( extract_fft_leng) / static_cast<double>( fft_leng);
+
+            // bins um den Carrier ausschneiden, Carriermitte auf bin 0 (zyklisch)
+			std::vector<std::complex<float>> chunk( extract_fft_leng);
+            const int64_t center = static_cast<int64_t>( std::llround( car.rel_freq));
+            const int64_t half = static_cast<int64_t>( extract_fft_leng / 2);
+            for( int64_t k = -half; k < static_cast<int64_t>( extract_fft_leng) - half; ++k) {
+                const int64_t src = ( ( center + k) % static_cast<int64_t>( fft_leng) + fft_leng) % fft_leng;
+                const int64_t dst = ( k + static_cast<int64_t>( extract_fft_leng)) % static_cast<int64_t>( extract_fft_leng);
+                chunk[ dst] = input[ src];
             }
-            double rel_extraction_samp_rate = static_cast<double>( extract_fft_leng) / static_cast<double>( fft_leng);
-
-            //            std::iterator<uint64_t> beg = carrier.rel_freq * input.size() - std::ceil( .5 * carrier)
-            
-			// try to avoid next two line by indexing directly
-			std::vector<std::complex<float>> time_chunk( extract_fft_leng);
-			//std::copy( input.begin() + pk.pos_left, input.begin() + pk.pos.right, frequency_chunk.begin());
-			FFT fft( extract_fft_leng);
-            fft.fft( input.data() + pk.pos_left, time_chunk.data());
-			car.samples.insert( car.samples.end(), time_chunk.begin(), time_chunk.end());
+            // Plan kommt aus FFTPlanCache, die Transformation laeuft in-place
+            _extract_fft.setLeng( extract_fft_leng);
+            _extract_fft.ifft( chunk.data(), chunk.data());
+            // ueberlappende Frames: nur die mittleren hop Abtastwerte (dezimiert) sind neu
+            const uint64_t keep = std::clamp<uint64_t>( extract_fft_leng * hop / fft_leng, 1, extract_fft_leng);
+            const uint64_t first = ( extract_fft_leng - keep) / 2;
+			car.samples.assign( chunk.begin() + first, chunk.begin() + first + keep);
             carriers.push_back( car);
         }
 		
 		return carriers;
     }
 
-    /// @brief Write out finished carriers to predefined filepath and erase it
+    /// @brief Kanalfilter ueber den ganzen Ausschnitt: der Bin-Schnitt in ddcCarriers laesst
+    ///        neben dem Carrier rund 25 % Rand je Seite stehen und springt an den Grenzen
+    ///        der Frames. Ein Kaiser-Tiefpass auf die belegte Bandbreite (plus ein halber Bin
+    ///        Versatz der Mitte) entfernt beides; die Gruppenlaufzeit wird ausgeglichen, die
+    ///        Laenge bleibt.
+    void filterCarrier( Carrier &carrier, double atten_db = 60.) {
+        if( carrier.samples.empty() || carrier.samp_rate <= 0. || carrier.rel_band_width <= 0.)
+            return;
+        const double bin_hz = carrier.band_width / carrier.rel_band_width;
+        const double passband = 0.5 * ( carrier.band_width + bin_hz) / carrier.samp_rate;
+        // Carrier fuellt den Ausschnitt, nichts zu entfernen
+        if( passband > 0.4) return;
+        _carrier_fir.setTaps( Fir::lowPass( passband, 0.45 - passband, atten_db));
+        const uint64_t delay = static_cast<uint64_t>( _carrier_fir.delay());
+        std::vector<std::complex<float>> filtered;
+        filtered.reserve( carrier.samples.size() + delay);
+        _carrier_fir.process( carrier.samples, filtered);
+        const std::vector<std::complex<float>> tail( delay, std::complex<float>( 0, 0));
+        _carrier_fir.process( tail, filtered);
+        carrier.samples.assign( filtered.begin() + delay, filtered.end());
+    }
+
+    /// @brief Write out finished carriers to predefined filepath and erase it. Each
+    ///        carrier is a SigMF pair "<time>_<freq>Hz_<sample_start>.sigmf-data/-meta"
+    ///        (cf32_le), the stream position keeps extracts of the same second apart
     void extractFinishedCarriers( ) {
         for( auto carrier =_carriers.begin(); carrier != _carriers.end(); ) {
             if( carrier->active)
                 carrier++;
             else {
-                std::ofstream out( _out_path + std::format("{:%Y_%m_%d_%H_%M_%S}", carrier->start_time) , std::ios::binary);
+                filterCarrier( *carrier);
+                const std::time_t start = std::chrono::system_clock::to_time_t( carrier->start_time);
+                std::tm tm_start{};
+                gmtime_r( &start, &tm_start);
+                std::ostringstream name;
+                name << _out_path << std::put_time( &tm_start, "%Y_%m_%d_%H_%M_%S")
+                     << "_" << static_cast<int64_t>( carrier->origin_freq) << "Hz_" << carrier->sample_start;
+                std::ofstream out( name.str() + ".sigmf-data", std::ios::binary);
                 out.write( reinterpret_cast< char*>( carrier->samples.data()), carrier->samples.size() * sizeof( std::complex<float>));
                 out.close();
-                _carriers.erase( carrier);
+                writeCarrierMeta( *carrier, name.str() + ".sigmf-meta");
+                if( _finished)
+                    _finished( *carrier);
+                ++_extracted;
+                carrier = _carriers.erase( carrier);
             }
         }
     }
 
-    uint64_t _psd_cnt, _psd_leng, _psd_avg, _threshold_db, _rel_inv_overl,
-        _overl_step;
+    /// @brief SigMF-Beschreibung eines Carrier-Ausschnitts: Mittenfrequenz, dezimierte
+    ///        Abtastrate und eine Annotation ueber die belegte Bandbreite
+    void writeCarrierMeta( const Carrier &carrier, const std::string &path) {
+        SigMF::Meta meta;
+        meta.datatype = "cf32_le";
+        meta.sample_rate = carrier.samp_rate;
+        std::ostringstream desc;
+        desc << "Carrier, Quelle ab Abtastwert " << carrier.sample_start << " ("
+             << carrier.sample_count << " Abtastwerte bei " << _samp_rate << " Sps)";
+        meta.description = desc.str();
+
+        SigMF::Capture cap;
+        cap.frequency = carrier.origin_freq;
+        cap.datetime = carrier.start_time;
+        meta.captures.push_back( cap);
+
+        SigMF::Annotation anno;
+        anno.sample_count = carrier.samples.size();
+        anno.freq_lower_edge = carrier.origin_freq - carrier.band_width / 2;
+        anno.freq_upper_edge = carrier.origin_freq + carrier.band_width / 2;
+        anno.label = "carrier";
+        meta.annotations.push_back( anno);
+        meta.write( path);
+    }
+
+    uint64_t _psd_avg, _threshold_db;
 
     std::vector<uint64_t> _channel_id;
-    std::vector<std::complex<float>> _buffer, _buffer_win, _buffer_fft;
     std::vector<float> _buffer_psd;
     std::vector<struct Carrier> _carriers;
     std::atomic_bool _is_processing;
-    ConditionSafeQueue<std::complex<float>> _puff;
     std::string _out_path;
-
-    FFT _fft;
-    FFTWindow _win;
-    LowPassFilter _lpf;
+    uint64_t _next_frame;       // erwarteter StftFrame::index
+    std::atomic<double> _samp_rate, _center_freq;
+    std::atomic<uint64_t> _extracted;
+    std::mutex _mutexer;
+    std::function<void( const Carrier &)> _finished, _new_carrier;
+    float _trigger_level;
+
+    PsdAverage _psd;
+    FFT _extract_fft;
+    FirFilter<float> _carrier_fir;
 
 };
 
@@ -141,9 +141,6 @@ public:
 		}
 
         if( _queue.empty() ||_reject_input) return false;
-        if( ! _empty_condition.wait_for( lock, std::chrono::milliseconds( 1),
-                                        [ this] {return ! _queue.empty();}))
-            return false;
 		// Falls output==leer, dann SCHNELLER Speicherwechsl
         if(output.empty())
             std::swap(output, _queue.front());
@@ -188,4 +185,6 @@ public:
     }
 };
 
+
+
 #endif // QUEUE_HPP
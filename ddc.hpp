@@ -0,0 +1,169 @@
+#ifndef DDC_HPP
+#define DDC_HPP
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+
+#include "sampleblock.hpp"
+#include "baseprocessor.hpp"
+#include "stft.hpp"
+#include "firfilter.hpp"
+
+
+/// @brief Digital Down Converter: mischt das Band um rel_freq (Anteil der Abtastrate,
+///        -0.5 .. 0.5) nach 0 Hz, filtert mit einem Kaiser-Tiefpass und dezimiert um
+///        decimation. Gerechnet werden nur die behaltenen Ausgangswerte (polyphas), der
+///        Aufwand je Eingangswert ist damit etwa taps / decimation.
+class Ddc {
+    double _rel_freq;
+    uint64_t _decimation;
+    double _atten_db;
+
+    std::complex<double> _phasor, _step;
+    std::vector<float> _taps;
+    std::vector<std::complex<float>> _history;   // taps - 1 alte plus neue, gemischte Werte
+    uint64_t _next;                             // Index des naechsten Ausgangswerts in _history
+
+    /// @brief Durchlass bis 0.4 / decimation, Sperrbereich ab 0.6 / decimation: alles, was
+    ///        beim Dezimieren nach +-0.4 / decimation faltet, ist um atten_db gedaempft. Nur
+    ///        der aeussere Rand des Ausgangsbandes (0.4 .. 0.5 / decimation) liegt in der
+    ///        Flanke. Die Laenge waechst mit der Dezimation, etwa 22 * decimation bei 70 dB.
+    void designTaps() {
+        const double rate = 1. / static_cast<double>( _decimation);
+        _taps = _decimation == 1 ? std::vector<float>{ 1.f} : Fir::lowPass( 0.4 * rate, 0.2 * rate, _atten_db);
+    }
+
+public:
+    /// @param atten_db Sperrdaempfung des Tiefpasses gegen Aliasing
+    Ddc( double rel_freq = 0., uint64_t decimation = 1, double atten_db = 70.)
+        : _rel_freq( 0), _decimation( 1), _atten_db( atten_db) {
+        setFrequency( rel_freq);
+        setDecimation( decimation);
+    }
+
+    /// @brief Mittenfrequenz des Bandes relativ zur Abtastrate
+    void setFrequency( double rel_freq) {
+        _rel_freq = rel_freq;
+        _step = std::polar( 1., -2. * M_PI * rel_freq);
+    }
+    /// @brief neue Dezimation, verwirft den Filterzustand
+    void setDecimation( uint64_t decimation) {
+        if( ! decimation) throw std::invalid_argument( "FEHLER Ddc::setDecimation(): decimation == 0");
+        _decimation = decimation;
+        designTaps();
+        reset();
+    }
+    void reset() {
+        _phasor = { 1., 0.};
+        _history.assign( _taps.size() - 1, std::complex<float>( 0, 0));
+        _next = _taps.size() - 1;
+    }
+
+    double frequency() const { return _rel_freq;}
+    uint64_t decimation() const { return _decimation;}
+    uint64_t taps() const { return _taps.size();}
+
+    /// @brief mischt, filtert und dezimiert input, haengt die Ergebnisse an output an
+    void process( const std::complex<float> *input, uint64_t leng, std::vector<std::complex<float>> &output) {
+        const uint64_t keep = _taps.size() - 1;
+        const uint64_t offset = _history.size();
+        _history.resize( offset + leng);
+
+        // mischen, der Drehzeiger in double gegen Phasendrift
+        std::complex<float> *mixed = _history.data() + offset;
+        for( uint64_t w = 0; w < leng; ++w) {
+            mixed[ w] = input[ w] * std::complex<float>( _phasor);
+            _phasor *= _step;
+        }
+        _phasor /= std::abs( _phasor);
+
+        // nur jeden decimation-ten Wert filtern
+        const float *taps = _taps.data();
+        const uint64_t ntaps = _taps.size();
+        for( ; _next < _history.size(); _next += _decimation) {
+            const std::complex<float> *x = _history.data() + _next + 1 - ntaps;
+            float re = 0.f, im = 0.f;
+            for( uint64_t k = 0; k < ntaps; ++k) {
+                re += taps[ k] * x[ k].real();
+                im += taps[ k] * x[ k].imag();
+            }
+            output.emplace_back( re, im);
+        }
+
+        // die letzten taps - 1 Werte fuer den naechsten Block behalten
+        const uint64_t drop = _history.size() - keep;
+        std::copy( _history.end() - keep, _history.end(), _history.begin());
+        _history.resize( keep);
+        _next -= drop;
+    }
+};
+
+
+/// @brief Knoten fuer den Zoom: schneidet das Band [center - span / 2, center + span / 2]
+///        (relativ zur Abtastrate) per Ddc aus und rechnet darauf eine lange STFT. Die
+///        Aufloesung steigt um die Dezimation, der Aufwand der FFT sinkt mit der Bandbreite.
+///        Ohne Zoom (span >= 1) verwirft der Knoten die Bloecke.
+class ZoomProcessor : public BaseProcessor {
+    Ddc _ddc;
+    Stft _stft;
+    std::vector<std::complex<float>> _buf;
+
+    std::mutex _mutexer;
+    double _pending_center, _pending_span;
+    std::atomic_bool _changed;
+    bool _active;
+
+    void process( const SampleBlockPtr<std::complex<float>> &input) override {
+        if( _changed.exchange( false)) {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            _active = _pending_span < 1.;
+            if( _active) {
+                _ddc.setFrequency( _pending_center);
+                _ddc.setDecimation( decimationFor( _pending_span));
+            }
+            _stft.reset();
+        }
+        if( ! _active) return;
+
+        _buf.clear();
+        _ddc.process( input->data(), input->size(), _buf);
+        _stft.push( _buf.data(), _buf.size());
+    }
+
+public:
+    /// @param leng FFT-Laenge im Zoomband
+    ZoomProcessor( uint64_t leng = 4096, uint64_t hop = 1024)
+        : BaseProcessor( 256, Overflow::DropOldest), _stft( leng, hop, Stft::Window::VonHann, false),
+          _pending_center( 0), _pending_span( 1), _changed( false), _active( false) {}
+    ~ZoomProcessor() {
+        stop();
+    }
+
+    /// @brief groesste Dezimation, deren aliasfreier Teil (0.8 / decimation, siehe Ddc)
+    ///        span noch ueberdeckt
+    static uint64_t decimationFor( double span) {
+        if( span <= 0.) throw std::invalid_argument( "FEHLER ZoomProcessor: span <= 0");
+        return std::max<uint64_t>( 1, static_cast<uint64_t>( std::floor( 0.8 / span)));
+    }
+
+    /// @brief waehlt das Zoomband, wird im Verarbeitungsthread uebernommen
+    /// @param center Mitte relativ zur Abtastrate (-0.5 .. 0.5)
+    /// @param span Breite relativ zur Abtastrate, >= 1: kein Zoom
+    /// @return tatsaechlich dargestellte Breite 1 / decimation, davon aliasfrei 0.8 / decimation
+    double setBand( double center, double span) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _pending_center = center;
+        _pending_span = span;
+        _changed = true;
+        return span < 1. ? 1. / static_cast<double>( decimationFor( span)) : 1.;
+    }
+
+    OutputPort<StftFrame>& output() { return _stft.output();}
+};
+
+#endif // DDC_HPP
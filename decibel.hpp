@@ -0,0 +1,304 @@
+#ifndef DECIBEL_HPP
+#define DECIBEL_HPP
+
+#include <complex>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#if defined( __x86_64__) || defined( __i386__)
+#include <immintrin.h>
+#endif
+
+#include "simd.hpp"
+
+
+/// @brief Umrechnung Leistung -> dB in einem Durchlauf:
+///        out = clamp( 10 * log10( |x|^2) + offset_db, floor_db, ceil_db)
+///        bzw. fuer reelle Leistungswerte p: clamp( 10 * log10( p) + offset_db, ...)
+///        Der Logarithmus wird aus Exponent und Mantisse des floats gebildet:
+///        p = 2^e * m, m in [sqrt(1/2), sqrt(2)), log2( m) = 2 / ln2 * atanh( t),
+///        t = ( m - 1) / ( m + 1), |t| < 0.172. Die atanh-Reihe wird nach terms Gliedern
+///        abgebrochen, der Fehler folgt aus maxError( terms).
+///        Der Vektor-Kernel wird zur Laufzeit gewaehlt (AVX-512, AVX2, SSE2). Skalar und fuer
+///        die Reste der Vektor-Kernel rechnet die libm, die ist dort schneller als die Reihe.
+namespace Decibel {
+
+/// @brief Koeffizienten des fusionierten Kernels
+struct Coefficients {
+    float offset_db = 0.f;      // 10 * log10( Skalierung der Leistung)
+    float floor_db  = -300.f;   // auch fuer 0, Denormale und NaN
+    float ceil_db   = 300.f;
+    int terms       = 2;        // Glieder der atanh-Reihe, 1 .. 4
+};
+
+/// @brief groesster Fehler [dB] bei terms Gliedern der Reihe
+/// @param level_db groesster Betrag der Ergebnisse: die float-Rechnung kostet bis zu einer
+///        Stelle ( epsilon) davon, bei 120 dB 1.4e-5 dB und damit mehr als die Reihe ab 3 Gliedern
+inline double
+maxError( int terms, double level_db = 0.) {
+    terms = std::clamp( terms, 1, 4);
+    const double t = ( std::sqrt( 2.) - 1.) / ( std::sqrt( 2.) + 1.);
+    const double t2 = t * t;
+    // Restglied: sum_{k >= terms} t^(2k+1) / (2k+1) <= t^(2 terms + 1) / (2 terms + 1) / (1 - t^2)
+    const double rest = std::pow( t, 2 * terms + 1) / ( 2 * terms + 1) / ( 1. - t2);
+    // 10 * log10( m) = 20 / ln10 * atanh( t); Rundung von e * DB_PER_OCTAVE und des Ergebnisses
+    return 20. / std::log( 10.) * rest + std::abs( level_db) * std::numeric_limits<float>::epsilon();
+}
+
+/// @brief kleinste Gliederzahl, die den Fehler max_error_db einhaelt
+inline int
+termsFor( double max_error_db) {
+    for( int terms = 1; terms < 4; ++terms)
+        if( maxError( terms) <= max_error_db) return terms;
+    return 4;
+}
+
+namespace detail {
+
+// 10 * log10( 2) und 2 / ln( 2) * 10 * log10( 2) = 20 / ln( 10)
+constexpr float DB_PER_OCTAVE = 3.01029995664f;
+constexpr float DB_ATANH      = 8.68588963807f;
+constexpr float SQRT2         = 1.41421356237f;
+// 1 / ( 2k + 1), k = 1 .. 3
+constexpr float SERIES[ 4] = { 1.f, 1.f / 3.f, 1.f / 5.f, 1.f / 7.f};
+
+/// @brief skalar ueber die libm: ohne Vektorregister ist std::log10 schneller als die Reihe
+///        und exakt, terms spielt hier keine Rolle
+inline float
+powerToDb( float power, const Coefficients &co) {
+    // Denormale, 0 und NaN auf die kleinste normale Zahl
+    power = power >= std::numeric_limits<float>::min() ? power : std::numeric_limits<float>::min();
+    return std::clamp( 10.f * std::log10( power) + co.offset_db, co.floor_db, co.ceil_db);
+}
+
+inline void
+normScalar( const std::complex<float> *input, float *output, uint64_t leng, const Coefficients &co) {
+    for( uint64_t w = 0; w < leng; ++w)
+        output[ w] = powerToDb( std::norm( input[ w]), co);
+}
+
+inline void
+powerScalar( const float *input, float *output, uint64_t leng, const Coefficients &co) {
+    for( uint64_t w = 0; w < leng; ++w)
+        output[ w] = powerToDb( input[ w], co);
+}
+
+#if defined( __x86_64__) || defined( __i386__)
+
+__attribute__(( target( "sse2"))) inline __m128
+logSSE2( __m128 power, const Coefficients &co) {
+    power = _mm_max_ps( power, _mm_set1_ps( std::numeric_limits<float>::min()));
+    const __m128i bits = _mm_castps_si128( power);
+    __m128 e = _mm_cvtepi32_ps( _mm_sub_epi32( _mm_srli_epi32( bits, 23), _mm_set1_epi32( 127)));
+    __m128 m = _mm_castsi128_ps( _mm_or_si128( _mm_and_si128( bits, _mm_set1_epi32( 0x007FFFFF)),
+                                               _mm_set1_epi32( 0x3F800000)));
+    const __m128 big = _mm_cmpgt_ps( m, _mm_set1_ps( SQRT2));
+    m = _mm_sub_ps( m, _mm_and_ps( big, _mm_mul_ps( m, _mm_set1_ps( .5f))));
+    e = _mm_add_ps( e, _mm_and_ps( big, _mm_set1_ps( 1.f)));
+
+    const __m128 one = _mm_set1_ps( 1.f);
+    const __m128 t = _mm_div_ps( _mm_sub_ps( m, one), _mm_add_ps( m, one));
+    const __m128 t2 = _mm_mul_ps( t, t);
+    __m128 s = _mm_set1_ps( SERIES[ co.terms - 1]);
+    for( int k = co.terms - 2; k >= 0; --k)
+        s = _mm_add_ps( _mm_mul_ps( s, t2), _mm_set1_ps( SERIES[ k]));
+
+    __m128 db = _mm_add_ps( _mm_mul_ps( e, _mm_set1_ps( DB_PER_OCTAVE)),
+                            _mm_mul_ps( _mm_mul_ps( t, s), _mm_set1_ps( DB_ATANH)));
+    db = _mm_add_ps( db, _mm_set1_ps( co.offset_db));
+    return _mm_min_ps( _mm_max_ps( db, _mm_set1_ps( co.floor_db)), _mm_set1_ps( co.ceil_db));
+}
+
+__attribute__(( target( "sse2"))) inline void
+normSSE2( const std::complex<float> *input, float *output, uint64_t leng, const Coefficients &co) {
+    uint64_t w = 0;
+    for( ; w + 4 <= leng; w += 4) {
+        const float *in = reinterpret_cast<const float*>( input + w);
+        __m128 a = _mm_loadu_ps( in);           // [r0 i0 r1 i1]
+        __m128 b = _mm_loadu_ps( in + 4);       // [r2 i2 r3 i3]
+        a = _mm_mul_ps( a, a);
+        b = _mm_mul_ps( b, b);
+        const __m128 power = _mm_add_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 2, 0, 2, 0)),
+                                         _mm_shuffle_ps( a, b, _MM_SHUFFLE( 3, 1, 3, 1)));
+        _mm_storeu_ps( output + w, logSSE2( power, co));
+    }
+    normScalar( input + w, output + w, leng - w, co);
+}
+
+__attribute__(( target( "sse2"))) inline void
+powerSSE2( const float *input, float *output, uint64_t leng, const Coefficients &co) {
+    uint64_t w = 0;
+    for( ; w + 4 <= leng; w += 4)
+        _mm_storeu_ps( output + w, logSSE2( _mm_loadu_ps( input + w), co));
+    powerScalar( input + w, output + w, leng - w, co);
+}
+
+__attribute__(( target( "avx2,fma"))) inline __m256
+logAVX2( __m256 power, const Coefficients &co) {
+    power = _mm256_max_ps( power, _mm256_set1_ps( std::numeric_limits<float>::min()));
+    const __m256i bits = _mm256_castps_si256( power);
+    __m256 e = _mm256_cvtepi32_ps( _mm256_sub_epi32( _mm256_srli_epi32( bits, 23), _mm256_set1_epi32( 127)));
+    __m256 m = _mm256_castsi256_ps( _mm256_or_si256( _mm256_and_si256( bits, _mm256_set1_epi32( 0x007FFFFF)),
+                                                     _mm256_set1_epi32( 0x3F800000)));
+    const __m256 big = _mm256_cmp_ps( m, _mm256_set1_ps( SQRT2), _CMP_GT_OQ);
+    m = _mm256_blendv_ps( m, _mm256_mul_ps( m, _mm256_set1_ps( .5f)), big);
+    e = _mm256_add_ps( e, _mm256_and_ps( big, _mm256_set1_ps( 1.f)));
+
+    const __m256 one = _mm256_set1_ps( 1.f);
+    const __m256 t = _mm256_div_ps( _mm256_sub_ps( m, one), _mm256_add_ps( m, one));
+    const __m256 t2 = _mm256_mul_ps( t, t);
+    __m256 s = _mm256_set1_ps( SERIES[ co.terms - 1]);
+    for( int k = co.terms - 2; k >= 0; --k)
+        s = _mm256_fmadd_ps( s, t2, _mm256_set1_ps( SERIES[ k]));
+
+    __m256 db = _mm256_fmadd_ps( e, _mm256_set1_ps( DB_PER_OCTAVE), _mm256_set1_ps( co.offset_db));
+    db = _mm256_fmadd_ps( _mm256_mul_ps( t, s), _mm256_set1_ps( DB_ATANH), db);
+    return _mm256_min_ps( _mm256_max_ps( db, _mm256_set1_ps( co.floor_db)), _mm256_set1_ps( co.ceil_db));
+}
+
+__attribute__(( target( "avx2,fma"))) inline void
+normAVX2( const std::complex<float> *input, float *output, uint64_t leng, const Coefficients &co) {
+    uint64_t w = 0;
+    for( ; w + 8 <= leng; w += 8) {
+        const float *in = reinterpret_cast<const float*>( input + w);
+        __m256 a = _mm256_loadu_ps( in);        // [r0 i0 r1 i1 | r2 i2 r3 i3]
+        __m256 b = _mm256_loadu_ps( in + 8);    // [r4 i4 r5 i5 | r6 i6 r7 i7]
+        a = _mm256_mul_ps( a, a);
+        b = _mm256_mul_ps( b, b);
+        // je Lane: [p0 p1 p4 p5 | p2 p3 p6 p7] -> 64 bit Paare in Reihenfolge bringen
+        __m256 power = _mm256_add_ps( _mm256_shuffle_ps( a, b, _MM_SHUFFLE( 2, 0, 2, 0)),
+                                      _mm256_shuffle_ps( a, b, _MM_SHUFFLE( 3, 1, 3, 1)));
+        power = _mm256_castpd_ps( _mm256_permute4x64_pd( _mm256_castps_pd( power), _MM_SHUFFLE( 3, 1, 2, 0)));
+        _mm256_storeu_ps( output + w, logAVX2( power, co));
+    }
+    normScalar( input + w, output + w, leng - w, co);
+}
+
+__attribute__(( target( "avx2,fma"))) inline void
+powerAVX2( const float *input, float *output, uint64_t leng, const Coefficients &co) {
+    uint64_t w = 0;
+    for( ; w + 8 <= leng; w += 8)
+        _mm256_storeu_ps( output + w, logAVX2( _mm256_loadu_ps( input + w), co));
+    powerScalar( input + w, output + w, leng - w, co);
+}
+
+__attribute__(( target( "avx512f"))) inline __m512
+logAVX512( __m512 power, const Coefficients &co) {
+    power = _mm512_max_ps( power, _mm512_set1_ps( std::numeric_limits<float>::min()));
+    // Exponent und Mantisse liefert AVX-512 direkt, die Mantisse in [1, 2)
+    __m512 e = _mm512_getexp_ps( power);
+    __m512 m = _mm512_getmant_ps( power, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+    const __mmask16 big = _mm512_cmp_ps_mask( m, _mm512_set1_ps( SQRT2), _CMP_GT_OQ);
+    m = _mm512_mask_mul_ps( m, big, m, _mm512_set1_ps( .5f));
+    e = _mm512_mask_add_ps( e, big, e, _mm512_set1_ps( 1.f));
+
+    const __m512 one = _mm512_set1_ps( 1.f);
+    const __m512 t = _mm512_div_ps( _mm512_sub_ps( m, one), _mm512_add_ps( m, one));
+    const __m512 t2 = _mm512_mul_ps( t, t);
+    __m512 s = _mm512_set1_ps( SERIES[ co.terms - 1]);
+    for( int k = co.terms - 2; k >= 0; --k)
+        s = _mm512_fmadd_ps( s, t2, _mm512_set1_ps( SERIES[ k]));
+
+    __m512 db = _mm512_fmadd_ps( e, _mm512_set1_ps( DB_PER_OCTAVE), _mm512_set1_ps( co.offset_db));
+    db = _mm512_fmadd_ps( _mm512_mul_ps( t, s), _mm512_set1_ps( DB_ATANH), db);
+    return _mm512_min_ps( _mm512_max_ps( db, _mm512_set1_ps( co.floor_db)), _mm512_set1_ps( co.ceil_db));
+}
+
+__attribute__(( target( "avx512f"))) inline void
+normAVX512( const std::complex<float> *input, float *output, uint64_t leng, const Coefficients &co) {
+    const __m512i even = _mm512_setr_epi32( 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i odd  = _mm512_setr_epi32( 1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    uint64_t w = 0;
+    for( ; w + 16 <= leng; w += 16) {
+        const float *in = reinterpret_cast<const float*>( input + w);
+        __m512 a = _mm512_loadu_ps( in);
+        __m512 b = _mm512_loadu_ps( in + 16);
+        a = _mm512_mul_ps( a, a);
+        b = _mm512_mul_ps( b, b);
+        const __m512 power = _mm512_add_ps( _mm512_permutex2var_ps( a, even, b),
+                                            _mm512_permutex2var_ps( a, odd, b));
+        _mm512_storeu_ps( output + w, logAVX512( power, co));
+    }
+    normScalar( input + w, output + w, leng - w, co);
+}
+
+__attribute__(( target( "avx512f"))) inline void
+powerAVX512( const float *input, float *output, uint64_t leng, const Coefficients &co) {
+    uint64_t w = 0;
+    for( ; w + 16 <= leng; w += 16)
+        _mm512_storeu_ps( output + w, logAVX512( _mm512_loadu_ps( input + w), co));
+    powerScalar( input + w, output + w, leng - w, co);
+}
+
+#endif
+
+}
+
+
+/// @brief 10 * log10( |x|^2) + offset_db mit Kernelwahl zur Laufzeit
+inline void
+fromNorm( const std::complex<float> *input, float *output, uint64_t leng, Coefficients co = {}) {
+    co.terms = std::clamp( co.terms, 1, 4);
+#if defined( __x86_64__) || defined( __i386__)
+    switch( Simd::level()) {
+    case Simd::Level::AVX512: detail::normAVX512( input, output, leng, co); return;
+    case Simd::Level::AVX2:   detail::normAVX2( input, output, leng, co); return;
+    case Simd::Level::SSE2:   detail::normSSE2( input, output, leng, co); return;
+    default: break;
+    }
+#endif
+    detail::normScalar( input, output, leng, co);
+}
+
+/// @brief 10 * log10( p) + offset_db mit Kernelwahl zur Laufzeit, input == output erlaubt
+inline void
+fromPower( const float *input, float *output, uint64_t leng, Coefficients co = {}) {
+    co.terms = std::clamp( co.terms, 1, 4);
+#if defined( __x86_64__) || defined( __i386__)
+    switch( Simd::level()) {
+    case Simd::Level::AVX512: detail::powerAVX512( input, output, leng, co); return;
+    case Simd::Level::AVX2:   detail::powerAVX2( input, output, leng, co); return;
+    case Simd::Level::SSE2:   detail::powerSSE2( input, output, leng, co); return;
+    default: break;
+    }
+#endif
+    detail::powerScalar( input, output, leng, co);
+}
+
+}
+
+
+/// @brief Haelt Skalierung, Wertebereich und Genauigkeit eines Spektralpfades
+class DbConverter {
+    Decibel::Coefficients _co;
+
+public:
+    /// @param max_error_db zulaessiger Fehler gegenueber 10 * log10()
+    DbConverter( double max_error_db = .01) {
+        setAccuracy( max_error_db);
+    }
+
+    /// @brief Leistung vor dem Logarithmus mit scale multiplizieren (linear)
+    void setScale( double scale) { _co.offset_db = static_cast<float>( 10. * std::log10( scale));}
+    void setOffset( float offset_db) { _co.offset_db = offset_db;}
+    /// @brief Ausgabe auf [floor_db, ceil_db] begrenzen
+    void setRange( float floor_db, float ceil_db) {
+        _co.floor_db = floor_db;
+        _co.ceil_db = ceil_db;
+    }
+    void setAccuracy( double max_error_db) { _co.terms = Decibel::termsFor( max_error_db);}
+    double getAccuracy() const { return Decibel::maxError( _co.terms);}
+
+    const Decibel::Coefficients& coefficients() const { return _co;}
+
+    void fromNorm( const std::complex<float> *input, float *output, uint64_t leng) const {
+        Decibel::fromNorm( input, output, leng, _co);
+    }
+    void fromPower( const float *input, float *output, uint64_t leng) const {
+        Decibel::fromPower( input, output, leng, _co);
+    }
+};
+
+#endif // DECIBEL_HPP
@@ -1,8 +1,95 @@
 #ifndef FFT_HPP
 #define FFT_HPP
 
+#include <mutex>
+#include <memory>
+#include <complex>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <list>
+#include <thread>
+
+// pocketfft-eigener LRU-Cache fuer die Pfade ueber pocketfft::r2c/c2c (Plaene der c2c-
+// Einzeltransformation und der Stapel kommen aus FFTPlanCache)
+#ifndef POCKETFFT_CACHE_SIZE
+#define POCKETFFT_CACHE_SIZE 16
+#endif
 #include "pocketfft_hdronly.h"
 
+
+/// @brief Prozessweiter Cache der pocketfft c2c-Plaene (Faktorisierung und Twiddle-Tabellen)
+///        je Laenge. Ein Plan gilt fuer beide Richtungen und exec() ist const, derselbe Plan
+///        wird daher von allen FFT-Objekten und Threads geteilt. Hoechstens capacity() Plaene,
+///        darueber wird der am laengsten nicht angeforderte verworfen (FFT-Objekte, die ihn
+///        noch halten, behalten ihn).
+class FFTPlanCache {
+public:
+    using Plan = pocketfft::detail::pocketfft_c<float>;
+
+    /// @brief liefert den Plan fuer leng, legt ihn beim ersten Zugriff an
+    static std::shared_ptr<const Plan> get( uint64_t leng) {
+        std::lock_guard<std::mutex> lock( state()._mutexer);
+        State &cache = state();
+        const auto found = cache._index.find( leng);
+        if( found != cache._index.end()) {
+            // nach vorne, vorne steht der zuletzt angeforderte
+            cache._lru.splice( cache._lru.begin(), cache._lru, found->second);
+            return found->second->second;
+        }
+        cache._lru.emplace_front( leng, std::make_shared<const Plan>( leng));
+        cache._index[ leng] = cache._lru.begin();
+        evict( cache);
+        return cache._lru.front().second;
+    }
+
+    /// @brief Anzahl zwischengespeicherter Plaene
+    static uint64_t size() {
+        std::lock_guard<std::mutex> lock( state()._mutexer);
+        return state()._lru.size();
+    }
+
+    /// @brief hoechste Anzahl Plaene (Vorgabe 32), verwirft sofort, was darueber liegt
+    static void setCapacity( uint64_t capacity) {
+        std::lock_guard<std::mutex> lock( state()._mutexer);
+        state()._capacity = std::max<uint64_t>( capacity, 1);
+        evict( state());
+    }
+    static uint64_t capacity() {
+        std::lock_guard<std::mutex> lock( state()._mutexer);
+        return state()._capacity;
+    }
+
+    /// @brief verwirft alle Plaene, bestehende FFT-Objekte behalten ihren Plan
+    static void clear() {
+        std::lock_guard<std::mutex> lock( state()._mutexer);
+        state()._index.clear();
+        state()._lru.clear();
+    }
+
+private:
+    struct State {
+        std::mutex _mutexer;
+        uint64_t _capacity = 32;
+        std::list<std::pair<uint64_t, std::shared_ptr<const Plan>>> _lru;
+        std::unordered_map<uint64_t, decltype( _lru)::iterator> _index;
+    };
+
+    static State& state() {
+        static State state;
+        return state;
+    }
+
+    /// @brief unter _mutexer
+    static void evict( State &cache) {
+        while( cache._lru.size() > cache._capacity) {
+            cache._index.erase( cache._lru.back().first);
+            cache._lru.pop_back();
+        }
+    }
+};
+
+
 /// @brief Wrapper for one-dimensional transformation (c2c, r2c)
 class FFT {
 
@@ -11,6 +98,30 @@ class FFT {
     const pocketfft::stride_t stride_out = {sizeof( std::complex<float>)};  // Stride for output array
     const pocketfft::stride_t stride_in_float = { sizeof( float)};
     pocketfft::shape_t axes = {0};              // Axes to transform
+    std::shared_ptr<const FFTPlanCache::Plan> _plan;
+
+    /// @brief in-place auf output: input wird (falls noetig) kopiert und transformiert
+    void exec( const std::complex<float> *input, std::complex<float> *output, float fct, bool forward) const {
+        if( input != output)
+            std::copy( input, input + leng(), output);
+        _plan->exec( reinterpret_cast<pocketfft::detail::cmplx<float>*>( output), fct, forward);
+    }
+
+    /// @brief verteilt frames Transformationen auf nthreads Threads aus dem pocketfft-Pool
+    void execBatch( const std::complex<float> *input, std::complex<float> *output,
+                    uint64_t frames, uint64_t nthreads, float fct, bool forward) const {
+        if( ! frames) return;
+        nthreads = std::min<uint64_t>( nthreads ? nthreads : std::thread::hardware_concurrency(), frames);
+        const uint64_t leng = this->leng();
+        pocketfft::detail::threading::thread_map( std::max<uint64_t>( nthreads, 1), [ &] {
+            const uint64_t id = pocketfft::detail::threading::thread_id();
+            const uint64_t count = pocketfft::detail::threading::num_threads();
+            const uint64_t end = frames * ( id + 1) / count;
+            for( uint64_t frame = frames * id / count; frame < end; ++frame)
+                exec( input + frame * leng, output + frame * leng, fct, forward);
+        });
+    }
+
 public:
     FFT( uint64_t leng = 1024) : _shape( {leng}) {
         setLeng( leng);
@@ -19,15 +130,17 @@ public:
     /// @brief return current fft length
     uint64_t leng() const { return _shape.at(0);}
 
-    /// @brief set new fft length
+    /// @brief set new fft length, the plan is taken from FFTPlanCache
     void setLeng( uint64_t leng) {
         if( leng < 2) throw std::invalid_argument("FEHLER fft leng < 2");
+        if( _plan && leng == this->leng()) return;
         _shape = { leng};
+        _plan = FFTPlanCache::get( leng);
     }
 
+    /// @brief input and output may be the same buffer (in-place)
     void fft( const std::complex<float> *input, std::complex<float> *output) {
-        pocketfft::c2c<float>( _shape, stride_in, stride_out, axes, pocketfft::FORWARD,
-                              input, output, 1.);
+        exec( input, output, 1.f, pocketfft::FORWARD);
     }
     void fft( const std::vector<std::complex<float>> &input, std::vector<std::complex<float>> &output) {
         fft( input.data(), output.data());
@@ -35,7 +148,7 @@ public:
 
     /// @brief Computes vector of floats to its complex frequency domain, just one dimensional
     void fft( const float *input, std::complex<float> *output) {
-        pocketfft::r2c<float>( _shape, stride_in, stride_out, 1, pocketfft::FORWARD, input, output, 1.);
+        pocketfft::r2c<float>( _shape, stride_in_float, stride_out, 0, pocketfft::FORWARD, input, output, 1.);
     }
     /// @brief Computes vector of floats to its complex frequency domain
     void fft( const std::vector<float> &input, std::vector<std::complex<float>> &output) {
@@ -48,8 +161,7 @@ public:
     /// @param input data of exact leng samples
     /// @param output fft with input leng
     void ifft( const std::complex<float> *input, std::complex<float> *output) {
-        pocketfft::c2c<float>( _shape, stride_in, stride_out, axes, pocketfft::BACKWARD,
-                              input, output, 1. / static_cast<double>( this->leng()));
+        exec( input, output, 1.f / static_cast<float>( this->leng()), pocketfft::BACKWARD);
     }
     /// @brief performs complex<float> to complex<float> reverse-fft
     /// @param input data of exact leng samples
@@ -57,6 +169,18 @@ public:
     void ifft( const std::vector<std::complex<float>> &input, std::vector<std::complex<float>> &output) {
         ifft( input.data(), output.data());
     }
+
+    /// @brief transformiert frames direkt aufeinanderfolgende Bloecke der Laenge leng()
+    ///        in einem Aufruf (in-place erlaubt)
+    /// @param nthreads Anzahl Threads, 0: alle Kerne
+    void fftBatch( const std::complex<float> *input, std::complex<float> *output,
+                   uint64_t frames, uint64_t nthreads = 1) {
+        execBatch( input, output, frames, nthreads, 1.f, pocketfft::FORWARD);
+    }
+    void ifftBatch( const std::complex<float> *input, std::complex<float> *output,
+                    uint64_t frames, uint64_t nthreads = 1) {
+        execBatch( input, output, frames, nthreads, 1.f / static_cast<float>( this->leng()), pocketfft::BACKWARD);
+    }
 };
 
 #endif // FFT_HPP
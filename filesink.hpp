@@ -8,10 +8,9 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QLineEdit>
-#include <QFile>
-#include <QThread>
-#include <QMutex>
+#include <QFileInfo>
 #include <QCheckBox>
+#include <QDoubleSpinBox>
 #include <QFileDialog>
 #include <QTimer>
 #include <QDateTime>
@@ -22,6 +21,12 @@
 
 #include <complex>
 #include <vector>
+#include <memory>
+
+#include "sampleblock.hpp"
+#include "filewriter.hpp"
+#include "recording.hpp"
+#include "triggerrecorder.hpp"
 
 class FileWriterWidget : public QWidget
 {
@@ -29,7 +34,7 @@ class FileWriterWidget : public QWidget
 
 public:
     explicit FileWriterWidget(QWidget *parent = nullptr)
-        : QWidget(parent), file(nullptr), writing(false)
+        : QWidget(parent), writing(false)
     {
         // Initialize UI elements
         pathLineEdit = new QLineEdit(this);
@@ -43,12 +48,48 @@ public:
         connect(startStopButton, &QPushButton::clicked, this, &FileWriterWidget::onStartStop);
 
         infoLabel = new QLabel("Dauer: 0:00:00 | Größe: 0.000 GB", this);
+        overrunLabel = new QLabel("Überläufe: 0 | Puffer: 0 %", this);
 
         _append_mode = new QCheckBox;
         _append_mode->setText( "anfügen (sonst überschreiben)");
 
+        _direct_mode = new QCheckBox;
+        _direct_mode->setText( "O_DIRECT");
+        _direct_mode->setToolTip( "am Seitencache vorbei schreiben (NVMe)");
+
+        // sc16: native Abtastwerte der MOUSE, halbe Datenrate gegenueber cf32
+        _format = new QComboBox;
+        _format->addItem( "sc16", static_cast<int>( RecordFormat::SC16));
+        _format->addItem( "cf32", static_cast<int>( RecordFormat::CF32));
+        _format->addItem( "sc8", static_cast<int>( RecordFormat::SC8));
+        _format->addItem( "sc8 bfp", static_cast<int>( RecordFormat::SC8BFP));
+        _format->addItem( "verlustfrei", static_cast<int>( RecordFormat::LOSSLESS));
+        _format->setToolTip( "Abtastformat, Beschreibung in <Datei>.sigmf-meta;\n"
+                             "sc8 bfp und verlustfrei sind kodiert (mouse:encoding)");
+
+        // Aufnahme mit Vorlauf, erst aktiv mit setTriggeredRecorder()
+        _trigger_arm = new QCheckBox;
+        _trigger_arm->setText( "Vorlauf");
+        _trigger_arm->setToolTip( "die letzten Sekunden im Speicher halten, Trigger schreibt sie in eine eigene Datei");
+        _trigger_arm->setEnabled( false);
+        connect( _trigger_arm, &QCheckBox::toggled, this, &FileWriterWidget::onTriggerSettings);
+        _pre_trigger = new QDoubleSpinBox;
+        _pre_trigger->setRange( 0., 600.);
+        _pre_trigger->setValue( 5.);
+        _pre_trigger->setSuffix( " s vor");
+        connect( _pre_trigger, &QDoubleSpinBox::valueChanged, this, &FileWriterWidget::onTriggerSettings);
+        _post_trigger = new QDoubleSpinBox;
+        _post_trigger->setRange( 0., 600.);
+        _post_trigger->setValue( 5.);
+        _post_trigger->setSuffix( " s nach");
+        connect( _post_trigger, &QDoubleSpinBox::valueChanged, this, &FileWriterWidget::onTriggerSettings);
+        _trigger_button = new QPushButton( "Trigger", this);
+        _trigger_button->setEnabled( false);
+        connect( _trigger_button, &QPushButton::clicked, this, &FileWriterWidget::trigger);
+        triggerLabel = new QLabel( "Ereignisse: 0", this);
+
         timer = new QTimer(this);
-        connect(timer, &QTimer::timeout, this, &FileWriterWidget::updateInfo);
+        connect(timer, &QTimer::timeout, this, &FileWriterWidget::onTimer);
 
         // Layout setup
         QHBoxLayout *qhbl_first = new QHBoxLayout;
@@ -56,14 +97,26 @@ public:
         qhbl_first->addWidget(browseButton);
 
         QHBoxLayout *qhbl_second = new QHBoxLayout;
+        qhbl_second->addWidget( _format);
         qhbl_second->addWidget( _append_mode);
+        qhbl_second->addWidget( _direct_mode);
         qhbl_second->addWidget(startStopButton);
         qhbl_second->addWidget(infoLabel);
+        qhbl_second->addWidget(overrunLabel);
 
 
+        // Verzeichnis und Namensanfang der Ereignisdateien aus pathLineEdit
+        QHBoxLayout *qhbl_third = new QHBoxLayout;
+        qhbl_third->addWidget( _trigger_arm);
+        qhbl_third->addWidget( _pre_trigger);
+        qhbl_third->addWidget( _post_trigger);
+        qhbl_third->addWidget( _trigger_button);
+        qhbl_third->addWidget( triggerLabel);
+
         QVBoxLayout *mainLayout = new QVBoxLayout;
         mainLayout->addLayout( qhbl_first);
         mainLayout->addLayout( qhbl_second);
+        mainLayout->addLayout( qhbl_third);
 
         setLayout(mainLayout);
         setSizePolicy( QSizePolicy::Minimum, QSizePolicy::Minimum);
@@ -71,10 +124,7 @@ public:
 
     ~FileWriterWidget()
     {
-        if (file && file->isOpen()) {
-            file->close();
-            delete file;
-        }
+        _recorder.close();
     }
 
     /// @brief bekommt eine Funktion uebergeben, welche eine string in den Dateinamen anbringt
@@ -82,25 +132,79 @@ public:
         _getString = foo;
     }
 
-    // Public method to write data to the file
-    void writeToFile(const std::vector<std::complex<float>> &input)
+    // Public method to write data to the file, the shared block is only copied into the
+    // writer's ring, a slow disk never blocks the calling thread. Only the block type
+    // matching the selected format is written (cf32: converted, sc16/sc8: raw).
+    void writeToFile(const SampleBlockPtr<std::complex<float>> &input)
     {
-        if (file && file->isOpen()) {
-            file->write( reinterpret_cast<const char*>(input.data()),
-                         input.size() * sizeof( std::complex<float>));
+        _recorder.write( input);
+    }
+    void writeRawToFile(const SampleBlockPtr<std::complex<int16_t>> &input)
+    {
+        _recorder.write( input);
+    }
+
+public slots:
+    /// @brief Angaben fuer die SigMF-Beschreibung, z.B. von MouseGUI; Umstimmen waehrend
+    ///        der Aufnahme beginnt einen neuen Capture
+    void setSampleRate( int32_t samp_rate) {
+        _meta.samp_rate = samp_rate;
+        if( _triggered) _triggered->setSampleRate( samp_rate);
+    }
+    void setCenterFrequency( int32_t center_freq) {
+        _meta.center_freq = center_freq;
+        _recorder.setCenterFrequency( center_freq);
+        if( _triggered) _triggered->setCenterFrequency( center_freq);
+    }
+
+    /// @brief loest die Aufnahme mit Vorlauf aus bzw. verlaengert sie, z.B. aus der
+    ///        Carrier-Erkennung (aus jedem Thread)
+    void trigger() {
+        if( _triggered) _triggered->trigger();
+    }
+
+public:
+    /// @brief z.B. fuer Annotationen aus der Carrier-Erkennung (Recorder::annotate())
+    Recorder& recorder() { return _recorder;}
+
+    /// @brief Knoten fuer die Aufnahme mit Vorlauf, haengt am rohen Ausgang der Quelle
+    void setTriggeredRecorder( std::shared_ptr<TriggeredRecorder<std::complex<int16_t>>> triggered) {
+        _triggered = std::move( triggered);
+        if( _triggered) {
+            _triggered->setSampleRate( _meta.samp_rate);
+            _triggered->setCenterFrequency( _meta.center_freq);
         }
+        _trigger_arm->setEnabled( static_cast<bool>( _triggered));
+        onTriggerSettings();
+        if( ! timer->isActive()) timer->start( 500);
     }
 
 private slots:
+    void onTriggerSettings()
+    {
+        if ( ! _triggered) return;
+        const bool armed = _trigger_arm->isChecked();
+        // ohne Datei: Ereignisse landen im Arbeitsverzeichnis
+        QString prefix = pathLineEdit->text();
+        if ( ! prefix.isEmpty())
+            prefix = QFileInfo( prefix).absolutePath() + "/" + QFileInfo( prefix).completeBaseName() + "_";
+        _triggered->setPrefix( prefix.toStdString());
+        _triggered->setPreTrigger( _pre_trigger->value());
+        _triggered->setPostTrigger( _post_trigger->value());
+        _triggered->setArmed( armed);
+        _trigger_button->setEnabled( armed);
+    }
+
     void onBrowse()
     {
         QString fileName = QFileDialog::getSaveFileName(
             this,                   // Parent widget
             tr("Save File"),        // Dialog title
             "/home",                     // Initial directory (empty string means home directory)
-            tr("Text Files (*.txt);;All Files (*)")); // Filters
+            tr("IQ (*.sc16 *.cf32 *.sc8);;All Files (*)")); // Filters
         if ( ! fileName.isEmpty()) {
             pathLineEdit->setText(fileName);
+            onTriggerSettings();
         }
     }
 
@@ -114,21 +218,16 @@ private slots:
                 return;
             }
 
-            file = new QFile(filePath);
-            bool good;
-            if( _append_mode->isChecked()) {
-                good = file->open( QFile::WriteOnly | QFile::Text | QFile::Append);
-                updateInfo();
-            }
-            else
-                good = file->open( QFile::WriteOnly | QFile::Text);
-
-            if ( ! good) {
-                QMessageBox::critical(this, "Error", "konnte Datei nicht öffnen.");
-                delete file;
-                file = nullptr;
+            const bool append = _append_mode->isChecked();
+            _size_offset = append ? QFileInfo( filePath).size() : 0;
+            _recorder.writer().setDirect( _direct_mode->isChecked());
+            _recorder.setFormat( static_cast<RecordFormat>( _format->currentData().toInt()));
+            if ( _recorder.open( filePath.toStdString(), append, _meta)) {
+                QMessageBox::critical(this, "Error", QString::fromStdString( _recorder.getError()));
                 return;
             }
+            _format->setEnabled( false);
+            updateInfo();
 
             // .toString("yyMMdd_hhmmss")
             writing = true;
@@ -137,45 +236,73 @@ private slots:
             startStopButton->setText("Stop");
             startStopButton->setStyleSheet("background-color: red; color: black;");
         } else {
-            if (file && file->isOpen()) {
-                file->close();
-                delete file;
-                file = nullptr;
-            }
+            _recorder.close();
+            _format->setEnabled( true);
 
             writing = false;
-            timer->stop();
+            if ( ! _triggered) timer->stop();
+            updateInfo();
             startStopButton->setText("Start");
             startStopButton->setStyleSheet("background-color: Pale gray ; color: black;");
         }
     }
 
+    void onTimer()
+    {
+        if ( _triggered) {
+            triggerLabel->setText( QString( "Ereignisse: %1").arg( _triggered->getFileCount())
+                                   + ( _triggered->isRecording() ? " | schreibt" : ""));
+            triggerLabel->setStyleSheet( _triggered->isRecording() ? "color: red;" : "");
+        }
+        if ( writing) updateInfo();
+    }
+
     void updateInfo()
     {
+
         // Update write duration
         qint64 duration = startTime.msecsTo(QDateTime::currentDateTime()) / 1000; // Duration in seconds
         QTime time(0, 0);
         time = time.addSecs(duration);
 
         // Update file size
-        double sizeInGB = 0.0;
-        if (file && file->isOpen()) {
-            qint64 size = file->size();
-            sizeInGB = static_cast<double>(size) / (1024 * 1024 * 1024); // Convert to GB
-        }
+        const uint64_t size = _size_offset + _recorder.bytesWritten();
+        double sizeInGB = static_cast<double>(size) / (1024 * 1024 * 1024); // Convert to GB
 
-        infoLabel->setText(QString("Dauer: %1 | Größe: %2 GB")
+        // Kompression gegenueber cf32, bei den kodierten Formaten gemessen
+        infoLabel->setText(QString("Dauer: %1 | Größe: %2 GB | Kompression: %3x")
                                .arg(time.toString("h:mm:ss"))
-                               .arg(sizeInGB, 0, 'f', 3));
+                               .arg(sizeInGB, 0, 'f', 3)
+                               .arg(_recorder.getCompressionRatio(), 0, 'f', 2));
+
+        // Ueberlaeufe: verworfene Bloecke, weil die Platte dem Strom nicht folgt
+        const FileWriter::Statistics stat = _recorder.writer().getStatistics();
+        const double fill = stat.capacity ? 100. * static_cast<double>( stat.buffered) / stat.capacity : 0.;
+        overrunLabel->setText(QString("Überläufe: %1 (%2 MB) | Puffer: %3 %")
+                                  .arg(stat.overruns)
+                                  .arg(static_cast<double>(stat.dropped) / (1024 * 1024), 0, 'f', 1)
+                                  .arg(fill, 0, 'f', 0)
+                              + (stat.direct ? " | direkt" : ""));
+        overrunLabel->setStyleSheet(stat.overruns ? "color: red;" : "");
     }
 
 private:
     QLineEdit *pathLineEdit;
     QPushButton *startStopButton;
     QLabel *infoLabel;
+    QLabel *overrunLabel;
     QCheckBox *_append_mode;
-
-    QFile *file;
+    QCheckBox *_direct_mode;
+    QComboBox *_format;
+    QCheckBox *_trigger_arm;
+    QDoubleSpinBox *_pre_trigger, *_post_trigger;
+    QPushButton *_trigger_button;
+    QLabel *triggerLabel;
+
+    Recorder _recorder;
+    std::shared_ptr<TriggeredRecorder<std::complex<int16_t>>> _triggered;
+    RecordMeta _meta;
+    uint64_t _size_offset = 0;
     QTimer *timer;
     QDateTime startTime;
     bool writing;
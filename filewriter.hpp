@@ -0,0 +1,346 @@
+#ifndef FILEWRITER_HPP
+#define FILEWRITER_HPP
+
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "sampleblock.hpp"
+
+
+/// @brief Schreibt Sample-Bloecke unveraendert (binaer) in eine Datei, ohne Qt.
+///        write() kopiert nur in einen vorab angelegten Ring und kehrt sofort zurueck, ein
+///        eigener Schreibthread gibt den Ring in grossen, ausgerichteten Stuecken an die
+///        Platte weiter. Eine langsame Platte haelt so die Erfassung nicht auf: reicht der
+///        Ring nicht, wird der Block verworfen und als Ueberlauf gezaehlt.
+///        Optional: O_DIRECT (am Seitencache vorbei), fallocate() vorab und fdatasync()
+///        in festen Abstaenden. write() kommt aus genau einem Thread (der Senke),
+///        open()/close() duerfen aus einem anderen Thread kommen.
+class FileWriter {
+public:
+    /// @brief Ausrichtung von Puffer, Stuecken und Dateiversatz fuer O_DIRECT
+    static constexpr uint64_t ALIGNMENT = 4096;
+
+    struct Statistics {
+        uint64_t written;       // Bytes auf der Platte
+        uint64_t dropped;       // verworfene Bytes (Ring voll oder Schreibfehler)
+        uint64_t overruns;      // verworfene Bloecke
+        uint64_t buffered;      // Bytes im Ring
+        uint64_t max_buffered;  // hoechster Fuellstand seit open()
+        uint64_t capacity;      // Groesse des Rings
+        bool direct;            // O_DIRECT tatsaechlich aktiv
+    };
+
+private:
+    struct FreeDeleter {
+        void operator()( char *ptr) const { std::free( ptr);}
+    };
+
+    int _fd;
+    bool _open;                             // nimmt write() an, unter _mutexer
+    std::string _path;
+    std::string _error;
+    std::mutex _mutexer;
+
+    // Einstellungen, gelten ab dem naechsten open()
+    uint64_t _buffer_size, _chunk_size, _prealloc_step, _sync_interval;
+    bool _want_direct;
+
+    // Ring: _head schreibt write(), _tail der Schreibthread, beide zaehlen fortlaufend
+    std::unique_ptr<char, FreeDeleter> _ring;
+    uint64_t _capacity;
+    std::atomic<uint64_t> _head, _tail;
+
+    std::thread _fred;
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    std::atomic_bool _stopping, _failed;
+
+    std::atomic_bool _direct;
+    // nur im Schreibthread
+    uint64_t _offset, _allocated, _synced;
+
+    std::atomic<uint64_t> _bytes_written, _dropped, _overruns, _max_buffered;
+
+    void setError( const std::string &what) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _error = "FEHLER FileWriter::" + what + ": " + _path + ": " + std::strerror( errno);
+    }
+
+    /// @brief O_DIRECT verlangt ausgerichtete Laengen, den Rest beim Schliessen normal schreiben
+    void leaveDirect() {
+        const int flags = ::fcntl( _fd, F_GETFL);
+        if( flags >= 0) ::fcntl( _fd, F_SETFL, flags & ~O_DIRECT);
+        _direct = false;
+    }
+
+    /// @return false bei Schreibfehler
+    bool writeChunk( const char *data, uint64_t bytes) {
+        // Platz in grossen Schritten reservieren, haelt die Datei zusammenhaengend
+        if( _prealloc_step && _offset + bytes > _allocated) {
+            const uint64_t step = std::max( _prealloc_step, bytes);
+            if( ::fallocate( _fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>( _allocated), static_cast<off_t>( step)) == 0)
+                _allocated += step;
+            else
+                _prealloc_step = 0;     // vom Dateisystem nicht unterstuetzt
+        }
+        while( bytes) {
+            const ssize_t ret = ::write( _fd, data, bytes);
+            if( ret < 0) {
+                if( errno == EINTR) continue;
+                setError( "write()");
+                return false;
+            }
+            data += ret;
+            bytes -= ret;
+            _offset += ret;
+            _bytes_written += ret;
+        }
+        if( _sync_interval && _offset - _synced >= _sync_interval)
+            sync();
+        return true;
+    }
+
+    /// @brief schreibt Geschriebenes fest und gibt es im Seitencache frei, sonst waechst
+    ///        der Cache ueber Minuten an und die Platte bekommt die Daten stossweise
+    void sync() {
+        ::fdatasync( _fd);
+        if( ! _direct)
+            ::posix_fadvise( _fd, static_cast<off_t>( _synced), static_cast<off_t>( _offset - _synced), POSIX_FADV_DONTNEED);
+        _synced = _offset;
+    }
+
+    uint64_t fill() const { return _head.load( std::memory_order_acquire) - _tail.load( std::memory_order_relaxed);}
+
+    /// @brief Schreibthread: wartet auf ein volles Stueck, nach FLUSH_INTERVAL schreibt er
+    ///        auch weniger, damit langsame Stroeme zeitnah auf der Platte landen
+    void run() {
+        constexpr std::chrono::milliseconds FLUSH_INTERVAL( 250);
+        for( ;;) {
+            uint64_t avail = fill();
+            if( avail < _chunk_size && ! _stopping) {
+                std::unique_lock<std::mutex> lock( _wake_mutex);
+                const bool woken = _wake.wait_for( lock, FLUSH_INTERVAL, [ this]
+                                                   { return _stopping || fill() >= _chunk_size;});
+                lock.unlock();
+                avail = fill();
+                if( ! woken && _direct)
+                    avail -= avail % ALIGNMENT;
+                if( ! avail) continue;
+            }
+            const bool stopping = _stopping;
+            if( stopping && ! avail) break;
+
+            // ein Stueck, hoechstens _chunk_size und nicht ueber das Ringende
+            const uint64_t tail = _tail.load( std::memory_order_relaxed);
+            const uint64_t pos = tail % _capacity;
+            uint64_t bytes = std::min( { avail, _chunk_size, _capacity - pos});
+            if( _direct && bytes % ALIGNMENT) {
+                if( stopping) leaveDirect();
+                else bytes -= bytes % ALIGNMENT;
+            }
+            if( ! bytes) continue;
+            if( ! writeChunk( _ring.get() + pos, bytes)) {
+                _failed = true;
+                break;
+            }
+            _tail.store( tail + bytes, std::memory_order_release);
+        }
+        if( _sync_interval && ! _failed)
+            sync();
+    }
+
+    /// @brief Ring einmal anlegen und vorbelegen, damit write() keine Seitenfehler ausloest;
+    ///        unter _mutexer, nicht bei offener Datei
+    int allocateRing() {
+        _chunk_size = std::max( ALIGNMENT, ( _chunk_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+        const uint64_t capacity = std::max<uint64_t>( 2, ( _buffer_size + _chunk_size - 1) / _chunk_size) * _chunk_size;
+        if( _ring && capacity == _capacity) return 0;
+        _ring.reset( static_cast<char*>( std::aligned_alloc( ALIGNMENT, capacity)));
+        if( ! _ring) {
+            _capacity = 0;
+            _error = "FEHLER FileWriter: kein Speicher fuer den Ring";
+            return -1;
+        }
+        std::memset( _ring.get(), 0, capacity);
+        _capacity = capacity;
+        return 0;
+    }
+
+public:
+    FileWriter() : _fd( -1), _open( false),
+        _buffer_size( 256ull << 20), _chunk_size( 4ull << 20), _prealloc_step( 256ull << 20),
+        _sync_interval( 64ull << 20), _want_direct( false), _capacity( 0), _head( 0), _tail( 0),
+        _stopping( false), _failed( false), _direct( false), _offset( 0), _allocated( 0), _synced( 0),
+        _bytes_written( 0), _dropped( 0), _overruns( 0), _max_buffered( 0) {}
+    FileWriter( const FileWriter &) = delete;
+    FileWriter& operator =( const FileWriter &) = delete;
+    ~FileWriter() {
+        close();
+    }
+
+    /// @brief Groesse des Rings, puffert Aussetzer der Platte (Vorgabe 256 MiB)
+    void setBufferSize( uint64_t bytes) { _buffer_size = bytes;}
+    /// @brief Laenge eines write()-Aufrufs des Schreibthreads (Vorgabe 4 MiB)
+    void setChunkSize( uint64_t bytes) { _chunk_size = bytes;}
+    /// @brief am Seitencache vorbei schreiben, faellt ohne Unterstuetzung auf normales Schreiben zurueck
+    void setDirect( bool direct) { _want_direct = direct;}
+    /// @brief Schrittweite von fallocate(), 0: aus (Vorgabe 256 MiB)
+    void setPreallocate( uint64_t bytes) { _prealloc_step = bytes;}
+    /// @brief fdatasync() nach je bytes, 0: aus (Vorgabe 64 MiB)
+    void setSyncInterval( uint64_t bytes) { _sync_interval = bytes;}
+
+    /// @brief legt den Ring mit den aktuellen Einstellungen sofort an statt beim naechsten
+    ///        open(), z.B. bei der Konfiguration, wenn das Oeffnen schnell gehen muss
+    /// @return 0: alles normal, -1: Datei offen (Ring in Gebrauch) oder kein Speicher
+    int reserve() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        if( _fd >= 0) return -1;
+        return allocateRing();
+    }
+
+    /// @brief gibt den Ring frei, das naechste open() bzw. reserve() legt ihn neu an
+    /// @return 0: alles normal, -1: Datei offen (Ring in Gebrauch)
+    int release() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        if( _fd >= 0) return -1;
+        _ring.reset();
+        _capacity = 0;
+        return 0;
+    }
+
+    /// @param append true: an bestehende Datei anfuegen, sonst ueberschreiben
+    /// @return 0: alles normal, -1: Fehler (siehe getError())
+    int open( const std::string &path, bool append = false) {
+        close();
+        const int flags = O_WRONLY | O_CREAT | O_CLOEXEC | ( append ? O_APPEND : O_TRUNC);
+        int fd = -1;
+        bool direct = false;
+        if( _want_direct) {
+            fd = ::open( path.c_str(), flags | O_DIRECT, 0644);
+            direct = fd >= 0;
+        }
+        if( fd < 0)
+            fd = ::open( path.c_str(), flags, 0644);
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _path = path;
+        if( fd < 0) {
+            _error = "FEHLER FileWriter::open(): " + path + ": " + std::strerror( errno);
+            return -1;
+        }
+
+        struct stat st{};
+        ::fstat( fd, &st);
+        _offset = _allocated = _synced = static_cast<uint64_t>( st.st_size);
+        // O_DIRECT schreibt nur ab ausgerichtetem Versatz
+        if( direct && _offset % ALIGNMENT) {
+            ::fcntl( fd, F_SETFL, ::fcntl( fd, F_GETFL) & ~O_DIRECT);
+            direct = false;
+        }
+
+        if( allocateRing()) {
+            ::close( fd);
+            return -1;
+        }
+
+        _fd = fd;
+        _direct = direct;
+        _head = _tail = 0;
+        _bytes_written = _dropped = _overruns = _max_buffered = 0;
+        _stopping = _failed = false;
+        _fred = std::thread( &FileWriter::run, this);
+        _open = true;
+        return 0;
+    }
+
+    /// @brief nimmt keine Bloecke mehr an, schreibt den Ring leer und schliesst die Datei
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            if( ! _open) return;
+            _open = false;
+        }
+        {
+            std::lock_guard<std::mutex> lock( _wake_mutex);
+            _stopping = true;
+        }
+        _wake.notify_one();
+        if( _fred.joinable()) _fred.join();
+
+        std::lock_guard<std::mutex> lock( _mutexer);
+        // nicht benoetigten, vorab reservierten Platz freigeben
+        if( _allocated > _offset)
+            if( ::ftruncate( _fd, static_cast<off_t>( _offset))) {}
+        ::close( _fd);
+        _fd = -1;
+    }
+
+    bool isOpen() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return _open;
+    }
+
+    /// @brief kopiert data in den Ring, blockiert nicht
+    /// @return false, wenn die Datei nicht offen ist oder der Block verworfen wurde
+    bool write( const void *data, uint64_t bytes) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        if( ! _open) return false;
+        const uint64_t head = _head.load( std::memory_order_relaxed);
+        const uint64_t used = head - _tail.load( std::memory_order_acquire);
+        if( _failed || bytes > _capacity - used) {
+            ++_overruns;
+            _dropped += bytes;
+            return false;
+        }
+        const uint64_t pos = head % _capacity;
+        const uint64_t first = std::min( bytes, _capacity - pos);
+        std::memcpy( _ring.get() + pos, data, first);
+        std::memcpy( _ring.get(), static_cast<const char*>( data) + first, bytes - first);
+        _head.store( head + bytes, std::memory_order_release);
+
+        const uint64_t filled = used + bytes;
+        if( filled > _max_buffered) _max_buffered = filled;
+        // Schreibthread nur beim Erreichen eines Stuecks wecken, ohne _wake_mutex: ein
+        // verpasstes Wecken holt das Zeitlimit in run() nach
+        if( used < _chunk_size && filled >= _chunk_size)
+            _wake.notify_one();
+        return true;
+    }
+
+    template <typename T>
+    bool write( const SampleBlockPtr<T> &input) {
+        return write( input->data(), input->size() * sizeof( T));
+    }
+
+    /// @brief Anzahl seit open() geschriebener Bytes
+    uint64_t bytesWritten() const { return _bytes_written;}
+    /// @brief seit open() wegen vollem Ring verworfene Bloecke
+    uint64_t getOverruns() const { return _overruns;}
+
+    Statistics getStatistics() const {
+        const uint64_t head = _head, tail = _tail;
+        return { _bytes_written, _dropped, _overruns, head - tail, _max_buffered, _capacity, _direct};
+    }
+
+    std::string getPath() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return _path;
+    }
+    std::string getError() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return _error;
+    }
+};
+
+#endif // FILEWRITER_HPP
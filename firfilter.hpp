@@ -0,0 +1,472 @@
+#ifndef FIRFILTER_HPP
+#define FIRFILTER_HPP
+
+#include <vector>
+#include <complex>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+#include <stdexcept>
+
+#if defined( __x86_64__) || defined( __i386__)
+#include <immintrin.h>
+#endif
+
+#include "simd.hpp"
+#include "fft.hpp"
+#include "tools.hpp"
+
+
+/// @brief Entwurf von FIR-Filtern. Frequenzen relativ zur Abtastrate (0 .. 0.5), Daempfung
+///        in dB als positiver Wert. Tiefpaesse haben den Gleichanteil 1.
+namespace Fir {
+
+enum class Window {
+    Blackman,   // ca. 74 dB Sperrdaempfung, Uebergang ca. 5.5 / Laenge
+    Kaiser      // Daempfung ueber beta einstellbar, siehe kaiserBeta()
+};
+
+/// @brief modifizierte Besselfunktion erster Art, nullter Ordnung (Reihe)
+inline double
+besselI0( double x) {
+    double sum = 1., term = 1.;
+    const double half_sq = 0.25 * x * x;
+    for( int k = 1; k < 64 && term > 1e-12 * sum; ++k) {
+        term *= half_sq / static_cast<double>( k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+/// @brief beta des Kaiser-Fensters fuer atten_db Sperrdaempfung
+inline double
+kaiserBeta( double atten_db) {
+    if( atten_db > 50.) return 0.1102 * ( atten_db - 8.7);
+    if( atten_db >= 21.) return 0.5842 * std::pow( atten_db - 21., 0.4) + 0.07886 * ( atten_db - 21.);
+    return 0.;
+}
+
+/// @brief Laenge nach Kaiser fuer atten_db Sperrdaempfung und den Uebergang rel_transition,
+///        ungerade (Gruppenlaufzeit ganzzahlig)
+inline uint64_t
+kaiserLength( double atten_db, double rel_transition) {
+    if( rel_transition <= 0. || rel_transition >= 0.5)
+        throw std::invalid_argument( "FEHLER Fir::kaiserLength(): rel_transition ausserhalb 0 .. 0.5");
+    const uint64_t leng = static_cast<uint64_t>( std::ceil( ( atten_db - 7.95) / ( 14.36 * rel_transition))) + 1;
+    return std::max<uint64_t>( leng, 3) | 1;
+}
+
+/// @brief Fensterwert w von leng
+inline double
+window( Window win, uint64_t w, uint64_t leng, double beta = 8.6) {
+    if( leng <= 1) return 1.;
+    const double pos = static_cast<double>( w) / static_cast<double>( leng - 1);
+    switch( win) {
+    case Window::Blackman:
+        return 0.42 - 0.5 * std::cos( 2. * M_PI * pos) + 0.08 * std::cos( 4. * M_PI * pos);
+    case Window::Kaiser: {
+        const double r = 2. * pos - 1.;
+        return besselI0( beta * std::sqrt( std::max( 0., 1. - r * r))) / besselI0( beta);
+    }
+    }
+    return 1.;
+}
+
+/// @brief gefensterter sinc-Tiefpass mit der Grenzfrequenz rel_cutoff (-6 dB)
+inline std::vector<float>
+lowPass( double rel_cutoff, uint64_t leng, Window win = Window::Blackman, double beta = 8.6) {
+    if( ! leng) throw std::invalid_argument( "FEHLER Fir::lowPass(): leng == 0");
+    if( rel_cutoff <= 0. || rel_cutoff > 0.5)
+        throw std::invalid_argument( "FEHLER Fir::lowPass(): rel_cutoff ausserhalb 0 .. 0.5");
+    std::vector<double> taps( leng);
+    const double mid = 0.5 * static_cast<double>( leng - 1);
+    double sum = 0.;
+    for( uint64_t w = 0; w < leng; ++w) {
+        const double x = static_cast<double>( w) - mid;
+        const double sinc = x == 0. ? 2. * rel_cutoff : std::sin( 2. * M_PI * rel_cutoff * x) / ( M_PI * x);
+        taps[ w] = sinc * window( win, w, leng, beta);
+        sum += taps[ w];
+    }
+    std::vector<float> out( leng);
+    for( uint64_t w = 0; w < leng; ++w) out[ w] = static_cast<float>( taps[ w] / sum);
+    return out;
+}
+
+/// @brief Kaiser-Tiefpass: Durchlass bis rel_passband, Sperrbereich ab rel_passband +
+///        rel_transition mit atten_db Daempfung, die Laenge folgt daraus
+inline std::vector<float>
+lowPass( double rel_passband, double rel_transition, double atten_db) {
+    return lowPass( rel_passband + 0.5 * rel_transition, kaiserLength( atten_db, rel_transition),
+                    Window::Kaiser, kaiserBeta( atten_db));
+}
+
+/// @brief verschiebt einen Tiefpass nach rel_center (-0.5 .. 0.5): komplexer Bandpass,
+///        der nur die eine Seite des Spektrums durchlaesst. Phase 0 in der Filtermitte.
+inline std::vector<std::complex<float>>
+shift( const std::vector<float> &low_pass, double rel_center) {
+    std::vector<std::complex<float>> out( low_pass.size());
+    const double mid = 0.5 * static_cast<double>( low_pass.size() - 1);
+    for( uint64_t w = 0; w < low_pass.size(); ++w)
+        out[ w] = std::complex<float>( std::polar( static_cast<double>( low_pass[ w]),
+                                                   2. * M_PI * rel_center * ( static_cast<double>( w) - mid)));
+    return out;
+}
+
+/// @brief komplexer Bandpass um rel_center mit der Breite rel_bandwidth (Durchlass),
+///        Uebergang und Daempfung wie beim Kaiser-Tiefpass
+inline std::vector<std::complex<float>>
+bandPass( double rel_center, double rel_bandwidth, double rel_transition, double atten_db) {
+    return shift( lowPass( 0.5 * rel_bandwidth, rel_transition, atten_db), rel_center);
+}
+
+
+namespace detail {
+
+// Faltung in Direktform: y[ n] = sum_k rev[ k] * x[ n + k], rev = umgekehrte Taps,
+// x beginnt mit den ntaps - 1 Werten vor y[ 0]
+
+inline void
+convolveScalar( const float *rev, uint64_t ntaps, const std::complex<float> *x,
+                std::complex<float> *y, uint64_t begin, uint64_t count) {
+    for( uint64_t n = begin; n < count; ++n) {
+        float re = 0.f, im = 0.f;
+        for( uint64_t k = 0; k < ntaps; ++k) {
+            re += rev[ k] * x[ n + k].real();
+            im += rev[ k] * x[ n + k].imag();
+        }
+        y[ n] = { re, im};
+    }
+}
+
+inline void
+convolveScalar( const float *rev_re, const float *rev_im, uint64_t ntaps, const std::complex<float> *x,
+                std::complex<float> *y, uint64_t begin, uint64_t count) {
+    for( uint64_t n = begin; n < count; ++n) {
+        float re = 0.f, im = 0.f;
+        for( uint64_t k = 0; k < ntaps; ++k) {
+            re += rev_re[ k] * x[ n + k].real() - rev_im[ k] * x[ n + k].imag();
+            im += rev_re[ k] * x[ n + k].imag() + rev_im[ k] * x[ n + k].real();
+        }
+        y[ n] = { re, im};
+    }
+}
+
+#if defined( __x86_64__) || defined( __i386__)
+
+// je Tap ein Broadcast, je Register mehrere aufeinanderfolgende Ausgangswerte
+
+__attribute__(( target( "sse2"))) inline void
+convolveSSE2( const float *rev, uint64_t ntaps, const std::complex<float> *x,
+              std::complex<float> *y, uint64_t count) {
+    const float *in = reinterpret_cast<const float*>( x);
+    float *out = reinterpret_cast<float*>( y);
+    uint64_t n = 0;
+    for( ; n + 4 <= count; n += 4) {
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+        const float *xn = in + 2 * n;
+        for( uint64_t k = 0; k < ntaps; ++k) {
+            const __m128 tap = _mm_set1_ps( rev[ k]);
+            acc0 = _mm_add_ps( acc0, _mm_mul_ps( tap, _mm_loadu_ps( xn + 2 * k)));
+            acc1 = _mm_add_ps( acc1, _mm_mul_ps( tap, _mm_loadu_ps( xn + 2 * k + 4)));
+        }
+        _mm_storeu_ps( out + 2 * n, acc0);
+        _mm_storeu_ps( out + 2 * n + 4, acc1);
+    }
+    convolveScalar( rev, ntaps, x, y, n, count);
+}
+
+__attribute__(( target( "avx2,fma"))) inline void
+convolveAVX2( const float *rev, uint64_t ntaps, const std::complex<float> *x,
+              std::complex<float> *y, uint64_t count) {
+    const float *in = reinterpret_cast<const float*>( x);
+    float *out = reinterpret_cast<float*>( y);
+    uint64_t n = 0;
+    for( ; n + 8 <= count; n += 8) {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        const float *xn = in + 2 * n;
+        for( uint64_t k = 0; k < ntaps; ++k) {
+            const __m256 tap = _mm256_broadcast_ss( rev + k);
+            acc0 = _mm256_fmadd_ps( tap, _mm256_loadu_ps( xn + 2 * k), acc0);
+            acc1 = _mm256_fmadd_ps( tap, _mm256_loadu_ps( xn + 2 * k + 8), acc1);
+        }
+        _mm256_storeu_ps( out + 2 * n, acc0);
+        _mm256_storeu_ps( out + 2 * n + 8, acc1);
+    }
+    convolveScalar( rev, ntaps, x, y, n, count);
+}
+
+__attribute__(( target( "avx512f"))) inline void
+convolveAVX512( const float *rev, uint64_t ntaps, const std::complex<float> *x,
+                std::complex<float> *y, uint64_t count) {
+    const float *in = reinterpret_cast<const float*>( x);
+    float *out = reinterpret_cast<float*>( y);
+    uint64_t n = 0;
+    for( ; n + 16 <= count; n += 16) {
+        __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+        const float *xn = in + 2 * n;
+        for( uint64_t k = 0; k < ntaps; ++k) {
+            const __m512 tap = _mm512_set1_ps( rev[ k]);
+            acc0 = _mm512_fmadd_ps( tap, _mm512_loadu_ps( xn + 2 * k), acc0);
+            acc1 = _mm512_fmadd_ps( tap, _mm512_loadu_ps( xn + 2 * k + 16), acc1);
+        }
+        _mm512_storeu_ps( out + 2 * n, acc0);
+        _mm512_storeu_ps( out + 2 * n + 16, acc1);
+    }
+    convolveScalar( rev, ntaps, x, y, n, count);
+}
+
+// komplexe Taps: acc_re += re( h) * x, acc_im += im( h) * ( x.imag, x.real),
+// y = acc_re + ( -1, +1) * acc_im
+
+__attribute__(( target( "sse2"))) inline void
+convolveSSE2( const float *rev_re, const float *rev_im, uint64_t ntaps, const std::complex<float> *x,
+              std::complex<float> *y, uint64_t count) {
+    const float *in = reinterpret_cast<const float*>( x);
+    float *out = reinterpret_cast<float*>( y);
+    const __m128 sign = _mm_setr_ps( -1.f, 1.f, -1.f, 1.f);
+    uint64_t n = 0;
+    for( ; n + 2 <= count; n += 2) {
+        __m128 acc_re = _mm_setzero_ps(), acc_im = _mm_setzero_ps();
+        const float *xn = in + 2 * n;
+        for( uint64_t k = 0; k < ntaps; ++k) {
+            const __m128 val = _mm_loadu_ps( xn + 2 * k);
+            acc_re = _mm_add_ps( acc_re, _mm_mul_ps( _mm_set1_ps( rev_re[ k]), val));
+            acc_im = _mm_add_ps( acc_im, _mm_mul_ps( _mm_set1_ps( rev_im[ k]), _mm_shuffle_ps( val, val, 0xb1)));
+        }
+        _mm_storeu_ps( out + 2 * n, _mm_add_ps( acc_re, _mm_mul_ps( sign, acc_im)));
+    }
+    convolveScalar( rev_re, rev_im, ntaps, x, y, n, count);
+}
+
+__attribute__(( target( "avx2,fma"))) inline void
+convolveAVX2( const float *rev_re, const float *rev_im, uint64_t ntaps, const std::complex<float> *x,
+              std::complex<float> *y, uint64_t count) {
+    const float *in = reinterpret_cast<const float*>( x);
+    float *out = reinterpret_cast<float*>( y);
+    uint64_t n = 0;
+    for( ; n + 4 <= count; n += 4) {
+        __m256 acc_re = _mm256_setzero_ps(), acc_im = _mm256_setzero_ps();
+        const float *xn = in + 2 * n;
+        for( uint64_t k = 0; k < ntaps; ++k) {
+            const __m256 val = _mm256_loadu_ps( xn + 2 * k);
+            acc_re = _mm256_fmadd_ps( _mm256_broadcast_ss( rev_re + k), val, acc_re);
+            acc_im = _mm256_fmadd_ps( _mm256_broadcast_ss( rev_im + k), _mm256_permute_ps( val, 0xb1), acc_im);
+        }
+        _mm256_storeu_ps( out + 2 * n, _mm256_addsub_ps( acc_re, acc_im));
+    }
+    convolveScalar( rev_re, rev_im, ntaps, x, y, n, count);
+}
+
+__attribute__(( target( "avx512f"))) inline void
+convolveAVX512( const float *rev_re, const float *rev_im, uint64_t ntaps, const std::complex<float> *x,
+                std::complex<float> *y, uint64_t count) {
+    const float *in = reinterpret_cast<const float*>( x);
+    float *out = reinterpret_cast<float*>( y);
+    const __m512 sign = _mm512_setr_ps( -1.f, 1.f, -1.f, 1.f, -1.f, 1.f, -1.f, 1.f,
+                                        -1.f, 1.f, -1.f, 1.f, -1.f, 1.f, -1.f, 1.f);
+    uint64_t n = 0;
+    for( ; n + 8 <= count; n += 8) {
+        __m512 acc_re = _mm512_setzero_ps(), acc_im = _mm512_setzero_ps();
+        const float *xn = in + 2 * n;
+        for( uint64_t k = 0; k < ntaps; ++k) {
+            const __m512 val = _mm512_loadu_ps( xn + 2 * k);
+            acc_re = _mm512_fmadd_ps( _mm512_set1_ps( rev_re[ k]), val, acc_re);
+            acc_im = _mm512_fmadd_ps( _mm512_set1_ps( rev_im[ k]), _mm512_permute_ps( val, 0xb1), acc_im);
+        }
+        _mm512_storeu_ps( out + 2 * n, _mm512_fmadd_ps( sign, acc_im, acc_re));
+    }
+    convolveScalar( rev_re, rev_im, ntaps, x, y, n, count);
+}
+
+#endif
+
+inline void
+convolve( const float *rev, uint64_t ntaps, const std::complex<float> *x,
+          std::complex<float> *y, uint64_t count) {
+#if defined( __x86_64__) || defined( __i386__)
+    switch( Simd::level()) {
+    case Simd::Level::AVX512: convolveAVX512( rev, ntaps, x, y, count); return;
+    case Simd::Level::AVX2:   convolveAVX2( rev, ntaps, x, y, count); return;
+    case Simd::Level::SSE2:   convolveSSE2( rev, ntaps, x, y, count); return;
+    default: break;
+    }
+#endif
+    convolveScalar( rev, ntaps, x, y, 0, count);
+}
+
+inline void
+convolve( const float *rev_re, const float *rev_im, uint64_t ntaps, const std::complex<float> *x,
+          std::complex<float> *y, uint64_t count) {
+#if defined( __x86_64__) || defined( __i386__)
+    switch( Simd::level()) {
+    case Simd::Level::AVX512: convolveAVX512( rev_re, rev_im, ntaps, x, y, count); return;
+    case Simd::Level::AVX2:   convolveAVX2( rev_re, rev_im, ntaps, x, y, count); return;
+    case Simd::Level::SSE2:   convolveSSE2( rev_re, rev_im, ntaps, x, y, count); return;
+    default: break;
+    }
+#endif
+    convolveScalar( rev_re, rev_im, ntaps, x, y, 0, count);
+}
+
+}
+}
+
+
+/// @brief FIR-Filter fuer einen fortlaufenden Strom complex<float>, beliebige Blockgroessen,
+///        jeder Eingangswert ergibt genau einen Ausgangswert (Gruppenlaufzeit delay()).
+///        Kurze Filter rechnen in Direktform (Vektor-Kernel zur Laufzeit gewaehlt), lange per
+///        Overlap-Save mit den Plaenen aus FFTPlanCache: FFT-Laenge N, je Transformation
+///        N - taps + 1 neue Werte; ein angebrochener Rest am Blockende wird mit Nullen
+///        aufgefuellt gerechnet (die Faltung ist kausal), es entsteht keine zusaetzliche
+///        Verzoegerung.
+///        Tap: float (Tiefpass) oder std::complex<float> (Bandpass, siehe Fir::shift())
+template <typename Tap = float>
+class FirFilter {
+    static_assert( std::is_same_v<Tap, float> || std::is_same_v<Tap, std::complex<float>>,
+                   "FirFilter: Tap muss float oder std::complex<float> sein");
+public:
+    enum class Mode {
+        Auto,       // Direktform bis directMaxTaps(), sonst FFT
+        Direct,
+        Fft
+    };
+
+    /// @brief Grenze fuer Mode::Auto je Vektor-Stufe; gemessen liegen beide Verfahren mit
+    ///        AVX2 bei etwa 128 reellen bzw. 64 komplexen Taps gleichauf, komplexe Taps
+    ///        kosten in Direktform das Doppelte
+    static uint64_t directMaxTaps() {
+        uint64_t taps = 32;
+        switch( Simd::level()) {
+        case Simd::Level::AVX512: taps = 192; break;
+        case Simd::Level::AVX2:   taps = 128; break;
+        case Simd::Level::SSE2:   taps = 64; break;
+        default: break;
+        }
+        return std::is_same_v<Tap, float> ? taps : taps / 2;
+    }
+
+private:
+    std::vector<Tap> _taps;
+    Mode _mode;
+    bool _use_fft;
+    uint64_t _fft_leng_set;
+
+    // Direktform: umgekehrte Taps, bei komplexen Taps Real- und Imaginaerteil getrennt
+    std::vector<float> _rev_re, _rev_im;
+    // Overlap-Save: Spektrum der Taps, Arbeitspuffer
+    FFT _fft;
+    std::vector<std::complex<float>> _spectrum, _work;
+    // taps - 1 alte Werte, dahinter der neue Block
+    std::vector<std::complex<float>> _history;
+
+    void prepare() {
+        const uint64_t ntaps = _taps.size();
+        _use_fft = _mode == Mode::Fft || ( _mode == Mode::Auto && ntaps > directMaxTaps());
+        _rev_re.resize( ntaps);
+        _rev_im.assign( ntaps, 0.f);
+        for( uint64_t k = 0; k < ntaps; ++k) {
+            if constexpr( std::is_same_v<Tap, float>) {
+                _rev_re[ k] = _taps[ ntaps - 1 - k];
+            }
+            else {
+                _rev_re[ k] = _taps[ ntaps - 1 - k].real();
+                _rev_im[ k] = _taps[ ntaps - 1 - k].imag();
+            }
+        }
+        if( _use_fft) {
+            // je Transformation mindestens 3/4 neue Werte, kurze FFTs lohnen den Aufruf nicht
+            uint64_t leng = _fft_leng_set ? _fft_leng_set
+                                          : std::max<uint64_t>( 1024, uint64_t( 1) << Tools::nextPow2( 4 * ntaps));
+            leng = std::max<uint64_t>( leng, uint64_t( 1) << Tools::nextPow2( 2 * ntaps));
+            _fft.setLeng( leng);
+            _spectrum.assign( leng, std::complex<float>( 0, 0));
+            for( uint64_t k = 0; k < ntaps; ++k) _spectrum[ k] = std::complex<float>( _taps[ k]);
+            _fft.fft( _spectrum.data(), _spectrum.data());
+            _work.resize( leng);
+        }
+        reset();
+    }
+
+    /// @brief Overlap-Save ueber _history, count neue Werte
+    void processFft( std::complex<float> *out, uint64_t count) {
+        const uint64_t leng = _fft.leng();
+        const uint64_t keep = _taps.size() - 1;
+        const uint64_t step = leng - keep;
+        for( uint64_t pos = 0; pos < count; pos += step) {
+            const uint64_t fresh = std::min( step, count - pos);
+            const std::complex<float> *in = _history.data() + pos;
+            std::copy( in, in + keep + fresh, _work.begin());
+            std::fill( _work.begin() + keep + fresh, _work.end(), std::complex<float>( 0, 0));
+            _fft.fft( _work.data(), _work.data());
+            // ausgeschrieben, std::complex-Multiplikation ruft ohne -ffast-math __mulsc3
+            for( uint64_t w = 0; w < leng; ++w) {
+                const float re = _work[ w].real(), im = _work[ w].imag();
+                const float s_re = _spectrum[ w].real(), s_im = _spectrum[ w].imag();
+                _work[ w] = { re * s_re - im * s_im, re * s_im + im * s_re};
+            }
+            _fft.ifft( _work.data(), _work.data());
+            // die ersten taps - 1 Werte sind zyklisch verfaelscht
+            std::copy( _work.begin() + keep, _work.begin() + keep + fresh, out + pos);
+        }
+    }
+
+public:
+    FirFilter( const std::vector<Tap> &taps = { Tap( 1)}, Mode mode = Mode::Auto)
+        : _mode( mode), _use_fft( false), _fft_leng_set( 0) {
+        setTaps( taps);
+    }
+
+    /// @brief neue Taps, verwirft den Filterzustand
+    void setTaps( const std::vector<Tap> &taps) {
+        if( taps.empty()) throw std::invalid_argument( "FEHLER FirFilter::setTaps(): keine Taps");
+        _taps = taps;
+        prepare();
+    }
+    /// @brief Rechenweg, verwirft den Filterzustand
+    void setMode( Mode mode) {
+        _mode = mode;
+        prepare();
+    }
+    /// @brief FFT-Laenge fuer Overlap-Save (mindestens 2 * taps), 0: 4 * taps, wenigstens 1024
+    void setFftLeng( uint64_t leng) {
+        _fft_leng_set = leng;
+        prepare();
+    }
+
+    void reset() {
+        _history.assign( _taps.size() - 1, std::complex<float>( 0, 0));
+    }
+
+    const std::vector<Tap>& taps() const { return _taps;}
+    /// @brief Gruppenlaufzeit symmetrischer Filter in Abtastwerten
+    double delay() const { return 0.5 * static_cast<double>( _taps.size() - 1);}
+    bool isFft() const { return _use_fft;}
+    uint64_t fftLeng() const { return _use_fft ? _fft.leng() : 0;}
+
+    /// @brief filtert input, haengt leng Werte an output an (input darf nicht in output liegen)
+    void process( const std::complex<float> *input, uint64_t leng, std::vector<std::complex<float>> &output) {
+        if( ! leng) return;
+        const uint64_t keep = _taps.size() - 1;
+        _history.insert( _history.end(), input, input + leng);
+        const uint64_t offset = output.size();
+        output.resize( offset + leng);
+        std::complex<float> *out = output.data() + offset;
+
+        if( _use_fft)
+            processFft( out, leng);
+        else if constexpr( std::is_same_v<Tap, float>)
+            Fir::detail::convolve( _rev_re.data(), _taps.size(), _history.data(), out, leng);
+        else
+            Fir::detail::convolve( _rev_re.data(), _rev_im.data(), _taps.size(), _history.data(), out, leng);
+
+        // die letzten taps - 1 Werte fuer den naechsten Block behalten
+        std::copy( _history.end() - keep, _history.end(), _history.begin());
+        _history.resize( keep);
+    }
+    void process( const std::vector<std::complex<float>> &input, std::vector<std::complex<float>> &output) {
+        process( input.data(), input.size(), output);
+    }
+};
+
+#endif // FIRFILTER_HPP
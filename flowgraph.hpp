@@ -0,0 +1,113 @@
+#ifndef FLOWGRAPH_HPP
+#define FLOWGRAPH_HPP
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <complex>
+
+#include "sampleblock.hpp"
+#include "ports.hpp"
+#include "baseprocessor.hpp"
+
+
+/// @brief Knoten, der eine beliebige Senke (z.B. Datei oder UDP) in einem eigenen Thread
+///        bedient - eine langsame Senke haelt damit weder den USB-Thread noch andere
+///        Senken auf.
+template <typename T>
+class BasicFunctionSink : public BasicProcessor<T> {
+    std::function<void( const T &)> _func;
+
+    void process( const T &input) override {
+        _func( input);
+    }
+
+public:
+    BasicFunctionSink( const std::function<void( const T &)> &func, uint64_t capacity = 256,
+                       ProcessorNode::Overflow policy = ProcessorNode::Overflow::DropNewest)
+        : BasicProcessor<T>( capacity, policy), _func( func) {}
+    ~BasicFunctionSink() {
+        this->stop();
+    }
+};
+
+using FunctionSink = BasicFunctionSink<SampleBlockPtr<std::complex<float>>>;
+
+
+/// @brief Datenflussgraph: haelt die Knoten, verbindet typisierte Ports und startet bzw.
+///        stoppt alle Knoten gemeinsam. Jede Verbindung endet in der Warteschlange und dem
+///        Thread des Zielknotens. Kommt ohne Qt aus, damit dieselbe Kette auch ohne GUI laeuft.
+class FlowGraph {
+    std::vector<std::shared_ptr<ProcessorNode>> _nodes;
+    std::vector<std::function<void()>> _disconnects;
+    bool _running;
+
+public:
+    FlowGraph() : _running( false) {}
+    FlowGraph( const FlowGraph &) = delete;
+    FlowGraph& operator =( const FlowGraph &) = delete;
+    ~FlowGraph() {
+        disconnectAll();
+        stop();
+    }
+
+    /// @brief legt einen Knoten an, der vom Graphen gehalten wird
+    template <class Node, class... Args>
+    std::shared_ptr<Node>
+    addNode( Args&&... args) {
+        std::shared_ptr<Node> node = std::make_shared<Node>( std::forward<Args>( args)...);
+        addNode( node);
+        return node;
+    }
+    void addNode( const std::shared_ptr<ProcessorNode> &node) {
+        _nodes.push_back( node);
+        if( _running) node->start();
+    }
+
+    /// @brief legt eine Senke mit eigener Warteschlange und eigenem Thread an
+    std::shared_ptr<FunctionSink>
+    addSink( const std::function<void( const SampleBlockPtr<std::complex<float>> &)> &func,
+             uint64_t capacity = 256,
+             BaseProcessor::Overflow policy = BaseProcessor::Overflow::DropNewest) {
+        return addNode<FunctionSink>( func, capacity, policy);
+    }
+    /// @brief Senke fuer andere Datentypen, z.B. die rohen int16-Bloecke der Quelle
+    template <typename T>
+    std::shared_ptr<BasicFunctionSink<T>>
+    addSink( const std::function<void( const T &)> &func,
+             uint64_t capacity = 256,
+             ProcessorNode::Overflow policy = ProcessorNode::Overflow::DropNewest) {
+        return addNode<BasicFunctionSink<T>>( func, capacity, policy);
+    }
+
+    /// @brief verbindet einen Ausgang mit einem Eingang gleichen Typs
+    template <typename T>
+    void connect( OutputPort<T> &output, InputPort<T> &input) {
+        output.connect( input);
+        _disconnects.push_back( [ &output, &input] { output.disconnect( input);});
+    }
+
+    /// @brief loest alle ueber den Graphen hergestellten Verbindungen
+    void disconnectAll() {
+        for( auto &disconnect : _disconnects)
+            disconnect();
+        _disconnects.clear();
+    }
+
+    void start() {
+        for( auto &node : _nodes)
+            node->start();
+        _running = true;
+    }
+
+    void stop() {
+        for( auto &node : _nodes)
+            node->stop();
+        _running = false;
+    }
+
+    bool isRunning() const { return _running;}
+    const std::vector<std::shared_ptr<ProcessorNode>>& nodes() const { return _nodes;}
+};
+
+#endif // FLOWGRAPH_HPP
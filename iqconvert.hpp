@@ -0,0 +1,256 @@
+#ifndef IQCONVERT_HPP
+#define IQCONVERT_HPP
+
+#include <complex>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined( __x86_64__) || defined( __i386__)
+#include <immintrin.h>
+#endif
+
+#include "simd.hpp"
+
+
+/// @brief Wandlung int16 IQ -> complex<float> in einem Durchlauf:
+///        x = I * scale - dc_i
+///        y = Q * scale - dc_q
+///        out = x + j * ( quad_gain * y + cross * x)
+///        Der Vektor-Kernel wird zur Laufzeit gewaehlt (AVX-512, AVX2, SSE2, skalar).
+namespace IQConvert {
+
+/// @brief Koeffizienten des fusionierten Kernels
+struct Coefficients {
+    float scale     = 1.f / static_cast<float>( std::numeric_limits<int16_t>::max());
+    float dc_i      = 0.f;
+    float dc_q      = 0.f;
+    float cross     = 0.f;  // Phasenkorrektur:  -tan( phi)
+    float quad_gain = 1.f;  // Amplitudenkorrektur: 1 / ( g * cos( phi))
+};
+
+namespace detail {
+
+/// @brief sums[0/1] erhalten die Summe von I * scale bzw. Q * scale (fuer die DC-Schaetzung)
+inline void
+convertScalar( const std::complex<int16_t> *input, std::complex<float> *output, uint64_t leng,
+               const Coefficients &co, float *sums) {
+    float sum_i = 0.f, sum_q = 0.f;
+    for( uint64_t w = 0; w < leng; ++w) {
+        const float i = static_cast<float>( input[ w].real()) * co.scale;
+        const float q = static_cast<float>( input[ w].imag()) * co.scale;
+        sum_i += i;
+        sum_q += q;
+        const float x = i - co.dc_i;
+        const float y = q - co.dc_q;
+        output[ w] = std::complex<float>( x, co.quad_gain * y + co.cross * x);
+    }
+    sums[ 0] += sum_i;
+    sums[ 1] += sum_q;
+}
+
+#if defined( __x86_64__) || defined( __i386__)
+
+__attribute__(( target( "sse2"))) inline void
+convertSSE2( const std::complex<int16_t> *input, std::complex<float> *output, uint64_t leng,
+             const Coefficients &co, float *sums) {
+    const __m128 scale = _mm_set1_ps( co.scale);
+    const __m128 dc    = _mm_setr_ps( co.dc_i, co.dc_q, co.dc_i, co.dc_q);
+    const __m128 gain  = _mm_setr_ps( 1.f, co.quad_gain, 1.f, co.quad_gain);
+    const __m128 cross = _mm_setr_ps( 0.f, co.cross, 0.f, co.cross);
+    __m128 acc = _mm_setzero_ps();
+
+    uint64_t w = 0;
+    for( ; w + 4 <= leng; w += 4) {
+        const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + w));
+        // int16 -> int32 mit Vorzeichen (SSE2 kennt kein cvtepi16)
+        const __m128i raw[ 2] = { _mm_srai_epi32( _mm_unpacklo_epi16( v, v), 16),
+                                  _mm_srai_epi32( _mm_unpackhi_epi16( v, v), 16)};
+        float *out = reinterpret_cast<float*>( output + w);
+        for( int x = 0; x < 2; ++x) {
+            __m128 t = _mm_mul_ps( _mm_cvtepi32_ps( raw[ x]), scale);     // [I0 Q0 I1 Q1]
+            acc = _mm_add_ps( acc, t);
+            t = _mm_sub_ps( t, dc);
+            const __m128 dup_i = _mm_shuffle_ps( t, t, _MM_SHUFFLE( 2, 2, 0, 0));
+            _mm_storeu_ps( out + 4 * x, _mm_add_ps( _mm_mul_ps( t, gain), _mm_mul_ps( dup_i, cross)));
+        }
+    }
+
+    alignas( 16) float part[ 4];
+    _mm_store_ps( part, acc);
+    sums[ 0] += part[ 0] + part[ 2];
+    sums[ 1] += part[ 1] + part[ 3];
+    convertScalar( input + w, output + w, leng - w, co, sums);
+}
+
+__attribute__(( target( "avx2,fma"))) inline void
+convertAVX2( const std::complex<int16_t> *input, std::complex<float> *output, uint64_t leng,
+             const Coefficients &co, float *sums) {
+    const __m256 scale = _mm256_set1_ps( co.scale);
+    const __m256 dc    = _mm256_setr_ps( co.dc_i, co.dc_q, co.dc_i, co.dc_q,
+                                         co.dc_i, co.dc_q, co.dc_i, co.dc_q);
+    const __m256 gain  = _mm256_setr_ps( 1.f, co.quad_gain, 1.f, co.quad_gain,
+                                         1.f, co.quad_gain, 1.f, co.quad_gain);
+    const __m256 cross = _mm256_setr_ps( 0.f, co.cross, 0.f, co.cross,
+                                         0.f, co.cross, 0.f, co.cross);
+    __m256 acc = _mm256_setzero_ps();
+
+    uint64_t w = 0;
+    for( ; w + 4 <= leng; w += 4) {
+        const __m128i raw = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + w));
+        __m256 t = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( raw)), scale);
+        acc = _mm256_add_ps( acc, t);
+        t = _mm256_sub_ps( t, dc);
+        const __m256 dup_i = _mm256_shuffle_ps( t, t, _MM_SHUFFLE( 2, 2, 0, 0));
+        _mm256_storeu_ps( reinterpret_cast<float*>( output + w),
+                          _mm256_fmadd_ps( dup_i, cross, _mm256_mul_ps( t, gain)));
+    }
+
+    alignas( 32) float part[ 8];
+    _mm256_store_ps( part, acc);
+    sums[ 0] += part[ 0] + part[ 2] + part[ 4] + part[ 6];
+    sums[ 1] += part[ 1] + part[ 3] + part[ 5] + part[ 7];
+    convertScalar( input + w, output + w, leng - w, co, sums);
+}
+
+__attribute__(( target( "avx512f"))) inline void
+convertAVX512( const std::complex<int16_t> *input, std::complex<float> *output, uint64_t leng,
+               const Coefficients &co, float *sums) {
+    const __m512 scale = _mm512_set1_ps( co.scale);
+    const __m512 dc    = _mm512_setr_ps( co.dc_i, co.dc_q, co.dc_i, co.dc_q,
+                                         co.dc_i, co.dc_q, co.dc_i, co.dc_q,
+                                         co.dc_i, co.dc_q, co.dc_i, co.dc_q,
+                                         co.dc_i, co.dc_q, co.dc_i, co.dc_q);
+    const __m512 gain  = _mm512_setr_ps( 1.f, co.quad_gain, 1.f, co.quad_gain,
+                                         1.f, co.quad_gain, 1.f, co.quad_gain,
+                                         1.f, co.quad_gain, 1.f, co.quad_gain,
+                                         1.f, co.quad_gain, 1.f, co.quad_gain);
+    const __m512 cross = _mm512_setr_ps( 0.f, co.cross, 0.f, co.cross,
+                                         0.f, co.cross, 0.f, co.cross,
+                                         0.f, co.cross, 0.f, co.cross,
+                                         0.f, co.cross, 0.f, co.cross);
+    __m512 acc = _mm512_setzero_ps();
+
+    uint64_t w = 0;
+    for( ; w + 8 <= leng; w += 8) {
+        const __m256i raw = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( input + w));
+        __m512 t = _mm512_mul_ps( _mm512_cvtepi32_ps( _mm512_cvtepi16_epi32( raw)), scale);
+        acc = _mm512_add_ps( acc, t);
+        t = _mm512_sub_ps( t, dc);
+        const __m512 dup_i = _mm512_shuffle_ps( t, t, _MM_SHUFFLE( 2, 2, 0, 0));
+        _mm512_storeu_ps( reinterpret_cast<float*>( output + w),
+                          _mm512_fmadd_ps( dup_i, cross, _mm512_mul_ps( t, gain)));
+    }
+
+    alignas( 64) float part[ 16];
+    _mm512_store_ps( part, acc);
+    for( int x = 0; x < 16; x += 2) {
+        sums[ 0] += part[ x];
+        sums[ 1] += part[ x + 1];
+    }
+    convertScalar( input + w, output + w, leng - w, co, sums);
+}
+
+#endif
+
+}
+
+
+/// @brief fusionierte Wandlung mit Kernelwahl zur Laufzeit
+/// @param sums optional: Summe der skalierten I/Q Werte vor der DC-Korrektur
+inline void
+convert( const std::complex<int16_t> *input, std::complex<float> *output, uint64_t leng,
+         const Coefficients &co, float *sums = nullptr) {
+    float unused[ 2] = { 0.f, 0.f};
+    if( ! sums) sums = unused;
+#if defined( __x86_64__) || defined( __i386__)
+    switch( Simd::level()) {
+    case Simd::Level::AVX512: detail::convertAVX512( input, output, leng, co, sums); return;
+    case Simd::Level::AVX2:   detail::convertAVX2( input, output, leng, co, sums); return;
+    case Simd::Level::SSE2:   detail::convertSSE2( input, output, leng, co, sums); return;
+    default: break;
+    }
+#endif
+    detail::convertScalar( input, output, leng, co, sums);
+}
+
+}
+
+
+/// @brief Haelt die Korrekturwerte eines Empfangspfades und schaetzt bei Bedarf den
+///        DC-Anteil fortlaufend aus den gewandelten Bloecken (IIR erster Ordnung).
+///        Die Setter duerfen aus einem anderen Thread kommen als convert(): jeder Block
+///        rechnet mit einer Kopie der Koeffizienten, die unter dem Mutex entsteht.
+class IQConverter {
+    IQConvert::Coefficients _co;
+    float _dc_alpha;        // 0: DC-Nachfuehrung aus
+    mutable std::mutex _mutexer;
+
+public:
+    IQConverter( float scale = 1.f / static_cast<float>( std::numeric_limits<int16_t>::max()))
+        : _dc_alpha( 0.f) {
+        _co.scale = scale;
+    }
+
+    void setScale( float scale) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _co.scale = scale;
+    }
+
+    /// @brief fester DC-Anteil (bereits skaliert)
+    void setDCOffset( std::complex<float> dc) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _co.dc_i = dc.real();
+        _co.dc_q = dc.imag();
+    }
+    std::complex<float> getDCOffset() const {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return { _co.dc_i, _co.dc_q};
+    }
+
+    /// @brief DC-Anteil je Block nachfuehren
+    /// @param alpha Gewicht des aktuellen Blocks ( 0: aus, 1: nur aktueller Block)
+    void setDCTracking( float alpha) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _dc_alpha = std::clamp( alpha, 0.f, 1.f);
+    }
+
+    /// @brief IQ-Ungleichgewicht korrigieren
+    /// @param gain Verstaerkung Q relativ zu I (linear)
+    /// @param phase Phasenfehler von Q [rad]
+    void setIQImbalance( float gain, float phase) {
+        if( gain <= 0.f) throw std::invalid_argument( "FEHLER IQConverter::setIQImbalance(): gain <= 0");
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _co.cross     = -std::tan( phase);
+        _co.quad_gain = 1.f / ( gain * std::cos( phase));
+    }
+
+    IQConvert::Coefficients coefficients() const {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return _co;
+    }
+
+    void convert( const std::complex<int16_t> *input, std::complex<float> *output, uint64_t leng) {
+        if( ! leng) return;
+        IQConvert::Coefficients co;
+        float alpha;
+        {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            co = _co;
+            alpha = _dc_alpha;
+        }
+        float sums[ 2] = { 0.f, 0.f};
+        IQConvert::convert( input, output, leng, co, sums);
+        if( alpha > 0.f) {
+            const float inv = 1.f / static_cast<float>( leng);
+            std::lock_guard<std::mutex> lock( _mutexer);
+            _co.dc_i += alpha * ( sums[ 0] * inv - _co.dc_i);
+            _co.dc_q += alpha * ( sums[ 1] * inv - _co.dc_q);
+        }
+    }
+};
+
+#endif // IQCONVERT_HPP
@@ -8,13 +8,18 @@
 #include <libusb-1.0/libusb.h>
 #include <fstream>
 #include <atomic>
+#include <thread>
+#include <functional>
 #include <unistd.h>     // usleep()
 
+#include "sampleblock.hpp"
+#include "samplesource.hpp"
+
 #ifndef DEBUG_FUNCTION_CALL
 #define DEBUG_FUNCTION_CALL
 #endif
 
-class Mouse {
+class Mouse : public SampleSource {
 
 mutable std::mutex _mutexer;
 
@@ -69,11 +74,27 @@ enum
     CMD_I2C_RECEIVER_MAX3543 = 9
 };
 
+libusb_context *_ctx;
 libusb_device_handle *_mouse_dev;
 std::string _error = {};
 bool _mouse_is_receiver;
 bool _is_open;
 
+// asynchroner Streaming-Betrieb (libusb_submit_transfer)
+struct TransferSlot {
+    Mouse *maus;
+    libusb_transfer *transfer;
+    std::shared_ptr<SampleBlock<std::complex<int16_t>>> block; // wird von libusb befuellt
+};
+std::vector<TransferSlot> _transfers;
+std::unique_ptr<SampleBlockPool<std::complex<int16_t>>> _block_pool;
+StreamCallback _stream_callback;
+std::thread _event_thread;
+std::atomic_bool _is_async_streaming;
+std::atomic<int32_t> _active_transfers;
+std::atomic<uint64_t> _transfer_errors;
+uint64_t _stream_index;     // Stromposition des naechsten Blocks, nur im Event-Thread
+
 /// @brief Bettet ein Kommando in einen libusb_bulk_transfer ein und wertet den
 ///        return-Wert aus
 std::vector<unsigned char>
@@ -374,15 +395,84 @@ i2cCheckErrorCode(unsigned char i2c_error_code_byte) {
 //}
 
 
+/// @brief libusb ruft diese Funktion im Kontext des Event-Threads auf, sobald ein
+///        Transfer abgeschlossen wurde
+static void LIBUSB_CALL
+transferCallback( libusb_transfer *transfer) {
+    TransferSlot *slot = static_cast<TransferSlot*>( transfer->user_data);
+    slot->maus->handleTransfer( *slot);
+}
+
+/// @brief Reicht den gefuellten Block an den Verbraucher weiter, haengt einen
+///        frischen Block aus dem Pool ein und stellt den Transfer sofort wieder in
+///        die Warteschlange, damit der EP6 FIFO ohne Luecke geleert wird
+void
+handleTransfer( TransferSlot &slot) {
+    libusb_transfer *transfer = slot.transfer;
+    switch( transfer->status) {
+    case LIBUSB_TRANSFER_TIMED_OUT:
+        // zaehlt als Fehler, die bis dahin empfangenen Daten gehen aber weiter,
+        // sonst verschiebt sich die Stromposition aller folgenden Bloecke
+        ++_transfer_errors;
+        [[fallthrough]];
+    case LIBUSB_TRANSFER_COMPLETED:
+        if( transfer->actual_length > 0 && _stream_callback) {
+            slot.block->resize( transfer->actual_length / sizeof( std::complex<int16_t>));
+            slot.block->setIndex( _stream_index);
+            _stream_index += slot.block->size();
+            SampleBlockPtr<std::complex<int16_t>> filled = std::move( slot.block);
+            slot.block = _block_pool->acquire();
+            transfer->buffer = reinterpret_cast<unsigned char*>( slot.block->data());
+            _stream_callback( filled);
+        }
+        break;
+    case LIBUSB_TRANSFER_CANCELLED:
+        break;
+    default:
+        ++_transfer_errors;
+        break;
+    }
+
+    if( _is_async_streaming
+        && transfer->status != LIBUSB_TRANSFER_CANCELLED
+        && transfer->status != LIBUSB_TRANSFER_NO_DEVICE
+        && ! libusb_submit_transfer( transfer))
+        return;
+
+    // Transfer wird nicht erneut eingereiht
+    --_active_transfers;
+}
+
+/// @brief Event-Schleife des asynchronen Betriebs, laeuft bis alle Transfers
+///        zurueckgekehrt sind
+void
+handleEvents(void) {
+    while( _active_transfers > 0) {
+        timeval tv = { 0, 100000};
+        libusb_handle_events_timeout_completed( _ctx, &tv, nullptr);
+    }
+}
+
+/// @brief gibt alle Transfers und deren Puffer frei
+void
+freeTransfers(void) {
+    for( TransferSlot &slot : _transfers)
+        libusb_free_transfer( slot.transfer);
+    _transfers.clear();
+}
+
+
 public:
 
-bool isOpen() const { return _is_open;}
+bool isOpen() const override { return _is_open;}
 
-Mouse(void) : _mouse_is_receiver( true) , _is_open( false)
+Mouse(void) : _ctx( nullptr), _mouse_dev( nullptr), _mouse_is_receiver( true),
+    _is_open( false), _is_async_streaming( false), _active_transfers( 0),
+    _transfer_errors( 0), _stream_index( 0)
 {
 
 }
-~Mouse(void) {
+~Mouse(void) override {
     close();
 }
 
@@ -390,12 +480,10 @@ Mouse(void) : _mouse_is_receiver( true) , _is_open( false)
 
 /// @brief Versucht ein angeschlossene MOUSE zu oeffnen
 int
-open(void) {
-    libusb_context *ctx = NULL;
-
+open(void) override {
     int32_t return_value = 0;
     /* Pruefen, ob libsub-Sitzung initialisiert wurde.  */
-    if((return_value = libusb_init(&ctx))){
+    if((return_value = libusb_init(&_ctx))){
 #ifdef DEBUG
         throw std::runtime_error("FEHLER mouse::open(): "
                                 + std::string(libusb_error_name(return_value)));
@@ -407,7 +495,7 @@ open(void) {
     }
 
 
-    if( ! (_mouse_dev = libusb_open_device_with_vid_pid(ctx,
+    if( ! (_mouse_dev = libusb_open_device_with_vid_pid(_ctx,
                                                          MOUSE_VENDOR_ID,
                                                          MOUSE_PRODUCT_ID))) {
 #ifdef DEBUG
@@ -438,23 +526,28 @@ open(void) {
 }
 
 void
-close(void) {
+close(void) override {
+    stopAsyncStreaming();
     if(_is_open) {
         libusb_release_interface( _mouse_dev, 0);
         libusb_close( _mouse_dev);
         _is_open = false;
     }
+    if( _ctx) {
+        libusb_exit( _ctx);
+        _ctx = nullptr;
+    }
 }
 
-std::string getError(void) const {return _error;}
-std::vector<std::vector<uint32_t>> getFilter(void) { return i2cReadFilter();}
+std::string getError(void) const override {return _error;}
+std::vector<std::vector<uint32_t>> getFilter(void) override { return i2cReadFilter();}
 
 
 /// @brief Schaltet Tiefpass-Filter UND Samplerate um
 /// @brief Index des auf der MOUSE verfuegbaren Filter
 /// @return Abtastrate der Filtereinstellung
 int
-setFilter( uint32_t index) {
+setFilter( uint32_t index) override {
     if( ! _is_open) {return -1;}
     std::vector<unsigned char> buffer( 10, 0);
     i2cWriteData( 100);
@@ -483,7 +576,7 @@ setFilter( uint32_t index) {
 /// @brief Setzt zum einen die Mittenfrequenz und zum anderen die frequenzab.
 ///        Empfaenger
 void
-setCenterFrequency(int32_t frequency) {
+setCenterFrequency(int32_t frequency) override {
     frequency = std::min(1240000000, std::max(5000, frequency));
     std::vector<unsigned char> freq;
     freq.reserve( 4);
@@ -553,6 +646,7 @@ i2cReadFilter(void) {
 
 // 
 void setGPIFMode() { writeCommand(CMD_GPIF_MODE); }
+void setStreamingMode() override { setGPIFMode(); }
 void setIDLEMode() { writeCommand(CMD_IDLE_MODE); }
 void setSLAVEMode(){ writeCommand(CMD_SLAVE_MODE); }
 void setFIFOFlush(void) {writeCommand(CMD_SET_FIFO_FLUSH); }
@@ -586,6 +680,82 @@ streamData( std::vector<std::complex<int16_t>> &output) {
     return transfered / sizeof( std::complex<int16_t>);
 }
 
+/// @brief Startet den asynchronen Streaming-Betrieb: transfer_count Transfers sind
+///        permanent auf ENDPOINT_6_IN eingereiht, ein eigener Thread bearbeitet die
+///        libusb-Events. libusb schreibt direkt in Bloecke aus einem Pool, jeder
+///        gefuellte Block wird ohne Kopie und ohne Wartezeit an callback
+///        uebergeben [INT16, interleaved, also complex]. callback laeuft im
+///        Event-Thread und darf nicht blockieren, den Block aber beliebig lange halten.
+/// @param callback Verbraucher, laeuft im Event-Thread
+/// @param transfer_count Anzahl gleichzeitig eingereihter Transfers
+/// @param transfer_samples Abtastwerte je Transfer (Vielfaches von 128 -> 512 Byte)
+/// @return 0: alles normal, ERROR bei Fehlern (siehe getError())
+int
+startAsyncStreaming( const StreamCallback &callback,
+                     uint32_t transfer_count = 8, uint32_t transfer_samples = 16 * 1024) override {
+    if( ! _is_open || _is_async_streaming) return ERROR;
+    if( ! transfer_count || ! transfer_samples)
+        throw std::invalid_argument( "FEHLER Mouse::startAsyncStreaming(): "
+                                     "transfer_count/transfer_samples == 0");
+
+    _stream_callback = callback;
+    _transfer_errors = 0;
+    _stream_index = 0;
+    _block_pool = std::make_unique<SampleBlockPool<std::complex<int16_t>>>(
+                      transfer_samples, 4 * transfer_count);
+    _transfers.resize( transfer_count);
+    for( TransferSlot &slot : _transfers) {
+        slot.maus = this;
+        slot.block = _block_pool->acquire();
+        if( ! (slot.transfer = libusb_alloc_transfer( 0))) {
+            freeTransfers();
+            _error = "FEHLER Mouse::startAsyncStreaming(): libusb_alloc_transfer()";
+            return ERROR;
+        }
+        libusb_fill_bulk_transfer( slot.transfer, _mouse_dev, ENDPOINT_6_IN,
+                                   reinterpret_cast<unsigned char*>( slot.block->data()),
+                                   transfer_samples * sizeof( std::complex<int16_t>),
+                                   &Mouse::transferCallback, &slot, 1000);
+    }
+
+    _is_async_streaming = true;
+    for( TransferSlot &slot : _transfers) {
+        int return_value = libusb_submit_transfer( slot.transfer);
+        if( return_value) {
+            _error = "FEHLER Mouse::startAsyncStreaming(): libusb_submit_transfer() "
+                   + std::string( libusb_error_name( return_value));
+            break;
+        }
+        ++_active_transfers;
+    }
+    if( ! _active_transfers) {
+        _is_async_streaming = false;
+        freeTransfers();
+        return ERROR;
+    }
+
+    _event_thread = std::thread( &Mouse::handleEvents, this);
+    return SUCCESS;
+}
+
+/// @brief Bricht alle eingereihten Transfers ab und wartet auf den Event-Thread
+void
+stopAsyncStreaming(void) override {
+    if( ! _is_async_streaming) return;
+    _is_async_streaming = false;
+    for( TransferSlot &slot : _transfers)
+        libusb_cancel_transfer( slot.transfer);
+    if( _event_thread.joinable())
+        _event_thread.join();
+    freeTransfers();
+    _stream_callback = nullptr;
+}
+
+bool isAsyncStreaming() const override { return _is_async_streaming;}
+
+/// @brief Anzahl fehlgeschlagener Transfers seit startAsyncStreaming()
+uint64_t getTransferErrors() const override { return _transfer_errors;}
+
 /// @brief Gibt den index des MOUSE-Modi zurueck
 /// @return 1: CMD_IDLE, 2: CMD_GPIF
 unsigned char getCurrentMode() { return writeCommand( CMD_GET_MODE).at( 1);}
@@ -15,19 +15,56 @@ MainWindow::MainWindow(QWidget *parent)
     QObject::connect( maus_gui, &MouseGUI::centerFreqChanged, &wfv->_axis, &Axis::chaneCenterFreq);
     QObject::connect( maus_gui, &MouseGUI::bandwidthChanged, &wfv->_axis, &Axis::setBandwidth);
 
+    // Zoomansicht: Marker a/b in wfv oder zoom_view setzen, mittlere Maustaste zoomt, Doppelklick hebt auf
+    Sonarview *zoom_view = new Sonarview();
+    QObject::connect( maus_gui, &MouseGUI::centerFreqChanged, &zoom_view->_axis, &Axis::chaneCenterFreq);
+    QObject::connect( maus_gui, &MouseGUI::bandwidthChanged, &zoom_view->_axis, &Axis::setBandwidth);
+
     FileWriterWidget *fww = new FileWriterWidget;
+    QObject::connect( maus_gui, &MouseGUI::centerFreqChanged, fww, &FileWriterWidget::setCenterFrequency);
+    QObject::connect( maus_gui, &MouseGUI::bandwidthChanged, fww, &FileWriterWidget::setSampleRate);
     UDPSenderWidget *udp = new UDPSenderWidget;
+    QObject::connect( maus_gui, &MouseGUI::bandwidthChanged, udp, &UDPSenderWidget::setSampleRate);
+    QObject::connect( maus_gui, &MouseGUI::centerFreqChanged, udp, &UDPSenderWidget::setCenterFrequency);
+
+    // Aufnahme mit Vorlauf aus den rohen Bloecken, ausgeloest ueber fww
+    auto triggered = _graph.addNode<TriggeredRecorder<std::complex<int16_t>>>();
+    fww->setTriggeredRecorder( triggered);
+    _graph.connect( maus_gui->rawOutput(), *triggered);
 
+    // Datenfluss: jede Senke bekommt eigene Warteschlange und eigenen Thread
+    // eine STFT fuer alle Spektralanzeigen, 75% Ueberlappung
+    auto stft = _graph.addNode<StftProcessor>( 1024, 256, Stft::Window::VonHann, false);
+    _graph.connect( maus_gui->output(), *stft);
     wfv->startProcessing();
-    maus_gui->addStreamSink( std::bind( &Sonarview::dataIn, wfv, std::placeholders::_1));
-    maus_gui->addStreamSink( std::bind( &FileWriterWidget::writeToFile, fww, std::placeholders::_1));
-    maus_gui->addStreamSink( std::bind( &UDPSenderWidget::sendData<std::complex<float>>, udp, std::placeholders::_1));
+    _graph.connect( stft->output(), *wfv);
+    // schmalbandige STFT nur fuer das gezoomte Band
+    auto zoom = _graph.addNode<ZoomProcessor>( 4096, 1024);
+    _graph.connect( maus_gui->output(), *zoom);
+    zoom_view->startProcessing();
+    _graph.connect( zoom->output(), *zoom_view);
+    // beide Ansichten melden das Band relativ zur vollen Abtastrate, in der Zoomansicht
+    // laesst sich so weiter hinein- und mit Doppelklick wieder herauszoomen
+    const auto retune = [ zoom, zoom_view]( double center, double span) {
+        zoom_view->setBand( center, zoom->setBand( center, span));
+    };
+    QObject::connect( wfv, &Sonarview::zoomChanged, zoom_view, retune);
+    QObject::connect( zoom_view, &Sonarview::zoomChanged, zoom_view, retune);
+    // Mitschnitt: je nach Format die gewandelten oder die rohen Bloecke
+    _graph.connect( maus_gui->output(), *_graph.addSink(
+        std::bind( &FileWriterWidget::writeToFile, fww, std::placeholders::_1)));
+    _graph.connect( maus_gui->rawOutput(), *_graph.addSink<SampleBlockPtr<std::complex<int16_t>>>(
+        std::bind( &FileWriterWidget::writeRawToFile, fww, std::placeholders::_1)));
+    _graph.connect( maus_gui->output(), *_graph.addSink(
+        std::bind( &UDPSenderWidget::sendData<std::complex<float>>, udp, std::placeholders::_1)));
+    _graph.start();
 
     qvbl_main->addWidget( maus_gui);
     qvbl_main->addWidget( fww);
     qvbl_main->addWidget( udp);
 
     qhbl_sec->addWidget( wfv);
+    qhbl_sec->addWidget( zoom_view);
     qvbl_main->addLayout( qhbl_sec);
 
     QWidget *qw_main = new QWidget(this);
@@ -38,7 +75,9 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-
+    // Senken vor den Widgets abbauen, auf die sie verweisen
+    _graph.disconnectAll();
+    _graph.stop();
 }
 
 
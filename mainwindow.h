@@ -9,8 +9,10 @@
 #include "libmouse.hpp"
 #include "mousegui.hpp"
 #include "sonarview.hpp"
+#include "ddc.hpp"
 #include "filesink.hpp"
 #include "udpsink.hpp"
+#include "flowgraph.hpp"
 
 
 class MainWindow : public QMainWindow
@@ -24,5 +26,8 @@ public:
 
 protected:
     void closeEvent(QCloseEvent *event);
+
+private:
+    FlowGraph _graph;
 };
 #endif // MAINWINDOW_H
@@ -5,9 +5,13 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 CONFIG += c++17
 LIBS += /usr/include/libusb-1.0/libusb.h -lusb-1.0
 LIBS += -L/usr/include/volk -lvolk
+# Parallel-STL (std::execution) laeuft in libstdc++ ueber TBB
+LIBS += -ltbb
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+# Diagnoseausgaben (DEBUG) nur in Debug-Builds
+CONFIG(debug, debug|release): DEFINES += DEBUG
 
 SOURCES += \
     main.cpp \
@@ -15,17 +19,40 @@ SOURCES += \
 HEADERS += \
     baseprocessor.hpp \
     carrierprocessing.hpp \
+    ddc.hpp \
+    decibel.hpp \
     dsp.hpp \
     fft.hpp \
+    firfilter.hpp \
     filesink.hpp \
+    filewriter.hpp \
+    flowgraph.hpp \
+    iqconvert.hpp \
     mainwindow.h \
+    mouseemulator.hpp \
     mousegui.hpp \
+    mousesource.hpp \
     peakdetection.hpp \
+    recording.hpp \
+    sampleencoder.hpp \
+    ports.hpp \
+    psd.hpp \
+    reduce.hpp \
     processor_base.hpp \
+    sampleblock.hpp \
+    sigmf.hpp \
+    samplesource.hpp \
+    simd.hpp \
+    spscring.hpp \
+    stft.hpp \
     sonarview.hpp \
     libmouse.hpp \
+    udpsender.hpp \
+    udpserver.hpp \
     udpsink.hpp \
-    tools.hpp
+    vrt.hpp \
+    tools.hpp \
+    triggerrecorder.hpp
 
 #QMAKE_CXXFLAGS += -O3 -finline-small-functions -static
 
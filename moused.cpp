@@ -0,0 +1,672 @@
+// moused: MOUSE ohne GUI betreiben (Server, Racks ohne Display)
+//
+// Stellt Filter und Mittenfrequenz ueber Kommandozeile oder Konfigurationsdatei ein
+// und streamt in Datei-, UDP-Senke und Carrier-Erkennung. Benoetigt kein Qt.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <complex>
+#include <map>
+#include <optional>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <getopt.h>
+
+#include "mousesource.hpp"
+#include "mouseemulator.hpp"
+#include "flowgraph.hpp"
+#include "filewriter.hpp"
+#include "recording.hpp"
+#include "triggerrecorder.hpp"
+#include "udpsender.hpp"
+#include "udpserver.hpp"
+#include "stft.hpp"
+#include "carrierprocessing.hpp"
+
+
+namespace {
+
+std::atomic_bool stop_requested( false);
+std::atomic_bool trigger_requested( false);
+
+void onSignal( int) {
+    stop_requested = true;
+}
+
+void onTriggerSignal( int) {
+    trigger_requested = true;
+}
+
+/// @brief Einstellungen des Daemons, Kommandozeile ueberschreibt die Konfigurationsdatei
+struct Settings {
+    int64_t center_freq = 100000000;    // [Hz]
+    uint32_t filter = 0;                // Index, bestimmt auch die Abtastrate
+    std::string file;
+    bool append = false;
+    RecordFormat format = RecordFormat::SC16;   // --file
+    bool direct = false;                // O_DIRECT fuer --file
+    uint64_t record_buffer = 256;       // [MiB] Ring des FileWriter
+    std::string udp_ip;
+    uint16_t udp_port = 0;
+    uint64_t udp_mtu = 1500;            // 9000: Jumbo-Frames
+    double udp_rate = 0;                // [MB/s], 0: ungedrosselt
+    UdpProtocol udp_protocol = UdpProtocol::Mouse;
+    uint32_t stream_id = 1;             // VRT Stream ID
+    std::optional<SampleEncoding> udp_encoding;     // leer: cf32 wie gewandelt
+    int multicast_ttl = 1;
+    std::string multicast_if;           // IPv4-Adresse der Schnittstelle
+    uint16_t serve_port = 0;            // Steuerport fuer Teilstroeme, 0: aus
+    std::string serve_bind = "127.0.0.1";
+    std::string serve_token;
+    std::vector<std::string> serve_allow;   // Absenderadressen, leer: alle
+    uint64_t serve_max = 8;             // Abos ueber den Steuerport
+    double serve_max_rate = 0;          // [Sps], Summe, 0: Abtastrate der Quelle
+    double lease = 60;                  // [s]
+    std::string carrier_udp_ip;         // Teilstrom je Carrier
+    uint16_t carrier_udp_port = 0;
+    std::string carrier_dir;
+    std::string trigger_dir;            // Aufnahme mit Vorlauf
+    double pre_trigger = 5;             // [s]
+    double post_trigger = 5;            // [s]
+    double trigger_level = -1000;       // [dBFS]
+    uint64_t fft_leng = 4096;
+    uint64_t psd_avg = 8;
+    uint64_t threshold_db = 12;
+    std::complex<float> iq_dc = { 0.f, 0.f};    // fester DC-Anteil, Vollaussteuerung 1.0
+    float iq_dc_track = 0;              // Gewicht je Block, 0: aus
+    float iq_gain = 1;                  // Q relativ zu I
+    float iq_phase = 0;                 // Phasenfehler von Q [Grad]
+    uint32_t transfer_count = 8;
+    uint32_t transfer_samples = 16 * 1024;
+    double duration = 0;                // [s], 0: bis SIGINT/SIGTERM
+    double stats_interval = 1;          // [s], 0: keine Statistik
+    bool list_filters = false;
+    bool emulate = false;               // MouseEmulator statt USB
+    MouseEmulator::Config emulator;
+};
+
+void usage( const char *name) {
+    std::cerr <<
+        "Aufruf: " << name << " [Optionen]\n"
+        "  -f, --freq HZ              Mittenfrequenz, Suffix k/M/G erlaubt (100M)\n"
+        "  -F, --filter INDEX         Filter der MOUSE (siehe --list-filters, 0)\n"
+        "  -l, --list-filters         verfuegbare Filter ausgeben und beenden\n"
+        "  -o, --file PFAD            Abtastwerte in Datei schreiben, Beschreibung als SigMF\n"
+        "      --format F             Format der Datei: sc16 (Vorgabe, nativ), cf32, sc8,\n"
+        "                             sc8bfp (Block-Floating-Point) oder lossless (kodiert)\n"
+        "  -a, --append               an bestehende Datei anfuegen\n"
+        "      --direct               Datei mit O_DIRECT schreiben (am Seitencache vorbei)\n"
+        "      --record-buffer MB     Puffer der Dateisenke in MiB (256)\n"
+        "  -u, --udp IP:PORT          Abtastwerte (cf32) per UDP senden, 24 Byte Kopf je Datagramm\n"
+        "      --udp-mtu N            IP-MTU der Strecke (1500, Jumbo-Frames: 9000)\n"
+        "      --udp-rate MB/s        UDP auf eine Datenrate drosseln (0: aus)\n"
+        "      --udp-protocol P       mouse (Vorgabe, eigener Kopf) oder vrt (VITA-49)\n"
+        "      --stream-id N          VRT Stream ID (1)\n"
+        "      --udp-encoding E       Kodierung fuer --udp und Teilstroeme: cf32 (Vorgabe), sc16,\n"
+        "                             sc8bfp oder lossless (vrt: nur cf32 und sc16)\n"
+        "      --multicast-ttl N      TTL fuer Multicast-Gruppen als --udp Ziel (1)\n"
+        "      --multicast-if IP      Schnittstelle fuer Multicast\n"
+        "      --serve PORT           Steuerport: Teilstroeme per SUBSCRIBE <Hz> <Bandbreite> [Port]\n"
+        "      --serve-bind IP        Adresse des Steuerports (127.0.0.1), ausserhalb von\n"
+        "                             Loopback nur mit --serve-token oder --serve-allow\n"
+        "      --serve-token T        Anfragen muessen mit \"AUTH T\" beginnen\n"
+        "      --serve-allow IP[,IP]  nur Anfragen von diesen Adressen beantworten\n"
+        "      --serve-max N          hoechstens N Abos ueber den Steuerport (8)\n"
+        "      --serve-max-rate SPS   Summe der Abtastraten dieser Abos (0: Rate der Quelle)\n"
+        "      --lease S              Abos ueber --serve verfallen nach S Sekunden (60)\n"
+        "      --udp-carriers IP:PORT Teilstrom je erkanntem Carrier (--carriers) an IP,\n"
+        "                             ab PORT je Carrier ein Port\n"
+        "  -c, --carriers VERZ        Carrier-Erkennung, Carrier nach VERZ schreiben\n"
+        "      --fft N                FFT-Laenge der Carrier-Erkennung (4096)\n"
+        "      --threshold DB         Schwelle der Carrier-Erkennung (12)\n"
+        "  -t, --trigger VERZ         Aufnahme mit Vorlauf nach VERZ (sc16/sc8), ausgeloest von\n"
+        "                             neuen Carriern (--carriers) oder SIGUSR1\n"
+        "      --pre S                Vorlauf in Sekunden (5)\n"
+        "      --post S               Nachlauf nach dem letzten Trigger in Sekunden (5)\n"
+        "      --trigger-level DB     Mindestpegel eines Carriers fuer den Trigger [dBFS]\n"
+        "      --iq-dc I,Q            DC-Anteil abziehen, Vollaussteuerung 1.0 (0,0)\n"
+        "      --iq-dc-track A        DC-Anteil je Block nachfuehren, Gewicht 0..1 (0: aus)\n"
+        "      --iq-imbalance G,P     IQ-Ungleichgewicht: Verstaerkung Q/I und Phase in Grad (1,0)\n"
+        "      --transfers N          gleichzeitige USB-Transfers (8)\n"
+        "      --transfer-samples N   Abtastwerte je Transfer (16384)\n"
+        "  -d, --duration S           nach S Sekunden beenden (0: Signal)\n"
+        "  -s, --stats S              Statistik alle S Sekunden (0: aus)\n"
+        "  -C, --config PFAD          Konfigurationsdatei (schluessel = wert)\n"
+        "  -e, --emulate MODUS        ohne Hardware: tone, noise, burst oder file:PFAD\n"
+        "      --emulate-format F     Format des Mitschnitts: sc16 (Vorgabe) oder cf32\n"
+        "      --tones HZ[,HZ...]     Toene relativ zur Mittenfrequenz (10k)\n"
+        "      --amplitude A          Amplitude je Ton, Vollaussteuerung 1.0 (0.25)\n"
+        "      --noise A              Effektivwert des Rauschens (0.01)\n"
+        "      --burst S/S            Burst-Dauer/Periode in Sekunden (0.01/0.1)\n"
+        "      --max-speed            nicht in Echtzeit, sondern so schnell wie moeglich\n"
+        "      --no-loop              Mitschnitt nur einmal abspielen\n"
+        "  -h, --help                 diese Hilfe\n";
+}
+
+/// @brief Zahl mit optionalem Suffix k/M/G
+double parseNumber( const std::string &value) {
+    size_t pos = 0;
+    double number = std::stod( value, &pos);
+    if( pos < value.size()) {
+        switch( value[ pos]) {
+        case 'k': case 'K': number *= 1e3; break;
+        case 'M': number *= 1e6; break;
+        case 'G': case 'g': number *= 1e9; break;
+        default:
+            throw std::invalid_argument( "FEHLER ungueltige Zahl: " + value);
+        }
+    }
+    return number;
+}
+
+/// @brief setzt eine Einstellung ueber ihren langen Namen (Kommandozeile und Konfigurationsdatei)
+void applyOption( Settings &set, const std::string &key, const std::string &value) {
+    if( key == "freq") set.center_freq = static_cast<int64_t>( parseNumber( value));
+    else if( key == "filter") set.filter = static_cast<uint32_t>( std::stoul( value));
+    else if( key == "list-filters") set.list_filters = value != "false" && value != "0";
+    else if( key == "file") set.file = value;
+    else if( key == "append") set.append = value != "false" && value != "0";
+    else if( key == "format") set.format = formatFromName( value);
+    else if( key == "direct") set.direct = value != "false" && value != "0";
+    else if( key == "record-buffer") set.record_buffer = std::stoull( value);
+    else if( key == "udp") {
+        const size_t colon = value.rfind( ':');
+        if( colon == std::string::npos)
+            throw std::invalid_argument( "FEHLER --udp erwartet IP:PORT: " + value);
+        set.udp_ip = value.substr( 0, colon);
+        set.udp_port = static_cast<uint16_t>( std::stoul( value.substr( colon + 1)));
+    }
+    else if( key == "udp-mtu") set.udp_mtu = std::stoull( value);
+    else if( key == "udp-rate") set.udp_rate = std::stod( value);
+    else if( key == "udp-protocol") {
+        if( value == "mouse") set.udp_protocol = UdpProtocol::Mouse;
+        else if( value == "vrt") set.udp_protocol = UdpProtocol::Vrt;
+        else throw std::invalid_argument( "FEHLER --udp-protocol: " + value);
+    }
+    else if( key == "stream-id") set.stream_id = static_cast<uint32_t>( std::stoul( value, nullptr, 0));
+    else if( key == "udp-encoding") set.udp_encoding = encodingFromName( value);
+    else if( key == "multicast-ttl") set.multicast_ttl = std::stoi( value);
+    else if( key == "multicast-if") set.multicast_if = value;
+    else if( key == "serve") set.serve_port = static_cast<uint16_t>( std::stoul( value));
+    else if( key == "serve-bind") set.serve_bind = value;
+    else if( key == "serve-token") set.serve_token = value;
+    else if( key == "serve-allow") {
+        set.serve_allow.clear();
+        std::istringstream list( value);
+        for( std::string ip; std::getline( list, ip, ',');)
+            set.serve_allow.push_back( ip);
+    }
+    else if( key == "serve-max") set.serve_max = std::stoull( value);
+    else if( key == "serve-max-rate") set.serve_max_rate = parseNumber( value);
+    else if( key == "lease") set.lease = std::stod( value);
+    else if( key == "udp-carriers") {
+        const size_t colon = value.rfind( ':');
+        if( colon == std::string::npos)
+            throw std::invalid_argument( "FEHLER --udp-carriers erwartet IP:PORT: " + value);
+        set.carrier_udp_ip = value.substr( 0, colon);
+        set.carrier_udp_port = static_cast<uint16_t>( std::stoul( value.substr( colon + 1)));
+    }
+    else if( key == "carriers") set.carrier_dir = value;
+    else if( key == "trigger") set.trigger_dir = value;
+    else if( key == "pre") set.pre_trigger = std::stod( value);
+    else if( key == "post") set.post_trigger = std::stod( value);
+    else if( key == "trigger-level") set.trigger_level = std::stod( value);
+    else if( key == "fft") set.fft_leng = static_cast<uint64_t>( parseNumber( value));
+    else if( key == "threshold") set.threshold_db = std::stoull( value);
+    else if( key == "iq-dc" || key == "iq-imbalance") {
+        const size_t comma = value.find( ',');
+        if( comma == std::string::npos)
+            throw std::invalid_argument( "FEHLER --" + key + " erwartet zwei Werte A,B: " + value);
+        const float first = std::stof( value.substr( 0, comma));
+        const float second = std::stof( value.substr( comma + 1));
+        if( key == "iq-dc") set.iq_dc = { first, second};
+        else {
+            if( first <= 0.f) throw std::invalid_argument( "FEHLER --iq-imbalance: Verstaerkung <= 0");
+            set.iq_gain = first;
+            set.iq_phase = second;
+        }
+    }
+    else if( key == "iq-dc-track") set.iq_dc_track = std::stof( value);
+    else if( key == "transfers") set.transfer_count = std::stoul( value);
+    else if( key == "transfer-samples") set.transfer_samples = static_cast<uint32_t>( parseNumber( value));
+    else if( key == "duration") set.duration = std::stod( value);
+    else if( key == "stats") set.stats_interval = std::stod( value);
+    else if( key == "emulate") {
+        set.emulate = true;
+        if( value == "tone") set.emulator.mode = MouseEmulator::Mode::Tone;
+        else if( value == "noise") set.emulator.mode = MouseEmulator::Mode::Noise;
+        else if( value == "burst") set.emulator.mode = MouseEmulator::Mode::Burst;
+        else if( value.rfind( "file:", 0) == 0) {
+            set.emulator.mode = MouseEmulator::Mode::File;
+            set.emulator.path = value.substr( 5);
+        }
+        else throw std::invalid_argument( "FEHLER --emulate: unbekannter Modus " + value);
+    }
+    else if( key == "emulate-format") {
+        if( value == "sc16") set.emulator.format = MouseEmulator::Format::SC16;
+        else if( value == "cf32") set.emulator.format = MouseEmulator::Format::CF32;
+        else throw std::invalid_argument( "FEHLER --emulate-format: " + value);
+    }
+    else if( key == "tones") {
+        set.emulator.tones.clear();
+        std::istringstream list( value);
+        for( std::string tone; std::getline( list, tone, ',');)
+            set.emulator.tones.push_back( parseNumber( tone));
+    }
+    else if( key == "amplitude") set.emulator.amplitude = std::stod( value);
+    else if( key == "noise") set.emulator.noise = std::stod( value);
+    else if( key == "burst") {
+        const size_t slash = value.find( '/');
+        if( slash == std::string::npos)
+            throw std::invalid_argument( "FEHLER --burst erwartet DAUER/PERIODE: " + value);
+        set.emulator.burst_on = std::stod( value.substr( 0, slash));
+        set.emulator.burst_period = std::stod( value.substr( slash + 1));
+    }
+    else if( key == "max-speed") set.emulator.paced = value == "false" || value == "0";
+    else if( key == "no-loop") set.emulator.loop = value == "false" || value == "0";
+    else throw std::invalid_argument( "FEHLER unbekannte Einstellung: " + key);
+}
+
+/// @brief liest "schluessel = wert" Zeilen, '#' leitet Kommentare ein
+void loadConfig( Settings &set, const std::string &path) {
+    std::ifstream in( path);
+    if( ! in) throw std::runtime_error( "FEHLER kann Konfiguration nicht oeffnen: " + path);
+    const auto trim = []( std::string str) {
+        const size_t beg = str.find_first_not_of( " \t\r");
+        if( beg == std::string::npos) return std::string();
+        return str.substr( beg, str.find_last_not_of( " \t\r") - beg + 1);
+    };
+    std::string line;
+    for( uint64_t line_nr = 1; std::getline( in, line); ++line_nr) {
+        line = trim( line.substr( 0, line.find( '#')));
+        if( line.empty()) continue;
+        const size_t equal = line.find( '=');
+        if( equal == std::string::npos) {
+            applyOption( set, line, "true");
+            continue;
+        }
+        applyOption( set, trim( line.substr( 0, equal)), trim( line.substr( equal + 1)));
+    }
+}
+
+/// @brief Kommandozeile auswerten, eine angegebene Konfigurationsdatei wird zuerst gelesen
+Settings parseArguments( int argc, char *argv[]) {
+    enum { OPT_FFT = 1000, OPT_THRESHOLD, OPT_TRANSFERS, OPT_TRANSFER_SAMPLES,
+           OPT_EMULATE_FORMAT, OPT_TONES, OPT_AMPLITUDE, OPT_NOISE, OPT_BURST,
+           OPT_MAX_SPEED, OPT_NO_LOOP, OPT_DIRECT, OPT_RECORD_BUFFER, OPT_FORMAT,
+           OPT_PRE, OPT_POST, OPT_TRIGGER_LEVEL, OPT_UDP_MTU, OPT_UDP_RATE,
+           OPT_UDP_PROTOCOL, OPT_STREAM_ID, OPT_MULTICAST_TTL, OPT_MULTICAST_IF, OPT_SERVE,
+           OPT_LEASE, OPT_UDP_CARRIERS, OPT_UDP_ENCODING, OPT_SERVE_BIND, OPT_SERVE_TOKEN,
+           OPT_SERVE_ALLOW, OPT_SERVE_MAX, OPT_SERVE_MAX_RATE, OPT_IQ_DC, OPT_IQ_DC_TRACK,
+           OPT_IQ_IMBALANCE};
+    static const option long_options[] = {
+        { "freq",             required_argument, nullptr, 'f'},
+        { "filter",           required_argument, nullptr, 'F'},
+        { "list-filters",     no_argument,       nullptr, 'l'},
+        { "file",             required_argument, nullptr, 'o'},
+        { "append",           no_argument,       nullptr, 'a'},
+        { "format",           required_argument, nullptr, OPT_FORMAT},
+        { "direct",           no_argument,       nullptr, OPT_DIRECT},
+        { "record-buffer",    required_argument, nullptr, OPT_RECORD_BUFFER},
+        { "udp",              required_argument, nullptr, 'u'},
+        { "udp-mtu",          required_argument, nullptr, OPT_UDP_MTU},
+        { "udp-rate",         required_argument, nullptr, OPT_UDP_RATE},
+        { "udp-protocol",     required_argument, nullptr, OPT_UDP_PROTOCOL},
+        { "stream-id",        required_argument, nullptr, OPT_STREAM_ID},
+        { "udp-encoding",     required_argument, nullptr, OPT_UDP_ENCODING},
+        { "multicast-ttl",    required_argument, nullptr, OPT_MULTICAST_TTL},
+        { "multicast-if",     required_argument, nullptr, OPT_MULTICAST_IF},
+        { "serve",            required_argument, nullptr, OPT_SERVE},
+        { "serve-bind",       required_argument, nullptr, OPT_SERVE_BIND},
+        { "serve-token",      required_argument, nullptr, OPT_SERVE_TOKEN},
+        { "serve-allow",      required_argument, nullptr, OPT_SERVE_ALLOW},
+        { "serve-max",        required_argument, nullptr, OPT_SERVE_MAX},
+        { "serve-max-rate",   required_argument, nullptr, OPT_SERVE_MAX_RATE},
+        { "lease",            required_argument, nullptr, OPT_LEASE},
+        { "udp-carriers",     required_argument, nullptr, OPT_UDP_CARRIERS},
+        { "carriers",         required_argument, nullptr, 'c'},
+        { "trigger",          required_argument, nullptr, 't'},
+        { "pre",              required_argument, nullptr, OPT_PRE},
+        { "post",             required_argument, nullptr, OPT_POST},
+        { "trigger-level",    required_argument, nullptr, OPT_TRIGGER_LEVEL},
+        { "fft",              required_argument, nullptr, OPT_FFT},
+        { "threshold",        required_argument, nullptr, OPT_THRESHOLD},
+        { "iq-dc",            required_argument, nullptr, OPT_IQ_DC},
+        { "iq-dc-track",      required_argument, nullptr, OPT_IQ_DC_TRACK},
+        { "iq-imbalance",     required_argument, nullptr, OPT_IQ_IMBALANCE},
+        { "transfers",        required_argument, nullptr, OPT_TRANSFERS},
+        { "transfer-samples", required_argument, nullptr, OPT_TRANSFER_SAMPLES},
+        { "duration",         required_argument, nullptr, 'd'},
+        { "stats",            required_argument, nullptr, 's'},
+        { "config",           required_argument, nullptr, 'C'},
+        { "emulate",          required_argument, nullptr, 'e'},
+        { "emulate-format",   required_argument, nullptr, OPT_EMULATE_FORMAT},
+        { "tones",            required_argument, nullptr, OPT_TONES},
+        { "amplitude",        required_argument, nullptr, OPT_AMPLITUDE},
+        { "noise",            required_argument, nullptr, OPT_NOISE},
+        { "burst",            required_argument, nullptr, OPT_BURST},
+        { "max-speed",        no_argument,       nullptr, OPT_MAX_SPEED},
+        { "no-loop",          no_argument,       nullptr, OPT_NO_LOOP},
+        { "help",             no_argument,       nullptr, 'h'},
+        { nullptr, 0, nullptr, 0}
+    };
+
+    std::string config;
+    std::vector<std::pair<std::string, std::string>> options;
+    int opt, index;
+    while( ( opt = getopt_long( argc, argv, "f:F:lo:au:c:t:d:s:C:e:h", long_options, &index)) != -1) {
+        if( opt == '?') {
+            usage( argv[ 0]);
+            std::exit( EXIT_FAILURE);
+        }
+        if( opt == 'h') {
+            usage( argv[ 0]);
+            std::exit( EXIT_SUCCESS);
+        }
+        const option *lopt = long_options;
+        while( lopt->name && lopt->val != opt) ++lopt;
+        if( opt == 'C') config = optarg;
+        else options.emplace_back( lopt->name, optarg ? optarg : "true");
+    }
+
+    Settings set;
+    if( ! config.empty()) loadConfig( set, config);
+    for( const auto &[ key, value] : options)
+        applyOption( set, key, value);
+    return set;
+}
+
+void printStatistics( const MouseSource &source, uint64_t &last_samples, double interval,
+                      const std::vector<std::pair<std::string, std::shared_ptr<ProcessorNode>>> &nodes,
+                      Recorder &recorder, const UDPSender *udp) {
+    const uint64_t samples = source.getSampleCount();
+    std::cerr << "INFO " << static_cast<double>( samples - last_samples) / interval / 1e6
+              << " MS/s, USB-Fehler: " << source.getTransferErrors();
+    last_samples = samples;
+    for( const auto &[ name, node] : nodes) {
+        const BaseProcessor::Statistics stat = node->getStatistics();
+        std::cerr << " | " << name << ": " << stat.processed << " verarbeitet, "
+                  << stat.dropped << " verworfen, " << stat.queued << " wartend";
+    }
+    const FileWriter::Statistics file = recorder.writer().getStatistics();
+    if( file.capacity)
+        std::cerr << " | Platte: " << file.written / ( 1 << 20) << " MiB, " << file.overruns
+                  << " Ueberlaeufe, Puffer " << 100 * file.buffered / file.capacity << " %, Kompression "
+                  << std::round( 100. * recorder.getCompressionRatio()) / 100.;
+    if( udp) {
+        const UDPSender::Statistics net = udp->getStatistics();
+        std::cerr << " | UDP: " << net.packets << " Pakete, " << net.syscalls << " Aufrufe, "
+                  << net.errors << " Fehler, Kompression " << std::round( 100. * net.ratio()) / 100.
+                  << ( net.gso ? ", GSO" : "");
+    }
+    std::cerr << std::endl;
+}
+
+} // namespace
+
+
+int main( int argc, char *argv[]) {
+    Settings set;
+    try {
+        set = parseArguments( argc, argv);
+    }
+    catch( const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<SampleSource> device;
+    if( set.emulate) {
+        try {
+            device = std::make_unique<MouseEmulator>( set.emulator);
+        }
+        catch( const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    MouseSource source( set.transfer_samples, std::move( device));
+    if( source.open()) {
+        std::cerr << source.getError() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<std::vector<uint32_t>> filters = source.getFilter();
+    if( set.list_filters) {
+        for( uint64_t w = 0; w < filters.size(); ++w)
+            std::cout << w << ": " << filters[ w].at( 0) / 1000.0 << " kSps, "
+                      << filters[ w].at( 1) * 4 / 1000.0 << " kHz" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    FlowGraph graph;
+    std::vector<std::pair<std::string, std::shared_ptr<ProcessorNode>>> nodes;
+    // Eingaenge, die direkt am Sample-Ausgang der Quelle haengen
+    std::vector<std::shared_ptr<BaseProcessor>> sample_sinks;
+    Recorder recorder;
+    FileWriter &writer = recorder.writer();
+    std::shared_ptr<BasicFunctionSink<SampleBlockPtr<std::complex<int16_t>>>> raw_sink;
+    std::shared_ptr<UDPSender> udp;
+    std::shared_ptr<UdpStreamServer> server;
+    // Teilstrom je Carrier: Carrier::sample_start -> ( Abo, Port-Offset)
+    std::map<uint64_t, std::pair<uint32_t, uint16_t>> carrier_streams;
+    std::vector<bool> carrier_ports;
+    std::shared_ptr<CarrierDetection> carriers;
+    std::shared_ptr<TriggeredRecorder<std::complex<int16_t>>> triggered;
+
+    try {
+        // die MOUSE meldet ihre aktuelle Einstellung nicht, also immer einen Filter setzen:
+        // alle Senken brauchen die Abtastrate
+        const int32_t samp_rate = source.setFilter( set.filter);
+        if( samp_rate <= 0)
+            throw std::runtime_error( "FEHLER Filter " + std::to_string( set.filter) + ": keine Abtastrate");
+        source.setCenterFrequency( static_cast<int32_t>( set.center_freq));
+        source.converter().setDCOffset( set.iq_dc);
+        source.converter().setDCTracking( set.iq_dc_track);
+        source.converter().setIQImbalance( set.iq_gain, set.iq_phase * static_cast<float>( M_PI / 180.));
+
+        if( ! set.file.empty()) {
+            writer.setDirect( set.direct);
+            writer.setBufferSize( set.record_buffer << 20);
+            recorder.setFormat( set.format);
+            RecordMeta meta;
+            meta.samp_rate = samp_rate;
+            meta.center_freq = static_cast<double>( set.center_freq);
+            if( recorder.open( set.file, set.append, meta))
+                throw std::runtime_error( recorder.getError());
+            // sc16/sc8 direkt aus den rohen Bloecken, cf32 nach der Wandlung
+            if( set.format == RecordFormat::CF32) {
+                sample_sinks.push_back( graph.addSink( [ &recorder]( const SampleBlockPtr<std::complex<float>> &input)
+                                                       { recorder.write( input);}));
+                nodes.emplace_back( "Datei", sample_sinks.back());
+            }
+            else {
+                raw_sink = graph.addSink<SampleBlockPtr<std::complex<int16_t>>>(
+                               [ &recorder]( const SampleBlockPtr<std::complex<int16_t>> &input)
+                               { recorder.write( input);});
+                nodes.emplace_back( "Datei", raw_sink);
+            }
+        }
+        if( ! set.udp_ip.empty()) {
+            udp = std::make_shared<UDPSender>( set.udp_ip, set.udp_port);
+            if( udp->isMulticast()) {
+                udp->setMulticastTtl( set.multicast_ttl);
+                if( ! set.multicast_if.empty()) udp->setMulticastInterface( set.multicast_if);
+            }
+            udp->setMtu( set.udp_mtu);
+            udp->setRate( set.udp_rate * 1e6);
+            udp->setSampleRate( samp_rate);
+            udp->setProtocol( set.udp_protocol);
+            udp->setStreamId( set.stream_id);
+            udp->setEncoding( set.udp_encoding);
+            Vrt::Context ctx;
+            ctx.samp_rate = samp_rate;
+            ctx.center_freq = static_cast<double>( set.center_freq);
+            // Durchlassbereich des Filters, wie bei --list-filters
+            ctx.bandwidth = set.filter < filters.size() ? filters[ set.filter].at( 1) * 4. : samp_rate;
+            udp->setContext( ctx);
+        }
+        if( ! set.carrier_udp_ip.empty() && set.carrier_dir.empty())
+            throw std::invalid_argument( "FEHLER --udp-carriers braucht --carriers");
+        if( set.serve_port || ! set.carrier_udp_ip.empty()) {
+            // Server: voller Strom (--udp) und Teilstroeme im selben Knoten
+            server = graph.addNode<UdpStreamServer>();
+            server->setSampleRate( samp_rate);
+            server->setCenterFrequency( static_cast<double>( set.center_freq));
+            server->setMtu( set.udp_mtu);
+            server->setProtocol( set.udp_protocol);
+            server->setEncoding( set.udp_encoding);
+            server->setLease( set.lease);
+            server->setToken( set.serve_token);
+            server->setAllowed( set.serve_allow);
+            server->setLimits( set.serve_max, set.serve_max_rate);
+            server->setWideband( udp);
+            if( set.serve_port && server->startControl( set.serve_port, set.serve_bind))
+                throw std::runtime_error( server->getError());
+            sample_sinks.push_back( server);
+            nodes.emplace_back( "Server", server);
+        }
+        else if( udp) {
+            UDPSender *sender = udp.get();
+            sample_sinks.push_back( graph.addSink( [ sender]( const SampleBlockPtr<std::complex<float>> &input)
+                                                   { sender->sendData( input->data(), input->size(), input->index());}));
+            nodes.emplace_back( "UDP", sample_sinks.back());
+        }
+        if( ! set.trigger_dir.empty()) {
+            if( set.format == RecordFormat::CF32)
+                throw std::invalid_argument( "FEHLER --trigger schreibt sc16 oder sc8");
+            std::string prefix = set.trigger_dir;
+            if( prefix.back() != '/') prefix += '/';
+            triggered = graph.addNode<TriggeredRecorder<std::complex<int16_t>>>( prefix, set.pre_trigger,
+                                                                                 set.post_trigger);
+            triggered->setSampleRate( samp_rate);
+            triggered->setCenterFrequency( static_cast<double>( set.center_freq));
+            triggered->recorder().setFormat( set.format);
+            triggered->recorder().writer().setDirect( set.direct);
+            nodes.emplace_back( "Trigger", triggered);
+        }
+        if( ! set.carrier_dir.empty()) {
+            std::string prefix = set.carrier_dir;
+            if( prefix.back() != '/') prefix += '/';
+            // STFT einmal rechnen, die Carrier-Erkennung abonniert die Frames
+            std::shared_ptr<StftProcessor> stft = graph.addNode<StftProcessor>( set.fft_leng, set.fft_leng / 4,
+                                                                                   Stft::Window::VonHann, false);
+            carriers = graph.addNode<CarrierDetection>( set.psd_avg, set.threshold_db, prefix);
+            carriers->setSampleRate( samp_rate);
+            carriers->setCenterFrequency( static_cast<double>( set.center_freq));
+            graph.connect( stft->output(), *carriers);
+            // erkannte Carrier als Annotationen im Mitschnitt, Suche ohne erneuten Durchlauf
+            TriggeredRecorder<std::complex<int16_t>> *trig = triggered.get();
+            // Teilstroeme nur mit --udp-carriers, beide Rueckrufe laufen im Thread der Erkennung
+            UdpStreamServer *streams = set.carrier_udp_ip.empty() ? nullptr : server.get();
+            carriers->setFinishedCallback( [ &recorder, trig, streams, &carrier_streams, &carrier_ports]( const Carrier &car) {
+                const double lower = car.origin_freq - car.band_width / 2;
+                const double upper = car.origin_freq + car.band_width / 2;
+                recorder.annotate( car.sample_start, car.sample_count, lower, upper, "carrier");
+                if( trig) trig->annotate( car.sample_start, car.sample_count, lower, upper, "carrier");
+                const auto stream = carrier_streams.find( car.sample_start);
+                if( streams && stream != carrier_streams.end()) {
+                    streams->removeSubscriber( stream->second.first);
+                    carrier_ports[ stream->second.second] = false;
+                    carrier_streams.erase( stream);
+                }
+            });
+            // neuer Carrier loest die Aufnahme mit Vorlauf aus und bekommt einen Teilstrom
+            // auf dem ersten freien Port ab --udp-carriers PORT
+            if( trig || streams)
+                carriers->setNewCarrierCallback( [ trig, streams, &set, &carrier_streams, &carrier_ports]( const Carrier &car) {
+                    if( trig) trig->trigger();
+                    if( ! streams) return;
+                    const uint16_t slot = static_cast<uint16_t>(
+                        std::find( carrier_ports.begin(), carrier_ports.end(), false) - carrier_ports.begin());
+                    try {
+                        // mindestens 2 kHz, damit schmale Carrier nicht auf eine Handvoll Bins fallen
+                        const UdpStreamServer::Subscription sub = streams->addSubscriber(
+                            set.carrier_udp_ip, static_cast<uint16_t>( set.carrier_udp_port + slot),
+                            car.origin_freq, std::max( 2e3, 1.5 * car.band_width));
+                        if( slot == carrier_ports.size()) carrier_ports.push_back( true);
+                        else carrier_ports[ slot] = true;
+                        carrier_streams[ car.sample_start] = { sub.id, slot};
+                        std::cerr << "INFO Teilstrom " << sub.id << ": " << car.origin_freq << " Hz, "
+                                  << sub.samp_rate << " Sps -> " << sub.ip << ":" << sub.port << std::endl;
+                    }
+                    catch( const std::exception &e) {
+                        std::cerr << e.what() << std::endl;
+                    }
+                }, static_cast<float>( set.trigger_level));
+            sample_sinks.push_back( stft);
+            nodes.emplace_back( "STFT", stft);
+            nodes.emplace_back( "Carrier", carriers);
+        }
+    }
+    catch( const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if( nodes.empty())
+        std::cerr << "WARNUNG keine Senke angegeben (--file, --udp, --carriers)" << std::endl;
+    for( auto &sink : sample_sinks)
+        graph.connect( source.output(), *sink);
+    if( raw_sink)
+        graph.connect( source.rawOutput(), *raw_sink);
+    if( triggered)
+        graph.connect( source.rawOutput(), *triggered);
+
+    std::signal( SIGINT, onSignal);
+    std::signal( SIGTERM, onSignal);
+    std::signal( SIGUSR1, onTriggerSignal);
+
+    graph.start();
+    if( source.startStreaming( set.transfer_count)) {
+        std::cerr << source.getError() << std::endl;
+        graph.disconnectAll();
+        graph.stop();
+        return EXIT_FAILURE;
+    }
+    std::cerr << "INFO streaming " << set.center_freq << " Hz" << std::endl;
+
+    using clock = std::chrono::steady_clock;
+    const clock::time_point start = clock::now();
+    clock::time_point next_stats = start + std::chrono::duration_cast<clock::duration>(
+                                       std::chrono::duration<double>( set.stats_interval));
+    uint64_t last_samples = 0;
+    // Ende eines Mitschnitts (Emulator) beendet ebenfalls
+    while( ! stop_requested && source.device().isAsyncStreaming()) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100));
+        if( trigger_requested.exchange( false) && triggered)
+            triggered->trigger();
+        const clock::time_point now = clock::now();
+        if( set.duration > 0 && std::chrono::duration<double>( now - start).count() >= set.duration)
+            break;
+        if( set.stats_interval > 0 && now >= next_stats) {
+            printStatistics( source, last_samples, set.stats_interval, nodes, recorder, udp.get());
+            next_stats += std::chrono::duration_cast<clock::duration>(
+                              std::chrono::duration<double>( set.stats_interval));
+        }
+    }
+
+    source.stopStreaming();
+    graph.disconnectAll();
+    graph.stop();
+    recorder.close();
+    source.close();
+    if( writer.getOverruns())
+        std::cerr << "WARNUNG Datei: " << writer.getOverruns() << " Bloecke verworfen" << std::endl;
+    if( triggered)
+        std::cerr << "INFO Aufnahmen mit Vorlauf: " << triggered->getFileCount() << std::endl;
+    if( server)
+        std::cerr << "INFO Teilstroeme aktiv: " << server->getSubscriberCount() << std::endl;
+    if( carriers)
+        std::cerr << "INFO Carrier geschrieben: " << carriers->getExtractedCount() << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,255 @@
+#ifndef MOUSEEMULATOR_HPP
+#define MOUSEEMULATOR_HPP
+
+#include <string>
+#include <vector>
+#include <complex>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "samplesource.hpp"
+#include "sampleblock.hpp"
+
+
+/// @brief Ersatz fuer die MOUSE ohne Hardware: spielt IQ-Mitschnitte (sc16 oder cf32) ab
+///        oder erzeugt Toene, Rauschen und Bursts. Liefert in Echtzeit (Abtastrate des
+///        gewaehlten Filters) oder so schnell wie moeglich und bildet die Filtertabelle
+///        der MOUSE nach. Gedacht fuer Tests und Benchmarks der gesamten Kette.
+class MouseEmulator : public SampleSource {
+public:
+    enum class Mode {
+        File,   // Mitschnitt abspielen
+        Tone,   // Summe von Toenen plus Rauschen
+        Noise,  // nur Rauschen
+        Burst   // Toene getastet (burst_on von burst_period) plus Rauschen
+    };
+    enum class Format {
+        SC16,   // complex<int16_t>, wie von der MOUSE
+        CF32    // complex<float>, Vollaussteuerung 1.0
+    };
+
+    struct Config {
+        Mode mode = Mode::Tone;
+        std::string path;                       // Mode::File
+        Format format = Format::SC16;           // Mode::File
+        bool loop = true;                       // Mode::File: am Dateiende von vorn beginnen
+        bool paced = true;                      // false: maximale Geschwindigkeit
+        std::vector<double> tones = { 10e3};    // Ablage zur Mittenfrequenz [Hz]
+        double amplitude = .25;                 // je Ton, relativ zur Vollaussteuerung
+        double noise = .01;                     // Effektivwert des Rauschens, relativ
+        double burst_on = .01;                  // [s]
+        double burst_period = .1;               // [s]
+        // { Abtastrate, Filterbreite / 4} wie i2cReadFilter() der MOUSE
+        std::vector<std::vector<uint32_t>> filter = {
+            { 2000000, 400000}, { 1000000, 200000}, { 500000, 100000}, { 250000, 50000},
+            {  125000,  25000}, {   62500,  12500}, {  31250,   6250}};
+        uint32_t filter_index = 0;
+    };
+
+private:
+    Config _conf;
+    std::string _error;
+    bool _is_open;
+    std::atomic_bool _is_async_streaming;
+    std::atomic<uint32_t> _samp_rate;
+    std::atomic<int32_t> _center_freq;
+    std::atomic<uint64_t> _transfer_errors;
+
+    std::ifstream _file;
+    std::vector<std::complex<float>> _file_puff;
+    std::unique_ptr<SampleBlockPool<std::complex<int16_t>>> _block_pool;
+    StreamCallback _stream_callback;
+    std::thread _fred;
+
+    // Synthese
+    std::vector<std::complex<double>> _phasors;
+    std::minstd_rand _rand;
+    uint64_t _sample_index;
+    uint64_t _stream_index;     // Stromposition des naechsten Blocks
+
+    static int16_t toInt16( float value) {
+        return static_cast<int16_t>( std::clamp( std::lround( value * 32767.f), -32768l, 32767l));
+    }
+
+    /// @return Anzahl gelesener Abtastwerte, 0 am Ende der Datei (ohne loop)
+    uint64_t readFile( std::complex<int16_t> *output, uint64_t leng) {
+        uint64_t count = 0;
+        while( count < leng) {
+            const uint64_t left = leng - count;
+            if( _conf.format == Format::SC16) {
+                _file.read( reinterpret_cast<char*>( output + count), left * sizeof( std::complex<int16_t>));
+                count += _file.gcount() / sizeof( std::complex<int16_t>);
+            }
+            else {
+                _file_puff.resize( left);
+                _file.read( reinterpret_cast<char*>( _file_puff.data()), left * sizeof( std::complex<float>));
+                const uint64_t got = _file.gcount() / sizeof( std::complex<float>);
+                for( uint64_t w = 0; w < got; ++w)
+                    output[ count + w] = { toInt16( _file_puff[ w].real()), toInt16( _file_puff[ w].imag())};
+                count += got;
+            }
+            if( count == leng) break;
+            if( _file.bad()) {
+                ++_transfer_errors;
+                break;
+            }
+            // Dateiende
+            if( ! _conf.loop) break;
+            _file.clear();
+            _file.seekg( 0);
+            if( ! _file.good() || _file.peek() == std::ifstream::traits_type::eof()) break;
+        }
+        return count;
+    }
+
+    void synthesise( std::complex<int16_t> *output, uint64_t leng) {
+        const double samp_rate = _samp_rate;
+        const std::complex<float> zero( 0, 0);
+        std::normal_distribution<float> gauss( 0.f, static_cast<float>( _conf.noise / std::sqrt( 2.)));
+        const bool noise = _conf.noise > 0;
+        const bool tones = _conf.mode != Mode::Noise;
+
+        // Drehzeiger je Ton fuer die aktuelle Abtastrate
+        std::vector<std::complex<double>> steps( _conf.tones.size());
+        for( uint64_t t = 0; t < steps.size(); ++t)
+            steps[ t] = std::polar( 1., 2. * M_PI * _conf.tones[ t] / samp_rate);
+
+        const uint64_t burst_period = std::max<uint64_t>( _conf.burst_period * samp_rate, 1);
+        const uint64_t burst_on = _conf.burst_on * samp_rate;
+
+        for( uint64_t w = 0; w < leng; ++w, ++_sample_index) {
+            std::complex<float> samp = zero;
+            const bool keyed = _conf.mode != Mode::Burst || _sample_index % burst_period < burst_on;
+            for( uint64_t t = 0; t < _phasors.size(); ++t) {
+                if( tones && keyed)
+                    samp += std::complex<float>( _phasors[ t] * _conf.amplitude);
+                _phasors[ t] *= steps[ t];
+            }
+            if( noise)
+                samp += std::complex<float>( gauss( _rand), gauss( _rand));
+            output[ w] = { toInt16( samp.real()), toInt16( samp.imag())};
+        }
+        // Betrag der Drehzeiger gegen Rundungsdrift stabilisieren
+        for( auto &phasor : _phasors)
+            phasor /= std::abs( phasor);
+    }
+
+    void run() {
+        using clock = std::chrono::steady_clock;
+        clock::time_point next = clock::now();
+        const uint64_t leng = _block_pool->blockLeng();
+
+        while( _is_async_streaming) {
+            std::shared_ptr<SampleBlock<std::complex<int16_t>>> block = _block_pool->acquire();
+            uint64_t count = leng;
+            if( _conf.mode == Mode::File)
+                count = readFile( block->data(), leng);
+            else
+                synthesise( block->data(), leng);
+            if( ! count) break;
+            block->resize( count);
+            block->setIndex( _stream_index);
+            _stream_index += count;
+
+            if( _conf.paced) {
+                next += std::chrono::duration_cast<clock::duration>(
+                            std::chrono::duration<double>( static_cast<double>( count) / _samp_rate));
+                std::this_thread::sleep_until( next);
+            }
+            _stream_callback( block);
+        }
+        // Ende des Mitschnitts: wie ein abgezogenes Geraet
+        _is_async_streaming = false;
+    }
+
+public:
+    MouseEmulator() : MouseEmulator( Config{}) {}
+    explicit MouseEmulator( const Config &conf)
+        : _conf( conf), _is_open( false), _is_async_streaming( false), _samp_rate( 0),
+          _center_freq( 0), _transfer_errors( 0), _sample_index( 0), _stream_index( 0) {
+        if( _conf.filter.empty())
+            throw std::invalid_argument( "FEHLER MouseEmulator: leere Filtertabelle");
+        _conf.filter_index = std::min<uint32_t>( _conf.filter_index, _conf.filter.size() - 1);
+        _samp_rate = _conf.filter.at( _conf.filter_index).at( 0);
+    }
+    ~MouseEmulator() override {
+        close();
+    }
+
+    int open() override {
+        if( _is_open) return 0;
+        if( _conf.mode == Mode::File) {
+            _file.open( _conf.path, std::ios::binary);
+            if( ! _file) {
+                _error = "FEHLER MouseEmulator::open(): kann " + _conf.path + " nicht oeffnen";
+                return -1;
+            }
+        }
+        _phasors.assign( _conf.tones.size(), std::complex<double>( 1., 0.));
+        _sample_index = 0;
+        _is_open = true;
+        return 0;
+    }
+
+    void close() override {
+        stopAsyncStreaming();
+        if( _file.is_open()) _file.close();
+        _is_open = false;
+    }
+
+    bool isOpen() const override { return _is_open;}
+    std::string getError() const override { return _error;}
+
+    std::vector<std::vector<uint32_t>> getFilter() override { return _conf.filter;}
+
+    int setFilter( uint32_t index) override {
+        if( ! _is_open) return -1;
+        if( index >= _conf.filter.size())
+            throw std::invalid_argument( "FEHLER setFilter(): "
+                                         + std::to_string( index) + " >= "
+                                         + std::to_string( _conf.filter.size()));
+        _samp_rate = _conf.filter[ index].at( 0);
+        return _samp_rate;
+    }
+
+    void setCenterFrequency( int32_t frequency) override {
+        _center_freq = std::min( 1240000000, std::max( 5000, frequency));
+    }
+    int32_t getCenterFrequency() const { return _center_freq;}
+    uint32_t getSampleRate() const { return _samp_rate;}
+
+    int startAsyncStreaming( const StreamCallback &callback,
+                             uint32_t transfer_count = 8,
+                             uint32_t transfer_samples = 16 * 1024) override {
+        if( ! _is_open || _is_async_streaming || _fred.joinable()) return -1;
+        if( ! transfer_count || ! transfer_samples)
+            throw std::invalid_argument( "FEHLER MouseEmulator::startAsyncStreaming(): "
+                                         "transfer_count/transfer_samples == 0");
+        _stream_callback = callback;
+        _transfer_errors = 0;
+        _stream_index = 0;
+        _block_pool = std::make_unique<SampleBlockPool<std::complex<int16_t>>>(
+                          transfer_samples, 4 * transfer_count);
+        _is_async_streaming = true;
+        _fred = std::thread( &MouseEmulator::run, this);
+        return 0;
+    }
+
+    void stopAsyncStreaming() override {
+        _is_async_streaming = false;
+        if( _fred.joinable())
+            _fred.join();
+        _stream_callback = nullptr;
+    }
+
+    bool isAsyncStreaming() const override { return _is_async_streaming;}
+    uint64_t getTransferErrors() const override { return _transfer_errors;}
+};
+
+#endif // MOUSEEMULATOR_HPP
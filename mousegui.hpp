@@ -25,7 +25,7 @@
 #include <limits>
 #include <execution>
 
-#include "libmouse.hpp"
+#include "mousesource.hpp"
 
 
 /// Control Widget for Mouse
@@ -33,31 +33,24 @@ class MouseGUI : public QWidget
 {
     Q_OBJECT
 
-    Mouse _maus;
+    MouseSource _source;
     QTextEdit *_qte_user_info;
     QPushButton *_qpb_connection;
     QLineEdit *_qle_center_freq;
     QComboBox *_qcb_filter_select;
     QFile *_file_out;
-    std::atomic_bool _is_streaming;
     bool _is_record;
 
-    std::vector< std::complex<float>> output;
-    std::thread _th;
-
-    std::vector< std::function<void( const std::vector<std::complex<float>> &)>> _stream_sinks;
-    const float _norm = 1.0 / static_cast<float>( std::numeric_limits<int16_t>::max());
-
 public:
 
-    MouseGUI( void) : _is_streaming(false) {
+    MouseGUI( void) {
         createGUI();
         setSizePolicy( QSizePolicy::MinimumExpanding, QSizePolicy::Minimum);
         setMaximumHeight( 200);
     }
 
     ~MouseGUI(void) {
-        if(_maus.isOpen())
+        if(_source.isOpen())
             openClose();
         delete _qte_user_info;
         delete _qpb_connection;
@@ -65,59 +58,23 @@ public:
         delete _file_out;
     }
 
-    /// @brief Fuegt dem Sample-Streaming-Thread eine Datensenke in form einer Zielfunktion hinzu
-    void
-    addStreamSink( const std::function<void( const std::vector<std::complex<float>> &)> &func) {
-        _stream_sinks.push_back( func);
-    }
+    /// @brief Zugriff auf die int16 -> float Wandlung (Skalierung, DC, IQ-Korrektur)
+    IQConverter& converter() { return _source.converter();}
+
+    /// @brief Ausgang des Sample-Streamings, alle verbundenen Eingaenge teilen sich
+    ///        denselben Block, er darf nicht veraendert werden
+    OutputPort<SampleBlockPtr<std::complex<float>>>& output() { return _source.output();}
+    /// @brief rohe int16-Bloecke der MOUSE (Mitschnitt im nativen Format)
+    OutputPort<SampleBlockPtr<std::complex<int16_t>>>& rawOutput() { return _source.rawOutput();}
+
+    /// @brief Quellknoten ohne Qt (Streaming, Wandlung, Ausgang)
+    MouseSource& source() { return _source;}
 
 private:
     void
     startStreaming(void) {
-        if( ! _maus.isOpen() || _is_streaming) { return;}
-        _th = std::thread( &MouseGUI::streaming, this);
-        _is_streaming = true;
-    }
-
-    void
-    stopStreaming() {
-        if( ! _maus.isOpen() || ! _is_streaming) { return;}
-        _is_streaming = false;
-        if( _th.joinable())
-            _th.join();
-        else throw std::runtime_error("thread not joinable");
-    }
-
-    void outputData( const std::vector<std::complex<float>> input) {
-        if ( _stream_sinks.empty())
-            return;
-        for( auto &sink : _stream_sinks)
-            sink( input);
-    }
-
-    /// nebenlaeufige Funktion
-    /// holt Daten von der MOUSE und sendet diese an alle _stream_sinks
-    void streaming() {
-        if( ! _is_streaming)
-            return;
-        std::vector<std::complex<int16_t>> in(  8 * 1024);
-        std::vector<std::complex<float>> out;
-
-        while( _is_streaming) {
-            std::this_thread::sleep_for( std::chrono::milliseconds( 20));
-            int32_t received = _maus.streamData( in);
-            if( received != static_cast<int32_t>( in.size()))
-                std::cerr << ": received != _tmp.size() - " << received << " != " <<
-                    in.size() << std::endl;
-            for( auto &val : in) {
-                out.push_back( std::complex<float>(
-                    static_cast<float>( val.real()) * _norm,
-                    static_cast<float>( val.imag()) * _norm));
-            }
-            outputData( out);
-            out.clear();
-        }
-        std::cerr << "leaving streaming" << std::endl;
+        if( _source.startStreaming())
+            _qte_user_info->append( QString::fromStdString( _source.getError()));
     }
 
     void
@@ -157,7 +114,7 @@ private:
 
     /// Filter auslesen und als Menu darstellen
     void  loadFilter() {
-        for( const std::vector<uint32_t> &filter : _maus.getFilter()) {
+        for( const std::vector<uint32_t> &filter : _source.getFilter()) {
             double filt = static_cast<double>( filter.at( 1)) * 4 / 1000.0;
             double sps = static_cast<double>( filter.at( 0)) / 1000.0;
             _qcb_filter_select->addItem( QString::number( sps) + " kSps, " +
@@ -170,16 +127,15 @@ private slots:
     /// @brief Versucht eine angeschlossene Mouse zu oeffnen
     void
     openClose(void) {
-        if(_maus.isOpen()) {
-            stopStreaming();
-            _maus.close();
+        if(_source.isOpen()) {
+            _source.close();
             _qcb_filter_select->clear();
             _qpb_connection->setText( "Verbindung getrennt");
             _qpb_connection->setStyleSheet( "background-color: Pale gray; color: black;");
             return;
         }
-        if(_maus.open()) {
-            _qte_user_info->append(QString::fromStdString(_maus.getError()));
+        if(_source.open()) {
+            _qte_user_info->append(QString::fromStdString(_source.getError()));
             return;
         }
         _qpb_connection->setText( "Verbindung hergestellt");
@@ -187,8 +143,6 @@ private slots:
 
         // load mouse_internal filter-options
         loadFilter();
-        // set streaming mode
-        _maus.setGPIFMode();
         // start polling samples
         startStreaming();
         // set first center to 100 MHz
@@ -199,17 +153,17 @@ private slots:
 public slots:
 
     void setFilter( int index) {
-        if( ! _maus.isOpen()) return;
-        int32_t sps = _maus.setFilter( index);
+        if( ! _source.isOpen() || index < 0) return;
+        int32_t sps = _source.setFilter( index);
 
         emit bandwidthChanged( sps);
     }
 
     void setCenterFrequency() {
-        if( ! _maus.isOpen()) return;
+        if( ! _source.isOpen()) return;
         int frequency = static_cast<int>(_qle_center_freq->text().toFloat() * 1000000.0);
         std::cerr << "INFO setCenterFrequency(): " << frequency << std::endl;
-        _maus.setCenterFrequency(static_cast<int32_t>(frequency));
+        _source.setCenterFrequency(static_cast<int32_t>(frequency));
         emit centerFreqChanged( frequency);
     }
 
@@ -0,0 +1,130 @@
+#ifndef MOUSESOURCE_HPP
+#define MOUSESOURCE_HPP
+
+#include <complex>
+#include <atomic>
+#include <limits>
+#include <functional>
+#include <memory>
+
+#include "samplesource.hpp"
+#include "libmouse.hpp"
+#include "sampleblock.hpp"
+#include "iqconvert.hpp"
+#include "ports.hpp"
+
+
+/// @brief Quellknoten ohne Qt: betreibt die MOUSE (oder eine andere SampleSource, z.B.
+///        MouseEmulator) im asynchronen Streaming, wandelt jeden Block einmal nach
+///        complex<float> und verteilt ihn ueber output(). Die rohen int16-Bloecke gibt
+///        rawOutput() unveraendert weiter (Mitschnitt im nativen Format).
+///        Wird von MouseGUI und moused gleichermassen genutzt.
+class MouseSource {
+    std::unique_ptr<SampleSource> _device;
+    IQConverter _converter;
+    SampleBlockPool<std::complex<float>> _block_pool;
+    OutputPort<SampleBlockPtr<std::complex<float>>> _output;
+    OutputPort<SampleBlockPtr<std::complex<int16_t>>> _raw_output;
+    std::atomic_bool _is_streaming;
+    std::atomic<uint64_t> _samples;
+    std::atomic<int32_t> _samp_rate, _center_freq;
+
+    /// Callback des asynchronen Streamings, laeuft im libusb Event-Thread
+    void streaming( const SampleBlockPtr<std::complex<int16_t>> &in) {
+        if( ! _is_streaming)
+            return;
+        _samples += in->size();
+        _raw_output.publish( in);
+        // ohne Abnehmer keine Wandlung, z.B. reiner SC16-Mitschnitt
+        if( ! _output.isConnected())
+            return;
+        std::shared_ptr<SampleBlock<std::complex<float>>> out = _block_pool.acquire( in->size());
+        _converter.convert( in->data(), out->data(), in->size());
+        out->setIndex( in->index());
+        _output.publish( out);
+    }
+
+public:
+    /// @param device Quelle, nullptr: MOUSE ueber USB
+    MouseSource( uint32_t transfer_samples = 16 * 1024, std::unique_ptr<SampleSource> device = nullptr)
+        : _device( device ? std::move( device) : std::make_unique<Mouse>()),
+          _converter( 1.f / static_cast<float>( std::numeric_limits<int16_t>::max())),
+          _block_pool( transfer_samples), _is_streaming( false), _samples( 0),
+          _samp_rate( 0), _center_freq( 0) {}
+
+    ~MouseSource() {
+        close();
+    }
+
+    /// @brief oeffnet die Quelle und schaltet in den Streaming-Betrieb (MOUSE: GPIF-Modus)
+    /// @return 0: alles normal, sonst siehe getError()
+    int open() {
+        if( _device->isOpen()) return 0;
+        if( _device->open()) return -1;
+        _device->setStreamingMode();
+        return 0;
+    }
+
+    void close() {
+        stopStreaming();
+        _device->close();
+    }
+
+    bool isOpen() const { return _device->isOpen();}
+    std::string getError() const { return _device->getError();}
+
+    /// @brief startet das asynchrone Streaming
+    /// @return 0: alles normal, sonst siehe getError()
+    int startStreaming( uint32_t transfer_count = 8) {
+        if( ! _device->isOpen() || _is_streaming) return -1;
+        _is_streaming = true;
+        if( _device->startAsyncStreaming( std::bind( &MouseSource::streaming, this, std::placeholders::_1),
+                                       transfer_count, _block_pool.blockLeng())) {
+            _is_streaming = false;
+            return -1;
+        }
+        return 0;
+    }
+
+    void stopStreaming() {
+        if( ! _is_streaming) return;
+        _is_streaming = false;
+        _device->stopAsyncStreaming();
+    }
+
+    bool isStreaming() const { return _is_streaming;}
+
+    /// @return Abtastrate der Filtereinstellung
+    int setFilter( uint32_t index) {
+        _samp_rate = _device->setFilter( index);
+        return _samp_rate;
+    }
+    void setCenterFrequency( int32_t frequency) {
+        if( ! _device->isOpen()) return;
+        _device->setCenterFrequency( frequency);
+        _center_freq = frequency;
+    }
+    /// @brief zuletzt eingestellte Abtastrate [Sps] und Mittenfrequenz [Hz], 0: noch nicht gesetzt
+    int32_t getSampleRate() const { return _samp_rate;}
+    int32_t getCenterFrequency() const { return _center_freq;}
+    std::vector<std::vector<uint32_t>> getFilter() { return _device->getFilter();}
+
+    /// @brief Anzahl gewandelter Abtastwerte seit dem Oeffnen
+    uint64_t getSampleCount() const { return _samples;}
+    uint64_t getTransferErrors() const { return _device->getTransferErrors();}
+
+    /// @brief Zugriff auf die int16 -> float Wandlung (Skalierung, DC, IQ-Korrektur); die
+    ///        Setter sind auch waehrend des Streamings erlaubt
+    IQConverter& converter() { return _converter;}
+
+    /// @brief Ausgang des Sample-Streamings, alle verbundenen Eingaenge teilen sich
+    ///        denselben Block, er darf nicht veraendert werden
+    OutputPort<SampleBlockPtr<std::complex<float>>>& output() { return _output;}
+    /// @brief Ausgang der rohen int16-Bloecke vor IQConverter, ebenfalls geteilt
+    OutputPort<SampleBlockPtr<std::complex<int16_t>>>& rawOutput() { return _raw_output;}
+
+    /// @brief die betriebene Quelle
+    SampleSource& device() { return *_device;}
+};
+
+#endif // MOUSESOURCE_HPP
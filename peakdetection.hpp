@@ -15,48 +15,60 @@ struct Peak {
 
 
 /// @brief Try to find peaks by sorting descending by magnitude while keeping index and looking
-///        left/right for threshold (peak - left/right < 12.)-> match!
-/// @param input  floats ( i.e. PSD)
-/// @param peaks output tuple of peaks <mag, left, right>
+///        left/right until the level dropped by threshold -> range of the peak. The input is
+///        a spectrum in FFT order and wraps around: a peak may span DC (bin 0) and the
+///        Nyquist edge, pos_right is then >= input.size() (pos_right - pos_left is the width).
+///        A candidate whose range runs into a stronger peak without a dip of threshold in
+///        between is part of that peak's skirt (window leakage, sidelobes) and not reported.
+/// @param input  floats ( i.e. PSD in dB)
+/// @param peaks output peaks <left, right, mag>
 /// @param threshold difference peak and left/rigth in dB
 /// @param stepping left right going for check threshold
-void findPeaks( const std::vector<float> &input, std::vector< Peak> &peaks,
+inline void findPeaks( const std::vector<float> &input, std::vector< Peak> &peaks,
                float threshold = 12., uint64_t stepping = 1) {
-    std::vector<std::pair<uint64_t, float>> _indexed_samples( input.size());
-    float avg = std::accumulate( input.begin(), input.end(), .0);
-    avg /= input.size();
+    const uint64_t leng = input.size();
+    std::vector<std::pair<uint64_t, float>> _indexed_samples( leng);
     std::transform( input.begin(), input.end(), _indexed_samples.begin(),
-                   [ index = 0] (float val) mutable {return std::make_pair( static_cast<uint64_t>( index), val);});
-    // absteiend sortieren
+                   [ index = 0] (float val) mutable {return std::make_pair( static_cast<uint64_t>( index++), val);});
+    // absteigend sortieren
     std::sort( _indexed_samples.begin(), _indexed_samples.end(), []
-              ( const auto &a, const auto &b) { return a.second < b.second;});
+              ( const auto &a, const auto &b) { return a.second > b.second;});
+    if( _indexed_samples.empty()) return;
+    stepping = std::clamp<uint64_t>( stepping, 1, leng);
+    // Rauschboden: Median, Peaks muessen mindestens threshold darueber liegen
+    const float floor = _indexed_samples.at( _indexed_samples.size() / 2).second;
+    // Bereiche [left, right] zyklisch, right darf ueber leng hinaus zeigen
+    const auto inPeak = [ &peaks, leng]( uint64_t pos) {
+        for( const auto &peak : peaks)
+            if( ( pos + leng - peak.pos_left) % leng <= peak.pos_right - peak.pos_left)
+                return true;
+        return false;
+    };
 
     // check descending ordered samples for possible peaks
     for( const auto &samp : _indexed_samples) {
-        bool in_free_range = true;
-        // check sample if it is in an existing peak-range
-        for( const auto &peak : peaks) {
-            if(    samp.first > peak.pos_left
-                || samp.first < peak.pos_right) {
-                in_free_range = false;
-                break;
-            }
-        }
+        if( samp.second - floor < threshold) break;
         // range already taken
-        if( ! in_free_range) continue;
-
-        uint64_t width = std::min( input.size() / 2, std::min( samp.first, input.size() - samp.first));
+        if( inPeak( samp.first)) continue;
 
+        // nach links und rechts ausdehnen, bis der Pegel um threshold gefallen ist; laeuft
+        // die Ausdehnung in einen staerkeren Peak, ist das nur dessen Flanke
         const float mag = samp.second;
-        const uint64_t pos = samp.first;
-        for( uint64_t w = 0; w < width; ++w) {
-            // check if threshold reached
-            if(    ( mag - input.at( pos + w)) > threshold
-                || ( mag - input.at( pos - w)) > threshold) {
-                peaks.emplace_back( mag, pos - w, pos + w);
-                break;
-            }
+        uint64_t left = 0, right = 0;     // Abstand zur Position
+        bool skirt = false;
+        while( left + right + stepping < leng && ! skirt
+               && mag - input[ ( samp.first + leng - ( left + stepping) % leng) % leng] < threshold) {
+            left += stepping;
+            skirt = inPeak( ( samp.first + leng - left % leng) % leng);
+        }
+        while( left + right + stepping < leng && ! skirt
+               && mag - input[ ( samp.first + right + stepping) % leng] < threshold) {
+            right += stepping;
+            skirt = inPeak( ( samp.first + right) % leng);
         }
+        if( skirt) continue;
+        const uint64_t pos_left = ( samp.first + leng - left % leng) % leng;
+        peaks.push_back( { pos_left, pos_left + left + right, mag});
     }
 }
 
@@ -0,0 +1,84 @@
+#ifndef PORTS_HPP
+#define PORTS_HPP
+
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <stdexcept>
+
+
+template <typename T>
+class OutputPort;
+
+/// @brief Eingang eines Knotens fuer Daten vom Typ T. Ein Eingang hat genau eine
+///        Verbindung, damit die Warteschlange dahinter ein SPSC-Ring bleiben kann.
+template <typename T>
+class InputPort {
+    template <typename> friend class OutputPort;
+    OutputPort<T> *_upstream = nullptr;
+
+protected:
+    /// @brief loest die Verbindung, muss vor dem Abbau des Knotens aufgerufen werden
+    void disconnectInput() {
+        if( _upstream) _upstream->disconnect( *this);
+    }
+
+public:
+    virtual ~InputPort() { disconnectInput();}
+
+    /// @brief wird im Thread des Erzeugers aufgerufen und darf nicht blockieren
+    virtual void dataIn( const T &input) = 0;
+
+    bool isConnected() const { return _upstream;}
+};
+
+
+/// @brief Ausgang eines Knotens: verteilt jeden Datensatz an alle verbundenen Eingaenge
+template <typename T>
+class OutputPort {
+    std::vector<InputPort<T>*> _connections;
+    mutable std::mutex _mutexer;
+
+public:
+    OutputPort() = default;
+    OutputPort( const OutputPort<T> &) = delete;
+    OutputPort& operator =( const OutputPort<T> &) = delete;
+    ~OutputPort() { disconnectAll();}
+
+    void connect( InputPort<T> &input) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        if( input._upstream)
+            throw std::invalid_argument( "FEHLER OutputPort::connect(): Eingang bereits verbunden");
+        input._upstream = this;
+        _connections.push_back( &input);
+    }
+
+    void disconnect( InputPort<T> &input) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        auto it = std::find( _connections.begin(), _connections.end(), &input);
+        if( it == _connections.end()) return;
+        ( *it)->_upstream = nullptr;
+        _connections.erase( it);
+    }
+
+    void disconnectAll() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        for( InputPort<T> *input : _connections)
+            input->_upstream = nullptr;
+        _connections.clear();
+    }
+
+    bool isConnected() const {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return ! _connections.empty();
+    }
+
+    /// @brief reicht data an alle Eingaenge weiter (gleiche Referenz, keine Kopie)
+    void publish( const T &data) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        for( InputPort<T> *input : _connections)
+            input->dataIn( data);
+    }
+};
+
+#endif // PORTS_HPP
@@ -0,0 +1,232 @@
+#ifndef PSD_HPP
+#define PSD_HPP
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "stft.hpp"
+#include "decibel.hpp"
+
+
+/// @brief Mittelung von Leistungsspektren (|X|^2 je bin) mit konstantem Aufwand je bin und
+///        Frame. Der Speicher wird bei setLeng()/setAverage() einmal angelegt.
+///        Ausgabe in dBFS: ein Ton mit Vollaussteuerung (|x| = 1) ergibt 0 dBFS in seinem
+///        bin. Mit setEnbwCorrection( true) wird zusaetzlich durch die aequivalente
+///        Rauschbandbreite des Fensters geteilt, Rauschen erscheint dann unabhaengig vom
+///        Fenster als Leistung je bin.
+class PsdAverage {
+public:
+    enum class Mode {
+        Linear,         // gleitender Mittelwert ueber die letzten avg Frames (Welch)
+        Exponential,    // IIR, alpha = 1 / avg, bis avg Frames gesammelt sind linear
+        PeakHold,       // Maximum je bin seit reset()
+        MinHold         // Minimum je bin seit reset()
+    };
+
+private:
+    uint64_t _leng, _avg;
+    Mode _mode;
+    bool _enbw_correction;
+
+    std::vector<double> _acc;       // Summe (Linear) bzw. Zustand je bin
+    std::vector<float> _ring;       // Mode::Linear: die letzten avg Frames, _avg * _leng
+    uint64_t _ring_pos;
+    uint64_t _count;                // Frames seit reset(), Linear: hoechstens avg
+
+    double _window_sum, _window_power_sum;
+    double _scale;
+
+    void setupScale() {
+        const double coherent = _window_sum * _window_sum;
+        _scale = coherent > 0 ? 1. / coherent : 1.;
+        if( _enbw_correction)
+            _scale /= enbw();
+    }
+
+    /// @brief ein Frame, power( w) liefert |X|^2 des bins w
+    template <typename Power>
+    void update( Power power) {
+        double *acc = _acc.data();
+        switch( _mode) {
+        case Mode::Linear: {
+            float *slot = _ring.data() + _ring_pos * _leng;
+            if( _count < _avg) {
+                for( uint64_t w = 0; w < _leng; ++w) {
+                    const float p = power( w);
+                    acc[ w] += p;
+                    slot[ w] = p;
+                }
+                ++_count;
+            }
+            else {
+                // aeltesten Frame abziehen, neuen addieren
+                for( uint64_t w = 0; w < _leng; ++w) {
+                    const float p = power( w);
+                    acc[ w] += static_cast<double>( p) - slot[ w];
+                    slot[ w] = p;
+                }
+            }
+            _ring_pos = ( _ring_pos + 1) % _avg;
+            break;
+        }
+        case Mode::Exponential: {
+            ++_count;
+            const double alpha = std::max( 1. / static_cast<double>( _avg), 1. / static_cast<double>( _count));
+            for( uint64_t w = 0; w < _leng; ++w)
+                acc[ w] += alpha * ( power( w) - acc[ w]);
+            break;
+        }
+        case Mode::PeakHold:
+            if( ! _count++)
+                for( uint64_t w = 0; w < _leng; ++w) acc[ w] = power( w);
+            else
+                for( uint64_t w = 0; w < _leng; ++w) acc[ w] = std::max<double>( acc[ w], power( w));
+            break;
+        case Mode::MinHold:
+            if( ! _count++)
+                for( uint64_t w = 0; w < _leng; ++w) acc[ w] = power( w);
+            else
+                for( uint64_t w = 0; w < _leng; ++w) acc[ w] = std::min<double>( acc[ w], power( w));
+            break;
+        }
+    }
+
+public:
+    /// @param leng bins je Frame
+    /// @param avg Mode::Linear Anzahl gemittelter Frames, Mode::Exponential Zeitkonstante in Frames
+    PsdAverage( uint64_t leng = 1024, Mode mode = Mode::Exponential, uint64_t avg = 8)
+        : _leng( 0), _avg( std::max<uint64_t>( avg, 1)), _mode( mode), _enbw_correction( false),
+          _ring_pos( 0), _count( 0), _window_sum( 0), _window_power_sum( 0), _scale( 1.) {
+        setLeng( leng);
+    }
+
+    void setLeng( uint64_t leng) {
+        _leng = leng;
+        // Rechteckfenster bis setWindow()
+        setWindow( static_cast<double>( leng), static_cast<double>( leng));
+        reset();
+    }
+    void setMode( Mode mode) {
+        _mode = mode;
+        reset();
+    }
+    void setAverage( uint64_t avg) {
+        _avg = std::max<uint64_t>( avg, 1);
+        reset();
+    }
+
+    /// @brief Kalibrierung auf das Fenster der STFT
+    /// @param window_sum Summe der Fensterkoeffizienten
+    /// @param window_power_sum Summe der quadrierten Fensterkoeffizienten
+    void setWindow( double window_sum, double window_power_sum) {
+        _window_sum = window_sum;
+        _window_power_sum = window_power_sum;
+        setupScale();
+    }
+    void setEnbwCorrection( bool enbw_correction) {
+        _enbw_correction = enbw_correction;
+        setupScale();
+    }
+
+    /// @brief aequivalente Rauschbandbreite des Fensters in bins (Hann: 1.5)
+    double enbw() const {
+        if( _window_sum <= 0) return 1.;
+        return static_cast<double>( _leng) * _window_power_sum / ( _window_sum * _window_sum);
+    }
+
+    uint64_t leng() const { return _leng;}
+    uint64_t getAverage() const { return _avg;}
+    Mode getMode() const { return _mode;}
+    /// @brief Anzahl eingeflossener Frames seit reset() (Linear: hoechstens avg)
+    uint64_t count() const { return _count;}
+
+    /// @brief verwirft die Mittelung, der Speicher bleibt erhalten
+    void reset() {
+        _acc.assign( _leng, 0.);
+        if( _mode == Mode::Linear)
+            _ring.assign( _leng * _avg, 0.f);
+        else
+            _ring.clear();
+        _ring_pos = 0;
+        _count = 0;
+    }
+
+    /// @brief ein Frame Leistungswerte |X|^2
+    void push( const float *power, uint64_t leng) {
+        if( leng != _leng) throw std::invalid_argument( "FEHLER PsdAverage::push(): leng != leng()");
+        update( [ power]( uint64_t w) { return power[ w];});
+    }
+
+    /// @brief ein Frame komplexer Spektralwerte, |X|^2 wird im selben Durchgang gebildet
+    void push( const std::complex<float> *spectrum, uint64_t leng) {
+        if( leng != _leng) throw std::invalid_argument( "FEHLER PsdAverage::push(): leng != leng()");
+        update( [ spectrum]( uint64_t w) { return std::norm( spectrum[ w]);});
+    }
+
+    /// @brief ein Frame der STFT, passt Laenge und Fensterkalibrierung selbst an
+    void push( const StftFrame &frame) {
+        const uint64_t leng = frame.leng();
+        if( ! leng) return;
+        if( leng != _leng) setLeng( leng);
+        if( frame.window_sum != _window_sum || frame.window_power_sum != _window_power_sum)
+            setWindow( frame.window_sum, frame.window_power_sum);
+        push( frame.spectrum->data(), leng);
+    }
+
+    /// @brief aktuelle Schaetzung in FFT-Reihenfolge
+    /// @param db true: 10*log10 [dBFS], false: linear, auf Vollaussteuerung bezogen
+    void get( std::vector<float> &output, bool db = true) const {
+        output.resize( _leng);
+        if( ! _count) {
+            std::fill( output.begin(), output.end(), db ? -300.f : 0.f);
+            return;
+        }
+        const double scale = _mode == Mode::Linear ? _scale / static_cast<double>( _count) : _scale;
+        std::transform( _acc.begin(), _acc.end(), output.begin(), [ scale]( double val)
+                        { return static_cast<float>( val * scale);});
+        if( db)
+            Decibel::fromPower( output.data(), output.data(), _leng);
+    }
+};
+
+
+/// @brief Welch-Schaetzer: gefensterte, ueberlappende Segmente (Stft) werden ueber
+///        PsdAverage gemittelt. Fuer den synchronen Einsatz ohne FlowGraph, im FlowGraph
+///        teilen sich die Abonnenten eines StftProcessor dessen Frames und mitteln selbst.
+class Welch : private InputPort<StftFrame> {
+    Stft _stft;
+    PsdAverage _average;
+
+    void dataIn( const StftFrame &frame) override {
+        _average.push( frame);
+    }
+
+public:
+    /// @param hop Vorschub, leng / 2: 50% Ueberlappung
+    Welch( uint64_t leng = 1024, uint64_t hop = 512,
+           PsdAverage::Mode mode = PsdAverage::Mode::Linear, uint64_t avg = 8,
+           Stft::Window window = Stft::Window::VonHann)
+        : _stft( leng, hop, window, false), _average( leng, mode, avg) {
+        _stft.output().connect( *this);
+    }
+
+    void push( const std::complex<float> *input, uint64_t leng) { _stft.push( input, leng);}
+    void push( const std::vector<std::complex<float>> &input) { _stft.push( input.data(), input.size());}
+
+    /// @brief siehe PsdAverage::get()
+    void get( std::vector<float> &output, bool db = true) const { _average.get( output, db);}
+
+    /// @brief verwirft Mittelung und angesammelte Abtastwerte
+    void reset() {
+        _stft.reset();
+        _average.reset();
+    }
+
+    Stft& stft() { return _stft;}
+    PsdAverage& average() { return _average;}
+};
+
+#endif // PSD_HPP
@@ -0,0 +1,393 @@
+#ifndef RECORDING_HPP
+#define RECORDING_HPP
+
+#include <string>
+#include <vector>
+#include <complex>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <mutex>
+#include <optional>
+#include <sys/stat.h>
+
+#include "sampleblock.hpp"
+#include "filewriter.hpp"
+#include "sigmf.hpp"
+#include "sampleencoder.hpp"
+
+
+/// @brief Abtastformat eines Mitschnitts. SC16 ist das native Format der MOUSE und braucht
+///        halb so viel Platte wie CF32 ohne Informationsverlust, SC8 noch einmal die Haelfte.
+///        SC8BFP und LOSSLESS sind kodiert (SampleCodec::Encoder), die Datei ist nur mit
+///        SampleCodec::Encoder::decode() lesbar.
+enum class RecordFormat {
+    SC16,       // complex<int16_t>, unveraendert aus Mouse::streamData
+    CF32,       // complex<float>, nach IQConverter (DC/IQ-Korrektur), Vollaussteuerung 1.0
+    SC8,        // complex<int8_t>, aus SC16 mit einstellbarer Verstaerkung und Saettigung
+    SC8BFP,     // SampleEncoding::SC8Bfp aus SC16, ein Exponent je 256 Werte
+    LOSSLESS    // SampleEncoding::Lossless aus SC16, verlustfrei
+};
+
+inline const char*
+formatName( RecordFormat format) {
+    switch( format) {
+    case RecordFormat::SC16: return "sc16";
+    case RecordFormat::CF32: return "cf32";
+    case RecordFormat::SC8:  return "sc8";
+    case RecordFormat::SC8BFP:   return "sc8bfp";
+    case RecordFormat::LOSSLESS: return "lossless";
+    }
+    return "";
+}
+
+inline RecordFormat
+formatFromName( const std::string &name) {
+    if( name == "sc16") return RecordFormat::SC16;
+    if( name == "cf32") return RecordFormat::CF32;
+    if( name == "sc8") return RecordFormat::SC8;
+    if( name == "sc8bfp") return RecordFormat::SC8BFP;
+    if( name == "lossless") return RecordFormat::LOSSLESS;
+    throw std::invalid_argument( "FEHLER unbekanntes Aufnahmeformat: " + name);
+}
+
+/// @brief Bytes je komplexem Abtastwert, 0 bei kodierten Formaten (veraenderliche Laenge)
+inline uint64_t
+bytesPerSample( RecordFormat format) {
+    switch( format) {
+    case RecordFormat::SC16: return 2 * sizeof( int16_t);
+    case RecordFormat::CF32: return 2 * sizeof( float);
+    case RecordFormat::SC8:  return 2 * sizeof( int8_t);
+    default: break;
+    }
+    return 0;
+}
+
+/// @brief Kodierung der Datei, nur fuer SC8BFP und LOSSLESS von Bedeutung
+inline SampleEncoding
+sampleEncoding( RecordFormat format) {
+    switch( format) {
+    case RecordFormat::CF32:     return SampleEncoding::CF32;
+    case RecordFormat::SC8BFP:   return SampleEncoding::SC8Bfp;
+    case RecordFormat::LOSSLESS: return SampleEncoding::Lossless;
+    default: break;
+    }
+    return SampleEncoding::SC16;
+}
+
+inline bool
+isEncoded( RecordFormat format) {
+    return format == RecordFormat::SC8BFP || format == RecordFormat::LOSSLESS;
+}
+
+
+/// @brief SigMF core:datatype des Formats. Kodierte Formate haben keinen core-Datentyp:
+///        ein allgemeiner SigMF-Leser soll die Datei ablehnen, statt die Einheiten des
+///        Encoders als ci16_le zu lesen. Die dekodierten Werte beschreibt
+///        mouse:decoded_datatype (siehe decodedDatatype()).
+inline const char*
+sigmfDatatype( RecordFormat format) {
+    switch( format) {
+    case RecordFormat::SC16: return "ci16_le";
+    case RecordFormat::CF32: return "cf32_le";
+    case RecordFormat::SC8:  return "ci8";
+    case RecordFormat::SC8BFP: return "mouse_sc8bfp";
+    case RecordFormat::LOSSLESS: return "mouse_lossless";
+    }
+    return "";
+}
+
+/// @brief Datentyp nach dem Dekodieren, leer bei unkodierten Formaten
+inline const char*
+decodedDatatype( RecordFormat format) {
+    return isEncoded( format) ? "ci16_le" : "";
+}
+
+
+/// @brief Beschreibung eines Mitschnitts, landet als SigMF in "<name>.sigmf-meta"
+struct RecordMeta {
+    RecordFormat format = RecordFormat::SC16;
+    double samp_rate = 0;                           // [Sps], aus setFilter()
+    double center_freq = 0;                         // [Hz]
+    std::chrono::system_clock::time_point start_time;
+    double scale = 1.;                              // Ganzzahl * scale = Vollaussteuerung 1.0
+};
+
+
+/// @brief Mitschnitt im gewaehlten Format: nimmt sowohl die rohen int16-Bloecke der Quelle
+///        als auch die gewandelten complex<float>-Bloecke an und schreibt nur die, die zum
+///        Format passen (SC16/SC8: roh, CF32: gewandelt). Geschrieben wird ueber den
+///        FileWriter (eigener Schreibthread), daneben entsteht die SigMF-Beschreibung:
+///        ein Capture je lueckenlosem Abschnitt (core:global_index = SampleBlock::index())
+///        und je Umstimmung, Annotationen z.B. aus der Carrier-Erkennung ueber annotate().
+///        Beim Anfuegen wird die vorhandene Beschreibung gelesen und fortgesetzt, Datentyp,
+///        Skalierung und Abtastrate muessen passen.
+///        Kodierte Formate schreiben je Block eine in sich geschlossene Einheit des
+///        SampleCodec::Encoder; getCompressionRatio() meldet das erreichte Verhaeltnis.
+class Recorder {
+    FileWriter _writer;
+    std::atomic<RecordFormat> _format, _active;   // eingestellt, in der offenen Datei
+    std::atomic<float> _sc8_gain;
+    float _active_gain;
+    std::atomic_bool _recording;
+    std::string _error;
+
+    // Schreiben, SigMF und Buchfuehrung unter _mutexer: open() setzt alles zurueck,
+    // waehrend write() und annotate() aus anderen Threads kommen
+    std::mutex _mutexer;
+    std::vector<std::complex<int8_t>> _buf_sc8;
+    SampleCodec::Encoder _encoder;
+    std::vector<uint8_t> _buf_encoded;
+    std::string _meta_path;
+    SigMF::Meta _sigmf;
+    uint64_t _own_captures;         // Captures davor stammen aus der angefuegten Datei
+    std::atomic<double> _center_freq;
+    std::atomic_bool _retuned;
+    bool _gap;
+    uint64_t _file_samples, _expected_index, _first_index;
+    std::optional<std::chrono::system_clock::time_point> _first_time;
+
+    /// @brief fuehrt Buch ueber die Lage des Blocks in der Datei, Luecke oder Umstimmung
+    ///        beginnen einen neuen Capture; unter _mutexer
+    void track( uint64_t index, uint64_t leng, bool written) {
+        if( ! written) {
+            _gap = true;
+            return;
+        }
+        if( _gap || index != _expected_index || _retuned.exchange( false)) {
+            SigMF::Capture cap;
+            cap.sample_start = _file_samples;
+            cap.global_index = index;
+            cap.frequency = _center_freq;
+            if( ! _first_time) {
+                _first_index = index;
+                _first_time = std::chrono::system_clock::now();
+                cap.datetime = *_first_time;
+            }
+            else {
+                // Zeit aus der Stromposition, genauer als die Ankunftszeit des Blocks
+                const double secs = _sigmf.sample_rate > 0
+                                    ? static_cast<double>( index - _first_index) / _sigmf.sample_rate : 0.;
+                cap.datetime = *_first_time + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                                  std::chrono::duration<double>( secs));
+            }
+            _sigmf.captures.push_back( cap);
+            _gap = false;
+        }
+        _file_samples += leng;
+        _expected_index = index + leng;
+    }
+
+public:
+    Recorder() : _format( RecordFormat::SC16), _active( RecordFormat::SC16), _sc8_gain( 1.f), _active_gain( 1.f),
+                 _recording( false), _own_captures( 0), _center_freq( 0), _retuned( false),
+                 _gap( true), _file_samples( 0), _expected_index( 0), _first_index( 0) {}
+    ~Recorder() {
+        close();
+    }
+
+    /// @brief gilt ab dem naechsten open()
+    void setFormat( RecordFormat format) { _format = format;}
+    RecordFormat getFormat() const { return _format;}
+
+    /// @brief SC8 = saettigen( SC16 * gain / 256), gain > 1 hebt schwache Signale ueber
+    ///        die 8 bit, gilt ab dem naechsten open()
+    void setSc8Gain( float gain) { _sc8_gain = gain;}
+
+    /// @brief Umstimmen waehrend der Aufnahme beginnt einen neuen Capture
+    void setCenterFrequency( double center_freq) {
+        if( center_freq == _center_freq) return;
+        _center_freq = center_freq;
+        _retuned = true;
+    }
+
+    /// @param meta Abtastrate, Mittenfrequenz; Format, Startzeit und Skalierung setzt open()
+    /// @param append an die Datei anfuegen; ihre .sigmf-meta wird gelesen und fortgesetzt
+    ///        und muss in Datentyp, Skalierung und Abtastrate passen
+    /// @return 0: alles normal, -1: Fehler (siehe getError())
+    int open( const std::string &path, bool append, RecordMeta meta) {
+        close();
+        _error.clear();
+        meta.format = _format.load();
+        if( append && isEncoded( meta.format)) {
+            // die Lage der vorhandenen Werte ist ohne Dekodieren unbekannt
+            _error = std::string( "FEHLER Anfuegen nicht moeglich im Format ") + formatName( meta.format);
+            return -1;
+        }
+        const float gain = _sc8_gain;
+        meta.start_time = std::chrono::system_clock::now();
+        const double full_scale = static_cast<double>( std::numeric_limits<int16_t>::max());
+        switch( meta.format) {
+        case RecordFormat::SC16: meta.scale = 1. / full_scale; break;
+        case RecordFormat::CF32: meta.scale = 1.; break;
+        case RecordFormat::SC8:  meta.scale = 256. / ( gain * full_scale); break;
+        case RecordFormat::SC8BFP:
+        case RecordFormat::LOSSLESS: meta.scale = 1. / full_scale; break;
+        }
+        // Skalierung nur bei ganzzahligen (auch dekodierten) Werten, cf32 ist schon bezogen
+        std::ostringstream desc;
+        desc << std::setprecision( 9) << "MOUSE Mitschnitt";
+        if( meta.format != RecordFormat::CF32)
+            desc << ", Vollaussteuerung 1.0 = Ganzzahl * " << meta.scale;
+
+        // vorhandene Beschreibung fortsetzen, bevor die Datei angefasst wird
+        const std::string meta_path = SigMF::metaPath( path);
+        SigMF::Meta sigmf;
+        struct stat st{};
+        const bool existing = append && ! ::stat( path.c_str(), &st);
+        if( existing && ! ::stat( meta_path.c_str(), &st)) {
+            std::string error;
+            if( sigmf.read( meta_path, &error)) {
+                _error = "FEHLER Anfuegen: " + error;
+                return -1;
+            }
+            if( sigmf.datatype != sigmfDatatype( meta.format) || ! sigmf.encoding.empty()
+                || sigmf.description != desc.str()) {
+                _error = "FEHLER Anfuegen: " + path + " ist " + sigmf.datatype + " (" + sigmf.description
+                         + "), nicht " + formatName( meta.format);
+                return -1;
+            }
+            if( sigmf.sample_rate > 0 && meta.samp_rate > 0 && sigmf.sample_rate != meta.samp_rate) {
+                std::ostringstream msg;
+                msg << std::setprecision( 12) << "FEHLER Anfuegen: Abtastrate " << sigmf.sample_rate << " der Datei, nicht " << meta.samp_rate;
+                _error = msg.str();
+                return -1;
+            }
+        }
+        else {
+            sigmf.datatype = sigmfDatatype( meta.format);
+            if( isEncoded( meta.format)) {
+                sigmf.encoding = encodingName( sampleEncoding( meta.format));
+                sigmf.decoded_datatype = decodedDatatype( meta.format);
+            }
+            sigmf.description = desc.str();
+            if( ! SigMF::isDataPath( path))
+                sigmf.dataset = SigMF::fileName( path);
+        }
+        if( meta.samp_rate > 0) sigmf.sample_rate = meta.samp_rate;
+        // beim Anfuegen beginnt der erste Capture hinter den vorhandenen Abtastwerten
+        const uint64_t file_samples = existing && ! ::stat( path.c_str(), &st)
+                                      ? static_cast<uint64_t>( st.st_size) / bytesPerSample( meta.format) : 0;
+
+        if( _writer.open( path, append)) return -1;
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _active = meta.format;
+        _active_gain = gain;
+        _encoder.setEncoding( sampleEncoding( meta.format));
+        _encoder.resetStatistics();
+        _meta_path = meta_path;
+        _sigmf = std::move( sigmf);
+        _own_captures = _sigmf.captures.size();
+        _center_freq = meta.center_freq;
+        _retuned = false;
+        _gap = true;
+        _first_time.reset();
+        _file_samples = file_samples;
+        _sigmf.write( _meta_path);
+        _recording = true;
+        return 0;
+    }
+
+    /// @brief schliesst die Datei und schreibt die SigMF-Beschreibung mit allen Captures
+    ///        und Annotationen
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            if( ! _recording.exchange( false)) return;
+        }
+        // write() laeuft nicht mehr, der Schreibthread leert seinen Ring
+        _writer.close();
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _sigmf.write( _meta_path);
+    }
+
+    /// @brief Annotation an Stromposition global_start (SampleBlock::index(), StftFrame::
+    ///        sample_index), wird in die Lage in der Datei umgerechnet
+    /// @return false, wenn die Position nicht in der Aufnahme liegt
+    bool annotate( uint64_t global_start, uint64_t sample_count, double freq_lower, double freq_upper,
+                   const std::string &label, const std::string &comment = "") {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        if( ! _recording) return false;
+        // letzter eigene Capture, der vor global_start beginnt; angefuegte Dateien haben
+        // die Stromposition eines frueheren Laufs
+        const SigMF::Capture *cap = nullptr;
+        for( uint64_t w = _own_captures; w < _sigmf.captures.size(); ++w) {
+            const SigMF::Capture &capture = _sigmf.captures[ w];
+            if( capture.global_index && *capture.global_index <= global_start)
+                cap = &capture;
+        }
+        if( ! cap) return false;
+        SigMF::Annotation anno;
+        anno.sample_start = cap->sample_start + ( global_start - *cap->global_index);
+        anno.sample_count = sample_count;
+        anno.freq_lower_edge = freq_lower;
+        anno.freq_upper_edge = freq_upper;
+        anno.label = label;
+        anno.comment = comment;
+        _sigmf.annotations.push_back( std::move( anno));
+        return true;
+    }
+
+    /// @brief rohe Bloecke der Quelle (MouseSource::rawOutput()), fuer SC16, SC8 und die
+    ///        kodierten Formate
+    void write( const SampleBlockPtr<std::complex<int16_t>> &input) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        if( ! _recording) return;
+        switch( _active.load()) {
+        case RecordFormat::SC16:
+            track( input->index(), input->size(), _writer.write( input));
+            break;
+        case RecordFormat::SC8: {
+            const uint64_t leng = input->size();
+            _buf_sc8.resize( leng);
+            const float gain = _active_gain / 256.f;
+            const int16_t *in = reinterpret_cast<const int16_t*>( input->data());
+            int8_t *out = reinterpret_cast<int8_t*>( _buf_sc8.data());
+            for( uint64_t w = 0; w < 2 * leng; ++w) {
+                const float val = std::clamp( in[ w] * gain, -127.f, 127.f);
+                out[ w] = static_cast<int8_t>( val + ( val < 0.f ? -.5f : .5f));
+            }
+            track( input->index(), leng, _writer.write( _buf_sc8.data(), leng * sizeof( std::complex<int8_t>)));
+            break;
+        }
+        case RecordFormat::SC8BFP:
+        case RecordFormat::LOSSLESS: {
+            const uint64_t bytes = _encoder.encode( input->data(), input->size(), _buf_encoded);
+            track( input->index(), input->size(), _writer.write( _buf_encoded.data(), bytes));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    /// @brief gewandelte Bloecke (MouseSource::output()), nur fuer CF32
+    void write( const SampleBlockPtr<std::complex<float>> &input) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        if( _recording && _active == RecordFormat::CF32)
+            track( input->index(), input->size(), _writer.write( input));
+    }
+
+    bool isRecording() const { return _recording;}
+    uint64_t bytesWritten() const { return _writer.bytesWritten();}
+    /// @brief cf32-Bytes je Byte in der Datei (CF32: 1, SC16: 2, SC8: 4), bei kodierten
+    ///        Formaten ueber die bisher geschriebenen Bloecke gemessen
+    double getCompressionRatio() const {
+        const RecordFormat format = _active;
+        if( isEncoded( format)) return _encoder.ratio();
+        return 8. / static_cast<double>( bytesPerSample( format));
+    }
+    FileWriter& writer() { return _writer;}
+    std::string getError() { return _error.empty() ? _writer.getError() : _error;}
+    std::string getMetaPath() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return _meta_path;
+    }
+};
+
+#endif // RECORDING_HPP
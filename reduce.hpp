@@ -0,0 +1,231 @@
+#ifndef REDUCE_HPP
+#define REDUCE_HPP
+
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined( __x86_64__) || defined( __i386__)
+#include <immintrin.h>
+#endif
+
+#include "simd.hpp"
+
+
+/// @brief Verdichtung von leng bins auf width Bildspalten: jede Spalte erhaelt Maximum,
+///        Mittelwert oder Minimum der bins [ c * leng / width, ( c + 1) * leng / width).
+///        Mit Max bleiben schmale Traeger sichtbar. Ist width >= leng, wird je Spalte der
+///        naechstliegende bin genommen. Der Vektor-Kernel wird zur Laufzeit gewaehlt.
+namespace Reduce {
+
+enum class Mode { Max, Mean, Min};
+
+namespace detail {
+
+inline float
+runScalar( const float *input, uint64_t leng, Mode mode) {
+    float acc = input[ 0];
+    switch( mode) {
+    case Mode::Max:  for( uint64_t w = 1; w < leng; ++w) acc = std::max( acc, input[ w]); return acc;
+    case Mode::Min:  for( uint64_t w = 1; w < leng; ++w) acc = std::min( acc, input[ w]); return acc;
+    case Mode::Mean: for( uint64_t w = 1; w < leng; ++w) acc += input[ w]; return acc / static_cast<float>( leng);
+    }
+    return acc;
+}
+
+#if defined( __x86_64__) || defined( __i386__)
+
+template <Mode M>
+__attribute__(( target( "sse2"))) inline __m128
+opSSE2( __m128 a, __m128 b) {
+    if constexpr( M == Mode::Max) return _mm_max_ps( a, b);
+    else if constexpr( M == Mode::Min) return _mm_min_ps( a, b);
+    else return _mm_add_ps( a, b);
+}
+
+/// @brief 4 Lanes auf einen Wert
+template <Mode M>
+__attribute__(( target( "sse2"))) inline float
+horizontalSSE2( __m128 acc) {
+    acc = opSSE2<M>( acc, _mm_movehl_ps( acc, acc));
+    acc = opSSE2<M>( acc, _mm_shuffle_ps( acc, acc, _MM_SHUFFLE( 1, 1, 1, 1)));
+    return _mm_cvtss_f32( acc);
+}
+
+template <Mode M>
+__attribute__(( target( "sse2"))) inline float
+runSSE2( const float *input, uint64_t leng) {
+    if( leng < 8) return runScalar( input, leng, M);
+    __m128 acc = _mm_loadu_ps( input);
+    uint64_t w = 4;
+    for( ; w + 4 <= leng; w += 4)
+        acc = opSSE2<M>( acc, _mm_loadu_ps( input + w));
+    // Rest: die letzten 4 Werte ueberlappend laden (Mittelwert: nur die neuen)
+    if( w < leng) {
+        if constexpr( M == Mode::Mean) {
+            for( ; w < leng; ++w)
+                acc = _mm_add_ss( acc, _mm_load_ss( input + w));
+        }
+        else
+            acc = opSSE2<M>( acc, _mm_loadu_ps( input + leng - 4));
+    }
+    const float result = horizontalSSE2<M>( acc);
+    return M == Mode::Mean ? result / static_cast<float>( leng) : result;
+}
+
+template <Mode M>
+__attribute__(( target( "avx2"))) inline __m256
+opAVX2( __m256 a, __m256 b) {
+    if constexpr( M == Mode::Max) return _mm256_max_ps( a, b);
+    else if constexpr( M == Mode::Min) return _mm256_min_ps( a, b);
+    else return _mm256_add_ps( a, b);
+}
+
+template <Mode M>
+__attribute__(( target( "avx2"))) inline float
+runAVX2( const float *input, uint64_t leng) {
+    if( leng < 16) return runSSE2<M>( input, leng);
+    __m256 acc = _mm256_loadu_ps( input);
+    uint64_t w = 8;
+    for( ; w + 8 <= leng; w += 8)
+        acc = opAVX2<M>( acc, _mm256_loadu_ps( input + w));
+    if( w < leng) {
+        if constexpr( M == Mode::Mean) {
+            // fehlende Lanes mit 0 auffuellen
+            const __m256i lanes = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7);
+            const __m256i mask = _mm256_cmpgt_epi32( _mm256_set1_epi32( static_cast<int>( leng - w)), lanes);
+            acc = _mm256_add_ps( acc, _mm256_maskload_ps( input + w, mask));
+        }
+        else
+            acc = opAVX2<M>( acc, _mm256_loadu_ps( input + leng - 8));
+    }
+    const float result = horizontalSSE2<M>( opSSE2<M>( _mm256_castps256_ps128( acc), _mm256_extractf128_ps( acc, 1)));
+    return M == Mode::Mean ? result / static_cast<float>( leng) : result;
+}
+
+template <Mode M>
+__attribute__(( target( "avx512f"))) inline float
+runAVX512( const float *input, uint64_t leng) {
+    if( leng < 32) return runAVX2<M>( input, leng);
+    __m512 acc = _mm512_loadu_ps( input);
+    uint64_t w = 16;
+    for( ; w + 16 <= leng; w += 16) {
+        const __m512 v = _mm512_loadu_ps( input + w);
+        if constexpr( M == Mode::Max) acc = _mm512_max_ps( acc, v);
+        else if constexpr( M == Mode::Min) acc = _mm512_min_ps( acc, v);
+        else acc = _mm512_add_ps( acc, v);
+    }
+    // Rest maskiert, die fehlenden Lanes bleiben unveraendert
+    if( w < leng) {
+        const __mmask16 mask = static_cast<__mmask16>( ( 1u << ( leng - w)) - 1);
+        const __m512 v = _mm512_maskz_loadu_ps( mask, input + w);
+        if constexpr( M == Mode::Max) acc = _mm512_mask_max_ps( acc, mask, acc, v);
+        else if constexpr( M == Mode::Min) acc = _mm512_mask_min_ps( acc, mask, acc, v);
+        else acc = _mm512_add_ps( acc, v);
+    }
+    if constexpr( M == Mode::Max) return _mm512_reduce_max_ps( acc);
+    else if constexpr( M == Mode::Min) return _mm512_reduce_min_ps( acc);
+    else return _mm512_reduce_add_ps( acc) / static_cast<float>( leng);
+}
+
+#endif
+
+/// @brief Spaltengrenzen ohne Division: run = q oder q + 1, Rest wird aufaddiert
+struct Columns {
+    uint64_t begin = 0, q, r, acc = 0, width;
+    Columns( uint64_t leng, uint64_t width) : q( leng / width), r( leng % width), width( width) {}
+    uint64_t next() {
+        acc += r;
+        uint64_t run = q;
+        if( acc >= width) {
+            acc -= width;
+            ++run;
+        }
+        return run;
+    }
+};
+
+template <Mode M>
+inline void
+columnsScalar( const float *input, uint64_t leng, float *output, uint64_t width) {
+    Columns col( leng, width);
+    for( uint64_t c = 0; c < width; ++c) {
+        const uint64_t run = col.next();
+        output[ c] = runScalar( input + col.begin, run, M);
+        col.begin += run;
+    }
+}
+
+#if defined( __x86_64__) || defined( __i386__)
+
+template <Mode M>
+__attribute__(( target( "sse2"))) inline void
+columnsSSE2( const float *input, uint64_t leng, float *output, uint64_t width) {
+    Columns col( leng, width);
+    for( uint64_t c = 0; c < width; ++c) {
+        const uint64_t run = col.next();
+        output[ c] = runSSE2<M>( input + col.begin, run);
+        col.begin += run;
+    }
+}
+
+template <Mode M>
+__attribute__(( target( "avx2"))) inline void
+columnsAVX2( const float *input, uint64_t leng, float *output, uint64_t width) {
+    Columns col( leng, width);
+    for( uint64_t c = 0; c < width; ++c) {
+        const uint64_t run = col.next();
+        output[ c] = runAVX2<M>( input + col.begin, run);
+        col.begin += run;
+    }
+}
+
+template <Mode M>
+__attribute__(( target( "avx512f"))) inline void
+columnsAVX512( const float *input, uint64_t leng, float *output, uint64_t width) {
+    Columns col( leng, width);
+    for( uint64_t c = 0; c < width; ++c) {
+        const uint64_t run = col.next();
+        output[ c] = runAVX512<M>( input + col.begin, run);
+        col.begin += run;
+    }
+}
+
+#endif
+
+template <Mode M>
+inline void
+columns( const float *input, uint64_t leng, float *output, uint64_t width) {
+    switch( Simd::level()) {
+#if defined( __x86_64__) || defined( __i386__)
+    case Simd::Level::AVX512: columnsAVX512<M>( input, leng, output, width); return;
+    case Simd::Level::AVX2:   columnsAVX2<M>( input, leng, output, width); return;
+    case Simd::Level::SSE2:   columnsSSE2<M>( input, leng, output, width); return;
+#endif
+    default: break;
+    }
+    columnsScalar<M>( input, leng, output, width);
+}
+
+}
+
+
+/// @brief verdichtet input (leng bins) auf output (width Spalten)
+inline void
+toWidth( const float *input, uint64_t leng, float *output, uint64_t width, Mode mode = Mode::Max) {
+    if( ! leng || ! width) return;
+    if( width >= leng) {
+        for( uint64_t c = 0; c < width; ++c)
+            output[ c] = input[ c * leng / width];
+        return;
+    }
+    switch( mode) {
+    case Mode::Max:  detail::columns<Mode::Max>( input, leng, output, width); break;
+    case Mode::Mean: detail::columns<Mode::Mean>( input, leng, output, width); break;
+    case Mode::Min:  detail::columns<Mode::Min>( input, leng, output, width); break;
+    }
+}
+
+}
+
+#endif // REDUCE_HPP
@@ -0,0 +1,125 @@
+#ifndef SAMPLEBLOCK_HPP
+#define SAMPLEBLOCK_HPP
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+
+/// @brief Block of samples handed out by a SampleBlockPool. The storage keeps its
+///        capacity over the whole lifetime, only the number of valid samples changes.
+template <typename T>
+class SampleBlock {
+    std::vector<T> _data;
+    uint64_t _size;
+    uint64_t _index;
+
+public:
+    explicit SampleBlock( uint64_t capacity) : _data( capacity), _size( capacity), _index( 0) {}
+
+    T* data() { return _data.data();}
+    const T* data() const { return _data.data();}
+
+    /// @brief number of valid samples
+    uint64_t size() const { return _size;}
+    uint64_t capacity() const { return _data.size();}
+    bool empty() const { return ! _size;}
+
+    /// @brief sets the number of valid samples, grows the storage only if necessary
+    void resize( uint64_t size) {
+        if( size > _data.size()) _data.resize( size);
+        _size = size;
+    }
+
+    /// @brief stream position of the first sample (counted by the source since the start
+    ///        of streaming), gaps between consecutive blocks mark lost samples
+    uint64_t index() const { return _index;}
+    void setIndex( uint64_t index) { _index = index;}
+
+    T& operator[]( uint64_t index) { return _data[ index];}
+    const T& operator[]( uint64_t index) const { return _data[ index];}
+
+    T* begin() { return _data.data();}
+    T* end() { return _data.data() + _size;}
+    const T* begin() const { return _data.data();}
+    const T* end() const { return _data.data() + _size;}
+};
+
+/// @brief shared, read-only reference to a block - this is what travels to the sinks
+template <typename T>
+using SampleBlockPtr = std::shared_ptr<const SampleBlock<T>>;
+
+
+/// @brief Pool of reference counted SampleBlocks. A block returns to the pool as soon
+///        as the last owner releases it, so in steady state no sample memory is
+///        allocated. The pool may be destroyed while blocks are still in flight.
+template <typename T>
+class SampleBlockPool {
+    struct Storage {
+        std::mutex mutexer;
+        std::vector<std::unique_ptr<SampleBlock<T>>> free;
+        uint64_t max_free;
+        std::atomic<uint64_t> allocated{ 0};
+    };
+
+    std::shared_ptr<Storage> _storage;
+    uint64_t _block_leng;
+
+public:
+    /// @param block_leng samples per block
+    /// @param prealloc blocks allocated upfront
+    /// @param max_free upper limit of idle blocks kept for reuse
+    SampleBlockPool( uint64_t block_leng, uint64_t prealloc = 16, uint64_t max_free = 256)
+        : _storage( std::make_shared<Storage>()), _block_leng( block_leng) {
+        _storage->max_free = std::max( max_free, prealloc);
+        _storage->free.reserve( _storage->max_free);
+        for( uint64_t w = 0; w < prealloc; ++w)
+            _storage->free.push_back( std::make_unique<SampleBlock<T>>( block_leng));
+        _storage->allocated = prealloc;
+    }
+
+    SampleBlockPool( const SampleBlockPool<T> &) = delete;
+    SampleBlockPool& operator =( const SampleBlockPool<T> &) = delete;
+
+    /// @brief returns a writable block with leng valid samples (0: default block_leng)
+    std::shared_ptr<SampleBlock<T>>
+    acquire( uint64_t leng = 0) {
+        if( ! leng) leng = _block_leng;
+        std::unique_ptr<SampleBlock<T>> block;
+        {
+            std::lock_guard<std::mutex> lock( _storage->mutexer);
+            if( ! _storage->free.empty()) {
+                block = std::move( _storage->free.back());
+                _storage->free.pop_back();
+            }
+        }
+        if( ! block) {
+            block = std::make_unique<SampleBlock<T>>( std::max( leng, _block_leng));
+            ++_storage->allocated;
+        }
+        block->resize( leng);
+
+        // der Deleter haelt den Speicher des Pools am Leben, bis der letzte Block zurueck ist
+        return std::shared_ptr<SampleBlock<T>>( block.release(),
+            [ storage = _storage]( SampleBlock<T> *released) {
+                std::lock_guard<std::mutex> lock( storage->mutexer);
+                if( storage->free.size() < storage->max_free)
+                    storage->free.emplace_back( released);
+                else {
+                    delete released;
+                    --storage->allocated;
+                }
+            });
+    }
+
+    uint64_t blockLeng() const { return _block_leng;}
+    void setBlockLeng( uint64_t leng) { _block_leng = leng;}
+
+    /// @brief number of blocks currently owned by the pool (idle and in flight)
+    uint64_t allocated() const { return _storage->allocated;}
+};
+
+#endif // SAMPLEBLOCK_HPP
@@ -0,0 +1,560 @@
+#ifndef SAMPLEENCODER_HPP
+#define SAMPLEENCODER_HPP
+
+#include <complex>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined( __x86_64__) || defined( __i386__)
+#include <immintrin.h>
+#endif
+
+#include "simd.hpp"
+
+
+/// @brief Kodierung der Abtastwerte fuer Netz und Platte, Vollaussteuerung jeweils 1.0:
+///        CF32      8 Byte/Wert, unveraendert
+///        SC16      4 Byte/Wert, int16 * 32767
+///        SC8Bfp    2 Byte/Wert plus 3 Byte je Block: Block-Floating-Point, ein Exponent
+///                  (Rechtsverschiebung des int16-Werts) je Block, Werte als int8
+///        Lossless  verlustfrei gegenueber SC16: Differenz zum vorigen Wert derselben
+///                  Komponente, Zickzack, Bitpacken in Gruppen zu 64 Komponenten mit
+///                  eigener Bitbreite; typisch 1.3 - 3 x kleiner als SC16
+///        Die Werte entsprechen UdpSampleFormat im Kopf der Datagramme.
+enum class SampleEncoding : uint8_t {
+    CF32     = 1,
+    SC16     = 2,
+    SC8Bfp   = 4,
+    Lossless = 5
+};
+
+inline const char*
+encodingName( SampleEncoding encoding) {
+    switch( encoding) {
+    case SampleEncoding::CF32:     return "cf32";
+    case SampleEncoding::SC16:     return "sc16";
+    case SampleEncoding::SC8Bfp:   return "sc8bfp";
+    case SampleEncoding::Lossless: return "lossless";
+    }
+    return "";
+}
+
+inline SampleEncoding
+encodingFromName( const std::string &name) {
+    if( name == "cf32") return SampleEncoding::CF32;
+    if( name == "sc16") return SampleEncoding::SC16;
+    if( name == "sc8bfp") return SampleEncoding::SC8Bfp;
+    if( name == "lossless") return SampleEncoding::Lossless;
+    throw std::invalid_argument( "FEHLER unbekannte Kodierung: " + name);
+}
+
+
+namespace SampleCodec {
+
+constexpr float full_scale = 32767.f;
+/// @brief Komponenten je Bitpack-Gruppe (Lossless)
+constexpr uint64_t group = 64;
+/// @brief Kopf eines SC8Bfp-Blocks: Verschiebung (u8), Anzahl Werte (u16)
+constexpr uint64_t bfp_header = 3;
+/// @brief hoechstens so viele Werte je Lossless-Einheit, laengere Bloecke werden aufgeteilt;
+///        der Decoder lehnt groessere Angaben ab, bevor er Speicher anlegt
+constexpr uint64_t lossless_unit = uint64_t( 1) << 20;
+
+namespace detail {
+
+// ---- float -> int16 (gesaettigt, gerundet) ----
+
+inline void
+toInt16Scalar( const float *input, int16_t *output, uint64_t count) {
+    for( uint64_t w = 0; w < count; ++w)
+        output[ w] = static_cast<int16_t>( std::lrintf( std::clamp( input[ w] * full_scale, -32768.f, 32767.f)));
+}
+
+// ---- groesster Betrag der int16-Komponenten ----
+
+inline int
+maxAbsScalar( const int16_t *input, uint64_t count) {
+    int max_abs = 0;
+    for( uint64_t w = 0; w < count; ++w)
+        max_abs = std::max( max_abs, std::abs( static_cast<int>( input[ w])));
+    return max_abs;
+}
+
+// ---- int16 -> int8 mit gerundeter Rechtsverschiebung ----
+
+inline void
+shiftToInt8Scalar( const int16_t *input, int8_t *output, uint64_t count, int shift) {
+    const int round = shift ? 1 << ( shift - 1) : 0;
+    for( uint64_t w = 0; w < count; ++w)
+        output[ w] = static_cast<int8_t>( std::clamp( ( input[ w] + round) >> shift, -128, 127));
+}
+
+// ---- Differenz zur vorigen Komponente gleicher Art (I bzw. Q) und Zickzack ----
+
+inline uint16_t
+zigzag( int16_t delta) {
+    return static_cast<uint16_t>( ( static_cast<uint16_t>( delta) << 1) ^ static_cast<uint16_t>( delta >> 15));
+}
+
+inline void
+deltaZigzagScalar( const int16_t *input, uint16_t *output, uint64_t begin, uint64_t count) {
+    for( uint64_t w = begin; w < count; ++w) {
+        const int16_t prev = w >= 2 ? input[ w - 2] : 0;
+        output[ w] = zigzag( static_cast<int16_t>( static_cast<uint16_t>( input[ w]) - static_cast<uint16_t>( prev)));
+    }
+}
+
+#if defined( __x86_64__) || defined( __i386__)
+
+__attribute__(( target( "sse2"))) inline void
+toInt16SSE2( const float *input, int16_t *output, uint64_t count) {
+    const __m128 scale = _mm_set1_ps( full_scale);
+    const __m128 lo = _mm_set1_ps( -32768.f), hi = _mm_set1_ps( 32767.f);
+    uint64_t w = 0;
+    for( ; w + 8 <= count; w += 8) {
+        const __m128 a = _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( input + w), scale), lo), hi);
+        const __m128 b = _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( input + w + 4), scale), lo), hi);
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( output + w),
+                          _mm_packs_epi32( _mm_cvtps_epi32( a), _mm_cvtps_epi32( b)));
+    }
+    toInt16Scalar( input + w, output + w, count - w);
+}
+
+__attribute__(( target( "avx2"))) inline void
+toInt16AVX2( const float *input, int16_t *output, uint64_t count) {
+    const __m256 scale = _mm256_set1_ps( full_scale);
+    const __m256 lo = _mm256_set1_ps( -32768.f), hi = _mm256_set1_ps( 32767.f);
+    uint64_t w = 0;
+    for( ; w + 16 <= count; w += 16) {
+        const __m256 a = _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( _mm256_loadu_ps( input + w), scale), lo), hi);
+        const __m256 b = _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( _mm256_loadu_ps( input + w + 8), scale), lo), hi);
+        // packs arbeitet je 128-bit Haelfte, die Reihenfolge wird danach korrigiert
+        const __m256i packed = _mm256_packs_epi32( _mm256_cvtps_epi32( a), _mm256_cvtps_epi32( b));
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( output + w), _mm256_permute4x64_epi64( packed, 0xd8));
+    }
+    toInt16Scalar( input + w, output + w, count - w);
+}
+
+__attribute__(( target( "avx512f"))) inline void
+toInt16AVX512( const float *input, int16_t *output, uint64_t count) {
+    const __m512 scale = _mm512_set1_ps( full_scale);
+    const __m512 lo = _mm512_set1_ps( -32768.f), hi = _mm512_set1_ps( 32767.f);
+    uint64_t w = 0;
+    for( ; w + 16 <= count; w += 16) {
+        const __m512 a = _mm512_min_ps( _mm512_max_ps( _mm512_mul_ps( _mm512_loadu_ps( input + w), scale), lo), hi);
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( output + w), _mm512_cvtsepi32_epi16( _mm512_cvtps_epi32( a)));
+    }
+    toInt16Scalar( input + w, output + w, count - w);
+}
+
+__attribute__(( target( "sse2"))) inline int
+maxAbsSSE2( const int16_t *input, uint64_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    uint64_t w = 0;
+    for( ; w + 8 <= count; w += 8) {
+        const __m128i x = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + w));
+        // subs: -(-32768) saettigt auf 32767
+        acc = _mm_max_epi16( acc, _mm_max_epi16( x, _mm_subs_epi16( zero, x)));
+    }
+    alignas( 16) int16_t part[ 8];
+    _mm_store_si128( reinterpret_cast<__m128i*>( part), acc);
+    int max_abs = maxAbsScalar( input + w, count - w);
+    for( int16_t val : part) max_abs = std::max( max_abs, static_cast<int>( val));
+    return max_abs;
+}
+
+__attribute__(( target( "avx2"))) inline int
+maxAbsAVX2( const int16_t *input, uint64_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    uint64_t w = 0;
+    for( ; w + 16 <= count; w += 16) {
+        const __m256i x = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( input + w));
+        acc = _mm256_max_epi16( acc, _mm256_max_epi16( x, _mm256_subs_epi16( zero, x)));
+    }
+    alignas( 32) int16_t part[ 16];
+    _mm256_store_si256( reinterpret_cast<__m256i*>( part), acc);
+    int max_abs = maxAbsScalar( input + w, count - w);
+    for( int16_t val : part) max_abs = std::max( max_abs, static_cast<int>( val));
+    return max_abs;
+}
+
+__attribute__(( target( "sse2"))) inline void
+shiftToInt8SSE2( const int16_t *input, int8_t *output, uint64_t count, int shift) {
+    const __m128i round = _mm_set1_epi16( static_cast<int16_t>( shift ? 1 << ( shift - 1) : 0));
+    const __m128i cnt = _mm_cvtsi32_si128( shift);
+    uint64_t w = 0;
+    for( ; w + 16 <= count; w += 16) {
+        const __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + w));
+        const __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + w + 8));
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( output + w),
+                          _mm_packs_epi16( _mm_sra_epi16( _mm_adds_epi16( a, round), cnt),
+                                           _mm_sra_epi16( _mm_adds_epi16( b, round), cnt)));
+    }
+    shiftToInt8Scalar( input + w, output + w, count - w, shift);
+}
+
+__attribute__(( target( "avx2"))) inline void
+shiftToInt8AVX2( const int16_t *input, int8_t *output, uint64_t count, int shift) {
+    const __m256i round = _mm256_set1_epi16( static_cast<int16_t>( shift ? 1 << ( shift - 1) : 0));
+    const __m128i cnt = _mm_cvtsi32_si128( shift);
+    uint64_t w = 0;
+    for( ; w + 32 <= count; w += 32) {
+        const __m256i a = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( input + w));
+        const __m256i b = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( input + w + 16));
+        const __m256i packed = _mm256_packs_epi16( _mm256_sra_epi16( _mm256_adds_epi16( a, round), cnt),
+                                                   _mm256_sra_epi16( _mm256_adds_epi16( b, round), cnt));
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( output + w), _mm256_permute4x64_epi64( packed, 0xd8));
+    }
+    shiftToInt8Scalar( input + w, output + w, count - w, shift);
+}
+
+__attribute__(( target( "sse2"))) inline void
+deltaZigzagSSE2( const int16_t *input, uint16_t *output, uint64_t count) {
+    deltaZigzagScalar( input, output, 0, std::min<uint64_t>( count, 2));
+    uint64_t w = 2;
+    for( ; w + 8 <= count; w += 8) {
+        const __m128i cur = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + w));
+        const __m128i prev = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + w - 2));
+        const __m128i delta = _mm_sub_epi16( cur, prev);
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( output + w),
+                          _mm_xor_si128( _mm_slli_epi16( delta, 1), _mm_srai_epi16( delta, 15)));
+    }
+    deltaZigzagScalar( input, output, std::max<uint64_t>( w, 2), count);
+}
+
+__attribute__(( target( "avx2"))) inline void
+deltaZigzagAVX2( const int16_t *input, uint16_t *output, uint64_t count) {
+    deltaZigzagScalar( input, output, 0, std::min<uint64_t>( count, 2));
+    uint64_t w = 2;
+    for( ; w + 16 <= count; w += 16) {
+        const __m256i cur = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( input + w));
+        const __m256i prev = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( input + w - 2));
+        const __m256i delta = _mm256_sub_epi16( cur, prev);
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( output + w),
+                             _mm256_xor_si256( _mm256_slli_epi16( delta, 1), _mm256_srai_epi16( delta, 15)));
+    }
+    deltaZigzagScalar( input, output, std::max<uint64_t>( w, 2), count);
+}
+
+#endif
+
+// ---- Kernelwahl zur Laufzeit ----
+
+inline void
+toInt16( const float *input, int16_t *output, uint64_t count) {
+#if defined( __x86_64__) || defined( __i386__)
+    switch( Simd::level()) {
+    case Simd::Level::AVX512: toInt16AVX512( input, output, count); return;
+    case Simd::Level::AVX2:   toInt16AVX2( input, output, count); return;
+    case Simd::Level::SSE2:   toInt16SSE2( input, output, count); return;
+    default: break;
+    }
+#endif
+    toInt16Scalar( input, output, count);
+}
+
+inline int
+maxAbs( const int16_t *input, uint64_t count) {
+#if defined( __x86_64__) || defined( __i386__)
+    switch( Simd::level()) {
+    case Simd::Level::AVX512:
+    case Simd::Level::AVX2:   return maxAbsAVX2( input, count);
+    case Simd::Level::SSE2:   return maxAbsSSE2( input, count);
+    default: break;
+    }
+#endif
+    return maxAbsScalar( input, count);
+}
+
+inline void
+shiftToInt8( const int16_t *input, int8_t *output, uint64_t count, int shift) {
+#if defined( __x86_64__) || defined( __i386__)
+    switch( Simd::level()) {
+    case Simd::Level::AVX512:
+    case Simd::Level::AVX2:   shiftToInt8AVX2( input, output, count, shift); return;
+    case Simd::Level::SSE2:   shiftToInt8SSE2( input, output, count, shift); return;
+    default: break;
+    }
+#endif
+    shiftToInt8Scalar( input, output, count, shift);
+}
+
+inline void
+deltaZigzag( const int16_t *input, uint16_t *output, uint64_t count) {
+#if defined( __x86_64__) || defined( __i386__)
+    switch( Simd::level()) {
+    case Simd::Level::AVX512:
+    case Simd::Level::AVX2:   deltaZigzagAVX2( input, output, count); return;
+    case Simd::Level::SSE2:   deltaZigzagSSE2( input, output, count); return;
+    default: break;
+    }
+#endif
+    deltaZigzagScalar( input, output, 0, count);
+}
+
+/// @brief packt group Werte mit width Bit, davor ein Byte width
+inline uint8_t*
+packGroup( const uint16_t *input, uint8_t *output) {
+    uint16_t bits = 0;
+    for( uint64_t w = 0; w < group; ++w) bits |= input[ w];
+    const int width = bits ? 32 - __builtin_clz( bits) : 0;
+    *output++ = static_cast<uint8_t>( width);
+    uint64_t acc = 0;
+    int fill = 0;
+    for( uint64_t w = 0; w < group; ++w) {
+        acc |= static_cast<uint64_t>( input[ w]) << fill;
+        fill += width;
+        if( fill >= 32) {
+            const uint32_t word = static_cast<uint32_t>( acc);
+            std::memcpy( output, &word, 4);
+            output += 4;
+            acc >>= 32;
+            fill -= 32;
+        }
+    }
+    // group * width ist ein Vielfaches von 8
+    for( ; fill > 0; fill -= 8) {
+        *output++ = static_cast<uint8_t>( acc);
+        acc >>= 8;
+    }
+    return output;
+}
+
+}
+
+
+/// @brief groesste Byte-Anzahl fuer leng Werte, Puffer fuer encode() so gross anlegen
+/// @param bfp_block Werte je Exponent bei SC8Bfp
+inline uint64_t
+maxBytes( SampleEncoding encoding, uint64_t leng, uint64_t bfp_block = 256) {
+    switch( encoding) {
+    case SampleEncoding::CF32:   return leng * 8;
+    case SampleEncoding::SC16:   return leng * 4;
+    case SampleEncoding::SC8Bfp: return leng * 2 + ( leng + bfp_block - 1) / bfp_block * bfp_header;
+    case SampleEncoding::Lossless: {
+        // je Einheit ein Kopf und hoechstens eine angebrochene Gruppe
+        const uint64_t units = std::max<uint64_t>( 1, ( leng + lossless_unit - 1) / lossless_unit);
+        const uint64_t groups = 2 * leng / group + units;
+        return 4 * units + groups * ( 1 + 2 * group);
+    }
+    }
+    return 0;
+}
+
+/// @brief meiste Werte, deren Kodierung sicher in bytes passt (ein Block bzw. eine Einheit)
+inline uint64_t
+maxSamples( SampleEncoding encoding, uint64_t bytes) {
+    switch( encoding) {
+    case SampleEncoding::CF32:   return bytes / 8;
+    case SampleEncoding::SC16:   return bytes / 4;
+    case SampleEncoding::SC8Bfp: return bytes > bfp_header ? std::min<uint64_t>( ( bytes - bfp_header) / 2, 0xffff) : 0;
+    case SampleEncoding::Lossless:
+        return bytes > 4 ? ( bytes - 4) / ( 1 + 2 * group) * ( group / 2) : 0;
+    }
+    return 0;
+}
+
+
+/// @brief Kodierer fuer Datei- und Netzsenken. Eingang sind die gewandelten cf32- oder die
+///        rohen sc16-Bloecke; cf32 wird fuer SC16/SC8Bfp/Lossless zuerst auf int16
+///        gerundet. Die Vektor-Kernel (Wandlung, Maximum, Verschiebung, Differenz) werden
+///        zur Laufzeit gewaehlt. Das Ergebnis ist in sich geschlossen: jeder encode()-Aufruf
+///        laesst sich ohne die vorigen dekodieren (ein Datagramm, ein Dateiabschnitt).
+class Encoder {
+    SampleEncoding _encoding;
+    uint64_t _bfp_block;
+    std::vector<int16_t> _int16;
+    std::vector<uint16_t> _zigzag;
+    std::atomic<uint64_t> _samples, _bytes;
+
+    uint64_t encodeInt16( const int16_t *input, uint64_t leng, uint8_t *output) {
+        uint8_t *out = output;
+        const uint64_t count = 2 * leng;
+        switch( _encoding) {
+        case SampleEncoding::SC16:
+            std::memcpy( out, input, count * sizeof( int16_t));
+            out += count * sizeof( int16_t);
+            break;
+        case SampleEncoding::SC8Bfp:
+            for( uint64_t beg = 0; beg < leng; beg += _bfp_block) {
+                const uint64_t block = std::min( _bfp_block, leng - beg);
+                const int16_t *in = input + 2 * beg;
+                const int max_abs = detail::maxAbs( in, 2 * block);
+                int shift = 0;
+                while( shift < 8 && ( max_abs >> shift) > 127) ++shift;
+                const uint16_t nblock = static_cast<uint16_t>( block);
+                *out++ = static_cast<uint8_t>( shift);
+                std::memcpy( out, &nblock, 2);
+                out += 2;
+                detail::shiftToInt8( in, reinterpret_cast<int8_t*>( out), 2 * block, shift);
+                out += 2 * block;
+            }
+            break;
+        case SampleEncoding::Lossless:
+            // auch leng == 0 ergibt eine (leere) Einheit
+            for( uint64_t beg = 0, unit = 0; beg == 0 || beg < leng; beg += unit) {
+                unit = std::min( lossless_unit, leng - beg);
+                const uint64_t values = 2 * unit;
+                const uint32_t nsamples = static_cast<uint32_t>( unit);
+                std::memcpy( out, &nsamples, 4);
+                out += 4;
+                const uint64_t padded = ( values + group - 1) / group * group;
+                _zigzag.resize( padded);
+                detail::deltaZigzag( input + 2 * beg, _zigzag.data(), values);
+                std::fill( _zigzag.begin() + values, _zigzag.end(), 0);
+                for( uint64_t grp = 0; grp < padded; grp += group)
+                    out = detail::packGroup( _zigzag.data() + grp, out);
+                if( ! unit) break;
+            }
+            break;
+        default:
+            break;
+        }
+        return out - output;
+    }
+
+    uint64_t account( uint64_t leng, uint64_t bytes) {
+        _samples += leng;
+        _bytes += bytes;
+        return bytes;
+    }
+
+public:
+    Encoder( SampleEncoding encoding = SampleEncoding::SC16, uint64_t bfp_block = 256)
+        : _encoding( encoding), _bfp_block( std::clamp<uint64_t>( bfp_block, 1, 0xffff)), _samples( 0), _bytes( 0) {}
+
+    void setEncoding( SampleEncoding encoding) { _encoding = encoding;}
+    SampleEncoding encoding() const { return _encoding;}
+    /// @brief Werte je Exponent (SC8Bfp), hoechstens 65535
+    void setBfpBlock( uint64_t bfp_block) { _bfp_block = std::clamp<uint64_t>( bfp_block, 1, 0xffff);}
+
+    /// @param output mindestens maxBytes( encoding(), leng) gross
+    /// @return geschriebene Bytes
+    uint64_t encode( const std::complex<float> *input, uint64_t leng, uint8_t *output) {
+        if( _encoding == SampleEncoding::CF32) {
+            std::memcpy( output, input, leng * sizeof( std::complex<float>));
+            return account( leng, leng * sizeof( std::complex<float>));
+        }
+        _int16.resize( 2 * leng);
+        detail::toInt16( reinterpret_cast<const float*>( input), _int16.data(), 2 * leng);
+        return account( leng, encodeInt16( _int16.data(), leng, output));
+    }
+    uint64_t encode( const std::complex<int16_t> *input, uint64_t leng, uint8_t *output) {
+        if( _encoding == SampleEncoding::CF32) {
+            std::complex<float> *out = reinterpret_cast<std::complex<float>*>( output);
+            for( uint64_t w = 0; w < leng; ++w)
+                out[ w] = std::complex<float>( input[ w].real() / full_scale, input[ w].imag() / full_scale);
+            return account( leng, leng * sizeof( std::complex<float>));
+        }
+        return account( leng, encodeInt16( reinterpret_cast<const int16_t*>( input), leng, output));
+    }
+    template <typename T>
+    uint64_t encode( const T *input, uint64_t leng, std::vector<uint8_t> &output) {
+        output.resize( maxBytes( _encoding, leng, _bfp_block));
+        output.resize( encode( input, leng, output.data()));
+        return output.size();
+    }
+
+    /// @brief dekodiert bytes (eine oder mehrere aneinandergehaengte encode()-Ausgaben)
+    ///        und haengt die Werte an output an
+    /// @return false: Daten unvollstaendig oder fehlerhaft
+    static bool decode( SampleEncoding encoding, const uint8_t *input, uint64_t bytes,
+                        std::vector<std::complex<float>> &output) {
+        const uint8_t *end = input + bytes;
+        switch( encoding) {
+        case SampleEncoding::CF32: {
+            const uint64_t leng = bytes / sizeof( std::complex<float>);
+            const uint64_t offset = output.size();
+            output.resize( offset + leng);
+            std::memcpy( output.data() + offset, input, leng * sizeof( std::complex<float>));
+            return bytes % sizeof( std::complex<float>) == 0;
+        }
+        case SampleEncoding::SC16: {
+            for( ; input + 4 <= end; input += 4) {
+                int16_t iq[ 2];
+                std::memcpy( iq, input, 4);
+                output.emplace_back( iq[ 0] / full_scale, iq[ 1] / full_scale);
+            }
+            return input == end;
+        }
+        case SampleEncoding::SC8Bfp:
+            while( input + bfp_header <= end) {
+                const int shift = *input++;
+                uint16_t block;
+                std::memcpy( &block, input, 2);
+                input += 2;
+                if( shift > 8 || input + 2 * block > end) return false;
+                const int8_t *vals = reinterpret_cast<const int8_t*>( input);
+                for( uint64_t w = 0; w < block; ++w)
+                    output.emplace_back( static_cast<float>( vals[ 2 * w] * ( 1 << shift)) / full_scale,
+                                         static_cast<float>( vals[ 2 * w + 1] * ( 1 << shift)) / full_scale);
+                input += 2 * block;
+            }
+            return input == end;
+        case SampleEncoding::Lossless: {
+            std::vector<int16_t> vals;
+            while( input + 4 <= end) {
+                uint32_t nsamples;
+                std::memcpy( &nsamples, input, 4);
+                input += 4;
+                const uint64_t count = 2 * static_cast<uint64_t>( nsamples);
+                // jede Gruppe braucht mindestens ihr Byte width: Angaben, die der Rest der
+                // Daten nicht tragen kann, gar nicht erst anlegen
+                if( nsamples > lossless_unit || ( count + group - 1) / group > static_cast<uint64_t>( end - input))
+                    return false;
+                int16_t prev[ 2] = { 0, 0};
+                vals.resize( count);
+                for( uint64_t grp = 0; grp < count; grp += group) {
+                    if( input >= end) return false;
+                    const int width = *input++;
+                    if( width > 16 || input + group * width / 8 > end) return false;
+                    uint64_t acc = 0;
+                    int fill = 0;
+                    for( uint64_t w = 0; w < group; ++w) {
+                        while( fill < width) {
+                            acc |= static_cast<uint64_t>( *input++) << fill;
+                            fill += 8;
+                        }
+                        const uint16_t zz = static_cast<uint16_t>( acc & ( ( 1u << width) - 1));
+                        acc >>= width;
+                        fill -= width;
+                        if( grp + w >= count) continue;
+                        const int16_t delta = static_cast<int16_t>( ( zz >> 1) ^ static_cast<uint16_t>( -( zz & 1)));
+                        int16_t &last = prev[ ( grp + w) & 1];
+                        last = static_cast<int16_t>( static_cast<uint16_t>( last) + static_cast<uint16_t>( delta));
+                        vals[ grp + w] = last;
+                    }
+                }
+                for( uint64_t w = 0; w < count; w += 2)
+                    output.emplace_back( vals[ w] / full_scale, vals[ w + 1] / full_scale);
+            }
+            return input == end;
+        }
+        }
+        return false;
+    }
+
+    /// @brief cf32-Bytes der bisher kodierten Werte je geschriebenem Byte (CF32: 1, SC16: 2)
+    double ratio() const {
+        const uint64_t bytes = _bytes;
+        return bytes ? 8. * static_cast<double>( _samples) / static_cast<double>( bytes) : 1.;
+    }
+    uint64_t samples() const { return _samples;}
+    uint64_t bytes() const { return _bytes;}
+    void resetStatistics() {
+        _samples = 0;
+        _bytes = 0;
+    }
+};
+
+}
+
+#endif // SAMPLEENCODER_HPP
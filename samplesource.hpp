@@ -0,0 +1,48 @@
+#ifndef SAMPLESOURCE_HPP
+#define SAMPLESOURCE_HPP
+
+#include <string>
+#include <vector>
+#include <complex>
+#include <functional>
+#include <cstdint>
+
+#include "sampleblock.hpp"
+
+
+/// @brief Schnittstelle einer IQ-Quelle mit dem Funktionsumfang der MOUSE. Umgesetzt
+///        von Mouse (USB) und MouseEmulator (Datei/Synthese), damit Streaming- und
+///        DSP-Kette ohne angeschlossenen Empfaenger laufen.
+class SampleSource {
+public:
+    using StreamCallback = std::function<void( const SampleBlockPtr<std::complex<int16_t>> &)>;
+
+    virtual ~SampleSource() = default;
+
+    /// @return 0: alles normal, sonst siehe getError()
+    virtual int open() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+    virtual std::string getError() const = 0;
+
+    /// @brief Filtertabelle, je Eintrag { Abtastrate [Sps], halbe Filterbreite / 2 [Hz]}
+    virtual std::vector<std::vector<uint32_t>> getFilter() = 0;
+    /// @return Abtastrate der Filtereinstellung
+    virtual int setFilter( uint32_t index) = 0;
+    virtual void setCenterFrequency( int32_t frequency) = 0;
+
+    /// @brief schaltet die Quelle in den Streaming-Betrieb (MOUSE: GPIF-Modus)
+    virtual void setStreamingMode() {}
+
+    /// @brief liefert fortlaufend Bloecke [INT16, interleaved, also complex] an callback,
+    ///        callback laeuft im Thread der Quelle und darf nicht blockieren
+    /// @return 0: alles normal, sonst siehe getError()
+    virtual int startAsyncStreaming( const StreamCallback &callback,
+                                     uint32_t transfer_count = 8,
+                                     uint32_t transfer_samples = 16 * 1024) = 0;
+    virtual void stopAsyncStreaming() = 0;
+    virtual bool isAsyncStreaming() const = 0;
+    virtual uint64_t getTransferErrors() const = 0;
+};
+
+#endif // SAMPLESOURCE_HPP
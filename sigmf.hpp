@@ -0,0 +1,417 @@
+#ifndef SIGMF_HPP
+#define SIGMF_HPP
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <cstdlib>
+#include <cctype>
+
+
+/// @brief Metadaten im SigMF-Format (Signal Metadata Format, v1.0.0): eine JSON-Datei
+///        "<name>.sigmf-meta" neben den Abtastwerten mit Datentyp, Abtastrate, Captures
+///        (Mittenfrequenz, Startzeit, Sprungstellen im Strom) und Annotationen (Signale
+///        in Zeit und Frequenz). Heisst die Datendatei nicht "<name>.sigmf-data", verweist
+///        core:dataset auf sie (non-conforming dataset).
+namespace SigMF {
+
+/// @brief ein Abschnitt ohne Luecke, beginnt an sample_start (Abtastwert in der Datei)
+struct Capture {
+    uint64_t sample_start = 0;
+    std::optional<uint64_t> global_index;           // Stromposition der Quelle
+    double frequency = 0;                           // [Hz]
+    std::chrono::system_clock::time_point datetime;
+};
+
+/// @brief Signal in der Aufnahme, Grenzen absolut in Hz
+struct Annotation {
+    uint64_t sample_start = 0;
+    uint64_t sample_count = 0;
+    double freq_lower_edge = 0;                     // [Hz]
+    double freq_upper_edge = 0;                     // [Hz]
+    std::string label;
+    std::string comment;
+};
+
+/// @brief UTC nach ISO 8601 mit Millisekunden, wie von SigMF verlangt
+inline std::string
+isoTime( std::chrono::system_clock::time_point time) {
+    const std::time_t secs = std::chrono::system_clock::to_time_t( time);
+    const int64_t millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               time.time_since_epoch()).count() % 1000;
+    std::tm tm_utc{};
+    gmtime_r( &secs, &tm_utc);
+    std::ostringstream out;
+    out << std::put_time( &tm_utc, "%Y-%m-%dT%H:%M:%S")
+        << "." << std::setw( 3) << std::setfill( '0') << millis << "Z";
+    return out.str();
+}
+
+inline std::string
+escape( const std::string &str) {
+    std::string out;
+    out.reserve( str.size());
+    for( char chr : str) {
+        switch( chr) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if( static_cast<unsigned char>( chr) < 0x20) {
+                char hex[ 8];
+                std::snprintf( hex, sizeof( hex), "\\u%04x", chr);
+                out += hex;
+            }
+            else
+                out += chr;
+        }
+    }
+    return out;
+}
+
+/// @brief Gegenstueck zu isoTime(), Sekundenbruchteile optional
+/// @return false: kein Zeitpunkt in diesem Format
+inline bool
+parseIsoTime( const std::string &text, std::chrono::system_clock::time_point &time) {
+    std::tm tm_utc{};
+    std::istringstream in( text);
+    in >> std::get_time( &tm_utc, "%Y-%m-%dT%H:%M:%S");
+    if( in.fail()) return false;
+    double frac = 0.;
+    if( in.peek() == '.') {
+        std::string digits;
+        for( in.get(); std::isdigit( in.peek()); ) digits += static_cast<char>( in.get());
+        frac = std::strtod( ( "0." + digits).c_str(), nullptr);
+    }
+    time = std::chrono::system_clock::from_time_t( timegm( &tm_utc))
+           + std::chrono::duration_cast<std::chrono::system_clock::duration>( std::chrono::duration<double>( frac));
+    return true;
+}
+
+namespace detail {
+
+/// @brief JSON-Wert, gerade genug fuer die eigenen .sigmf-meta Dateien; Zahlen bleiben als
+///        Text erhalten (global_index braucht alle 64 bit)
+struct Json {
+    enum class Type { Null, Bool, Number, String, Array, Object};
+    Type type = Type::Null;
+    std::string text;                                   // String, Number, Bool
+    std::vector<Json> items;                            // Array
+    std::vector<std::pair<std::string, Json>> members;  // Object
+
+    const Json* find( const std::string &key) const {
+        for( const auto &[ name, value] : members)
+            if( name == key) return &value;
+        return nullptr;
+    }
+    double number( const std::string &key, double def = 0.) const {
+        const Json *value = find( key);
+        return value && value->type == Type::Number ? std::strtod( value->text.c_str(), nullptr) : def;
+    }
+    std::optional<uint64_t> integer( const std::string &key) const {
+        const Json *value = find( key);
+        if( ! value || value->type != Type::Number) return std::nullopt;
+        return std::strtoull( value->text.c_str(), nullptr, 10);
+    }
+    std::string string( const std::string &key) const {
+        const Json *value = find( key);
+        return value && value->type == Type::String ? value->text : std::string();
+    }
+};
+
+/// @brief rekursiver Abstieg ueber den ganzen Text, wirft std::runtime_error
+class JsonParser {
+    const std::string &_text;
+    uint64_t _pos = 0;
+
+    void skipSpace() {
+        while( _pos < _text.size() && std::isspace( static_cast<unsigned char>( _text[ _pos]))) ++_pos;
+    }
+    char next() {
+        skipSpace();
+        if( _pos >= _text.size()) throw std::runtime_error( "JSON unvollstaendig");
+        return _text[ _pos];
+    }
+    void expect( char chr) {
+        if( next() != chr) throw std::runtime_error( std::string( "JSON: '") + chr + "' erwartet");
+        ++_pos;
+    }
+    std::string parseString() {
+        expect( '"');
+        std::string out;
+        while( _pos < _text.size() && _text[ _pos] != '"') {
+            char chr = _text[ _pos++];
+            if( chr == '\\' && _pos < _text.size()) {
+                chr = _text[ _pos++];
+                switch( chr) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if( _pos + 4 > _text.size()) throw std::runtime_error( "JSON: \\u unvollstaendig");
+                    const unsigned code = std::stoul( _text.substr( _pos, 4), nullptr, 16);
+                    _pos += 4;
+                    // escape() erzeugt nur Steuerzeichen, der Rest als UTF-8
+                    if( code < 0x80) out += static_cast<char>( code);
+                    else if( code < 0x800) {
+                        out += static_cast<char>( 0xc0 | ( code >> 6));
+                        out += static_cast<char>( 0x80 | ( code & 0x3f));
+                    }
+                    else {
+                        out += static_cast<char>( 0xe0 | ( code >> 12));
+                        out += static_cast<char>( 0x80 | ( ( code >> 6) & 0x3f));
+                        out += static_cast<char>( 0x80 | ( code & 0x3f));
+                    }
+                    break;
+                }
+                default: out += chr; break;     // " \\ /
+                }
+            }
+            else
+                out += chr;
+        }
+        expect( '"');
+        return out;
+    }
+
+public:
+    explicit JsonParser( const std::string &text) : _text( text) {}
+
+    Json parse() {
+        Json value;
+        const char chr = next();
+        if( chr == '{') {
+            value.type = Json::Type::Object;
+            ++_pos;
+            if( next() == '}') { ++_pos; return value;}
+            for( ;;) {
+                std::string key = parseString();
+                expect( ':');
+                value.members.emplace_back( std::move( key), parse());
+                if( next() == ',') { ++_pos; continue;}
+                expect( '}');
+                return value;
+            }
+        }
+        if( chr == '[') {
+            value.type = Json::Type::Array;
+            ++_pos;
+            if( next() == ']') { ++_pos; return value;}
+            for( ;;) {
+                value.items.push_back( parse());
+                if( next() == ',') { ++_pos; continue;}
+                expect( ']');
+                return value;
+            }
+        }
+        if( chr == '"') {
+            value.type = Json::Type::String;
+            value.text = parseString();
+            return value;
+        }
+        const uint64_t beg = _pos;
+        while( _pos < _text.size() && ( std::isalnum( static_cast<unsigned char>( _text[ _pos]))
+                                        || _text[ _pos] == '-' || _text[ _pos] == '+' || _text[ _pos] == '.'))
+            ++_pos;
+        value.text = _text.substr( beg, _pos - beg);
+        if( value.text == "true" || value.text == "false") value.type = Json::Type::Bool;
+        else if( value.text == "null") value.type = Json::Type::Null;
+        else if( ! value.text.empty()) value.type = Json::Type::Number;
+        else throw std::runtime_error( std::string( "JSON: unerwartetes '") + chr + "'");
+        return value;
+    }
+
+    /// @brief ganzer Text, danach nur noch Leerraum
+    Json parseDocument() {
+        Json value = parse();
+        skipSpace();
+        if( _pos != _text.size()) throw std::runtime_error( "JSON: Text hinter dem Dokument");
+        return value;
+    }
+};
+
+}
+
+/// @brief Dateiname ohne Verzeichnis
+inline std::string
+fileName( const std::string &path) {
+    const size_t slash = path.rfind( '/');
+    return slash == std::string::npos ? path : path.substr( slash + 1);
+}
+
+/// @brief true: Datendatei nach SigMF benannt ("<name>.sigmf-data")
+inline bool
+isDataPath( const std::string &data_path) {
+    const std::string data_ext = ".sigmf-data";
+    return data_path.size() >= data_ext.size()
+           && data_path.compare( data_path.size() - data_ext.size(), data_ext.size(), data_ext) == 0;
+}
+
+/// @brief "<name>.sigmf-data" -> "<name>.sigmf-meta", sonst wird die Endung ersetzt
+///        ("aufnahme.sc16" -> "aufnahme.sigmf-meta")
+inline std::string
+metaPath( const std::string &data_path) {
+    if( isDataPath( data_path))
+        return data_path.substr( 0, data_path.size() - 11) + ".sigmf-meta";
+    const size_t dot = data_path.rfind( '.');
+    const size_t slash = data_path.rfind( '/');
+    if( dot == std::string::npos || ( slash != std::string::npos && dot < slash))
+        return data_path + ".sigmf-meta";
+    return data_path.substr( 0, dot) + ".sigmf-meta";
+}
+
+
+/// @brief Inhalt einer .sigmf-meta Datei
+class Meta {
+public:
+    std::string datatype = "cf32_le";               // z.B. ci16_le, ci8
+    double sample_rate = 0;                         // [Sps]
+    std::string description;
+    std::string hw = "MOUSE";
+    std::string dataset;                            // leer: "<name>.sigmf-data"
+    std::string encoding;                           // mouse:encoding, leer: unkodiert
+    std::string decoded_datatype;                   // mouse:decoded_datatype, nur kodiert
+    std::vector<Capture> captures;
+    std::vector<Annotation> annotations;
+
+    /// @brief JSON nach SigMF v1.0.0, Captures und Annotationen nach sample_start sortiert
+    std::string toJson() const {
+        std::vector<Capture> caps = captures;
+        std::vector<Annotation> annos = annotations;
+        std::stable_sort( caps.begin(), caps.end(), []( const Capture &a, const Capture &b)
+                          { return a.sample_start < b.sample_start;});
+        std::stable_sort( annos.begin(), annos.end(), []( const Annotation &a, const Annotation &b)
+                          { return a.sample_start < b.sample_start;});
+
+        std::ostringstream out;
+        out << std::setprecision( 15);
+        out << "{\n  \"global\": {\n"
+            << "    \"core:datatype\": \"" << escape( datatype) << "\",\n"
+            << "    \"core:sample_rate\": " << sample_rate << ",\n"
+            << "    \"core:version\": \"1.0.0\",\n"
+            << "    \"core:recorder\": \"mouse\",\n"
+            << "    \"core:hw\": \"" << escape( hw) << "\"";
+        if( ! description.empty())
+            out << ",\n    \"core:description\": \"" << escape( description) << "\"";
+        if( ! dataset.empty())
+            out << ",\n    \"core:dataset\": \"" << escape( dataset) << "\"";
+        // kodierte Daten (SampleEncoding): core:datatype ist kein core-Datentyp, die
+        // dekodierten Werte beschreibt mouse:decoded_datatype; ohne die Erweiterung ist die
+        // Datei nicht lesbar
+        if( ! encoding.empty()) {
+            out << ",\n    \"core:extensions\": [ { \"name\": \"mouse\", \"version\": \"1.0.0\", \"optional\": false} ]"
+                << ",\n    \"mouse:encoding\": \"" << escape( encoding) << "\"";
+            if( ! decoded_datatype.empty())
+                out << ",\n    \"mouse:decoded_datatype\": \"" << escape( decoded_datatype) << "\"";
+        }
+        out << "\n  },\n  \"captures\": [";
+        for( uint64_t w = 0; w < caps.size(); ++w) {
+            const Capture &cap = caps[ w];
+            out << ( w ? ",\n" : "\n") << "    {\n"
+                << "      \"core:sample_start\": " << cap.sample_start << ",\n";
+            if( cap.global_index)
+                out << "      \"core:global_index\": " << *cap.global_index << ",\n";
+            out << "      \"core:frequency\": " << cap.frequency << ",\n"
+                << "      \"core:datetime\": \"" << isoTime( cap.datetime) << "\"\n    }";
+        }
+        out << ( caps.empty() ? "],\n" : "\n  ],\n") << "  \"annotations\": [";
+        for( uint64_t w = 0; w < annos.size(); ++w) {
+            const Annotation &anno = annos[ w];
+            out << ( w ? ",\n" : "\n") << "    {\n"
+                << "      \"core:sample_start\": " << anno.sample_start << ",\n"
+                << "      \"core:sample_count\": " << anno.sample_count << ",\n"
+                << "      \"core:freq_lower_edge\": " << anno.freq_lower_edge << ",\n"
+                << "      \"core:freq_upper_edge\": " << anno.freq_upper_edge;
+            if( ! anno.label.empty())
+                out << ",\n      \"core:label\": \"" << escape( anno.label) << "\"";
+            if( ! anno.comment.empty())
+                out << ",\n      \"core:comment\": \"" << escape( anno.comment) << "\"";
+            out << "\n    }";
+        }
+        out << ( annos.empty() ? "]\n}\n" : "\n  ]\n}\n");
+        return out.str();
+    }
+
+    /// @brief schreibt ueber eine temporaere Datei und rename(), ein Leser sieht nie eine
+    ///        halbe Datei
+    /// @return 0: alles normal, -1: Datei nicht schreibbar
+    int write( const std::string &meta_path) const {
+        const std::string tmp = meta_path + ".tmp";
+        {
+            std::ofstream out( tmp);
+            if( ! out) return -1;
+            out << toJson();
+            if( ! out) return -1;
+        }
+        return std::rename( tmp.c_str(), meta_path.c_str()) ? -1 : 0;
+    }
+
+    /// @brief liest eine .sigmf-meta Datei (z.B. zum Anfuegen an einen Mitschnitt), Felder
+    ///        ausserhalb dieser Klasse gehen dabei verloren
+    /// @return 0: alles normal, -1: nicht lesbar oder kein SigMF (siehe error)
+    int read( const std::string &meta_path, std::string *error = nullptr) {
+        std::ifstream in( meta_path);
+        if( ! in) {
+            if( error) *error = "kann " + meta_path + " nicht oeffnen";
+            return -1;
+        }
+        std::ostringstream text;
+        text << in.rdbuf();
+        try {
+            const std::string json = text.str();
+            const detail::Json doc = detail::JsonParser( json).parseDocument();
+            const detail::Json *global = doc.find( "global");
+            if( ! global || global->type != detail::Json::Type::Object)
+                throw std::runtime_error( "kein \"global\" Objekt");
+            Meta meta;
+            meta.datatype = global->string( "core:datatype");
+            meta.sample_rate = global->number( "core:sample_rate");
+            meta.description = global->string( "core:description");
+            meta.hw = global->string( "core:hw");
+            meta.dataset = global->string( "core:dataset");
+            meta.encoding = global->string( "mouse:encoding");
+            meta.decoded_datatype = global->string( "mouse:decoded_datatype");
+            if( const detail::Json *caps = doc.find( "captures"))
+                for( const detail::Json &item : caps->items) {
+                    Capture cap;
+                    cap.sample_start = item.integer( "core:sample_start").value_or( 0);
+                    cap.global_index = item.integer( "core:global_index");
+                    cap.frequency = item.number( "core:frequency");
+                    parseIsoTime( item.string( "core:datetime"), cap.datetime);
+                    meta.captures.push_back( cap);
+                }
+            if( const detail::Json *annos = doc.find( "annotations"))
+                for( const detail::Json &item : annos->items) {
+                    Annotation anno;
+                    anno.sample_start = item.integer( "core:sample_start").value_or( 0);
+                    anno.sample_count = item.integer( "core:sample_count").value_or( 0);
+                    anno.freq_lower_edge = item.number( "core:freq_lower_edge");
+                    anno.freq_upper_edge = item.number( "core:freq_upper_edge");
+                    anno.label = item.string( "core:label");
+                    anno.comment = item.string( "core:comment");
+                    meta.annotations.push_back( std::move( anno));
+                }
+            *this = std::move( meta);
+        }
+        catch( const std::exception &e) {
+            if( error) *error = meta_path + ": " + e.what();
+            return -1;
+        }
+        return 0;
+    }
+};
+
+}
+
+#endif // SIGMF_HPP
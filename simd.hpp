@@ -0,0 +1,64 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <atomic>
+#include <algorithm>
+
+
+/// @brief Laufzeiterkennung des Befehlssatzes. Die Kernel werden mit
+///        __attribute__((target(...))) fuer jede Stufe uebersetzt, ausgewaehlt wird
+///        erst zur Laufzeit - das Binary laeuft damit auf jeder x86_64 CPU.
+namespace Simd {
+
+enum class Level : int {
+    Scalar = 0,
+    SSE2   = 1,
+    AVX2   = 2,    // inkl. FMA
+    AVX512 = 3     // AVX-512F
+};
+
+/// @brief hoechste von der CPU unterstuetzte Stufe
+inline Level
+detect() {
+    static const Level detected = [] {
+#if defined( __x86_64__) || defined( __i386__)
+        __builtin_cpu_init();
+        if( __builtin_cpu_supports( "avx512f"))
+            return Level::AVX512;
+        if( __builtin_cpu_supports( "avx2") && __builtin_cpu_supports( "fma"))
+            return Level::AVX2;
+        if( __builtin_cpu_supports( "sse2"))
+            return Level::SSE2;
+#endif
+        return Level::Scalar;
+    }();
+    return detected;
+}
+
+/// @brief Obergrenze fuer die Auswahl (z.B. zum Vergleichen der Kernel)
+inline std::atomic<Level>&
+limit() {
+    static std::atomic<Level> max_level{ Level::AVX512};
+    return max_level;
+}
+
+/// @brief die tatsaechlich verwendete Stufe
+inline Level
+level() {
+    return static_cast<Level>( std::min( static_cast<int>( detect()),
+                                         static_cast<int>( limit().load())));
+}
+
+inline const char*
+name( Level lvl) {
+    switch( lvl) {
+    case Level::SSE2:   return "SSE2";
+    case Level::AVX2:   return "AVX2";
+    case Level::AVX512: return "AVX-512";
+    default:            return "scalar";
+    }
+}
+
+}
+
+#endif // SIMD_HPP
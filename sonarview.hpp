@@ -12,6 +12,7 @@
 #include <QSplitter>
 #include <QVBoxLayout>
 #include <QMouseEvent>
+#include <QTimer>
 
 #include <QStaticText>
 
@@ -19,13 +20,19 @@
 
 #include <fstream>
 #include <iostream>
+#include <array>
 #include <complex>
 #include <vector>
 #include <thread>
 #include <execution>
 
-#include "conditionalsafequeue.hpp"
-#include "fft.hpp"
+#include "sampleblock.hpp"
+#include "spscring.hpp"
+#include "ports.hpp"
+#include "stft.hpp"
+#include "psd.hpp"
+#include "reduce.hpp"
+#include "decibel.hpp"
 #include "tools.hpp"
 
 
@@ -101,10 +108,9 @@ class Marker : public QWidget{
 protected:
     void
     mousePressEvent(QMouseEvent *event) override {
-        if(event->button() & Qt::LeftButton) {
-            _x_a = event->pos().x();
-            std::cerr << "_x_a: " << _x_a << std::endl;
-        }
+        // Pixel -> Position relativ zur Breite, wie setPosA()
+        if(event->button() & Qt::LeftButton)
+            setPosA( static_cast<double>( event->pos().x()) / std::max( 1, width()));
         //    if(event->button() & Qt::LeftButton)
         //    {
         //        m_selection_stop = event->pos().x();
@@ -116,24 +122,34 @@ protected:
     }
 
 public:
-    Marker() : _x_a( 0), _x_b( 0) {}
+    Marker() : _x_a( -1.), _x_b( -1.) {}
 
-    void setPosA( int32_t x){ _x_a = x;}
-    void setPosB( int32_t x){ _x_b = x;}
+    /// @brief Position relativ zur Bildbreite ( 0 .. 1), < 0: nicht gesetzt
+    void setPosA( double x){ _x_a = std::clamp( x, 0., 1.);}
+    void setPosB( double x){ _x_b = std::clamp( x, 0., 1.);}
+    double posA() const { return _x_a;}
+    double posB() const { return _x_b;}
+    bool isSet() const { return _x_a >= 0. && _x_b >= 0.;}
+    void clear() { _x_a = _x_b = -1.;}
 
     void draw( QImage *image) {
         QPainter qpaint(image);
         qpaint.setPen( QPen( Qt::green));
 
-        qpaint.drawLine( _x_a, image->height(), _x_a, 0);
-        qpaint.drawText( _x_a + 5, static_cast<int>( image->height() * 0.9), "a");
-
-        qpaint.drawLine( _x_b, image->height(), _x_b, 0);
-        qpaint.drawText( _x_b + 5, static_cast<int>( image->height() * 0.9), "b");
+        if( _x_a >= 0.) {
+            const int x = static_cast<int>( _x_a * image->width());
+            qpaint.drawLine( x, image->height(), x, 0);
+            qpaint.drawText( x + 5, static_cast<int>( image->height() * 0.9), "a");
+        }
+        if( _x_b >= 0.) {
+            const int x = static_cast<int>( _x_b * image->width());
+            qpaint.drawLine( x, image->height(), x, 0);
+            qpaint.drawText( x + 5, static_cast<int>( image->height() * 0.9), "b");
+        }
     }
 
 private:
-    uint64_t _x_a, _x_b;
+    double _x_a, _x_b;
 
 };
 
@@ -142,7 +158,7 @@ class Axis : public QObject {
     Q_OBJECT
 
 public:
-    Axis() {}
+    Axis() : _center_freq( 0), _bandwidth( 0), _rel_center( 0.), _rel_span( 1.) {}
 
     /// @brief raws Axis on an Image
     void draw( QImage *image, float rel_y_pos = 0.9, float rel_size = 0.05) {
@@ -150,45 +166,178 @@ public:
         QPainter qpaint( image);
         qpaint.setPen( QPen( Qt::black));
 
+        // dargestelltes Band, beim Zoom ein Ausschnitt
+        const double center = _center_freq + _rel_center * _bandwidth;
+        const double bandwidth = _rel_span * _bandwidth;
         int y = static_cast<int>( image->height() * rel_y_pos);
         qpaint.drawStaticText( .0, y, QStaticText( QString( "[MHz]")));
         qpaint.drawStaticText( static_cast<int>( image->width() * 0.1),
-                              y, QStaticText( QString::number( (_center_freq - _bandwidth / 2) / 1e6, 'f', 3)));
+                              y, QStaticText( QString::number( (center - bandwidth / 2) / 1e6, 'f', 3)));
         qpaint.drawStaticText( static_cast<int>( image->width() * 0.5),
-                              y, QStaticText( QString::number( _center_freq / 1e6, 'f', 3)));
+                              y, QStaticText( QString::number( center / 1e6, 'f', 3)));
         qpaint.drawStaticText( static_cast<int>( image->width() * 0.9),
-                              y, QStaticText( QString::number( (_center_freq + _bandwidth / 2) / 1e6, 'f', 3)));
+                              y, QStaticText( QString::number( (center + bandwidth / 2) / 1e6, 'f', 3)));
 
     }
 
 public slots:
     void chaneCenterFreq( int32_t freq) { _center_freq = freq;}
     void setBandwidth( int32_t bandwidth) { _bandwidth = bandwidth;}
+    /// @brief Ausschnitt relativ zur Bandbreite ( 0, 1: volles Band)
+    void setZoom( double rel_center, double rel_span) {
+        _rel_center = rel_center;
+        _rel_span = rel_span;
+    }
 private:
     int32_t _center_freq, _bandwidth;
+    double _rel_center, _rel_span;
 };
 
 
 
-class Waterfall : public QWidget {
+/// @brief Wasserfall-Renderer: jede Zeile wird ueber scanLine() mit einer vorberechneten
+///        Farbtabelle (256 Eintraege) geschrieben. Der Zeilenindex laeuft zyklisch durch das
+///        Bild, es wird nie Bildspeicher umkopiert; die Anzeige besteht aus zwei Blits.
+class Waterfall {
+public:
+    enum class Palette { Gray, GrayInverted, Jet, Viridis, Inferno};
+
+private:
+    QImage _image;
+    uint64_t _head;         // Zeile der neuesten Reihe
+    uint64_t _filled;       // bisher geschriebene Reihen, hoechstens rows()
+    std::array<QRgb, 256> _lut;
+    Palette _palette;
+    float _min_db, _lut_scale;
+
+    /// @brief lineare Interpolation zwischen gleichabstaendigen Stuetzstellen
+    void setupLut( const std::vector<QRgb> &points) {
+        const double last = static_cast<double>( points.size() - 1);
+        for( int i = 0; i < 256; ++i) {
+            const double pos = last * i / 255.;
+            const uint64_t x = std::min( static_cast<uint64_t>( pos), points.size() - 2);
+            const double f = pos - x;
+            const QRgb a = points[ x], b = points[ x + 1];
+            _lut[ i] = qRgb( static_cast<int>( qRed( a) + f * ( qRed( b) - qRed( a))),
+                             static_cast<int>( qGreen( a) + f * ( qGreen( b) - qGreen( a))),
+                             static_cast<int>( qBlue( a) + f * ( qBlue( b) - qBlue( a))));
+        }
+    }
+
+public:
+    Waterfall( uint64_t width = 1024, uint64_t rows = 480, Palette palette = Palette::GrayInverted)
+        : _head( 0), _filled( 0), _min_db( -120.f), _lut_scale( 255.f / 120.f) {
+        setPalette( palette);
+        setSize( width, rows);
+    }
+
+    /// @brief neue Bildgroesse, verwirft den Inhalt
+    void setSize( uint64_t width, uint64_t rows) {
+        _image = QImage( static_cast<int>( width), static_cast<int>( std::max<uint64_t>( rows, 1)),
+                         QImage::Format_RGB32);
+        clear();
+    }
+    void clear() {
+        _image.fill( _lut[ 0]);
+        _head = 0;
+        _filled = 0;
+    }
+
+    void setPalette( Palette palette) {
+        _palette = palette;
+        switch( palette) {
+        case Palette::Gray:
+            setupLut( { qRgb( 0, 0, 0), qRgb( 255, 255, 255)});
+            break;
+        case Palette::GrayInverted:
+            setupLut( { qRgb( 255, 255, 255), qRgb( 0, 0, 0)});
+            break;
+        case Palette::Jet:
+            setupLut( { qRgb( 0, 0, 128), qRgb( 0, 0, 255), qRgb( 0, 255, 255),
+                        qRgb( 255, 255, 0), qRgb( 255, 0, 0), qRgb( 128, 0, 0)});
+            break;
+        case Palette::Viridis:
+            setupLut( { 0x440154, 0x482878, 0x3E4A89, 0x31688E, 0x26828E,
+                        0x1F9E89, 0x35B779, 0x6DCD59, 0xB4DE2C, 0xFDE725});
+            break;
+        case Palette::Inferno:
+            setupLut( { 0x000004, 0x1B0C41, 0x4A0C6B, 0x781C6D, 0xA52C60,
+                        0xCF4446, 0xED6925, 0xFB9B06, 0xF7D13D, 0xFCFFA4});
+            break;
+        }
+        // Tabelle liefert RGB, QImage::Format_RGB32 erwartet 0xffRRGGBB
+        for( QRgb &color : _lut) color |= 0xff000000u;
+    }
+    Palette palette() const { return _palette;}
+
+    /// @brief Wertebereich [dB], der auf die Farbtabelle abgebildet wird
+    void setRange( float min_db, float max_db) {
+        if( max_db <= min_db) throw std::invalid_argument( "FEHLER Waterfall::setRange(): max_db <= min_db");
+        _min_db = min_db;
+        _lut_scale = 255.f / ( max_db - min_db);
+    }
 
+    uint64_t width() const { return _image.width();}
+    uint64_t rows() const { return _image.height();}
+
+    /// @brief schreibt eine neue Reihe, leng != width() passt die Bildbreite an
+    void addLine( const float *input, uint64_t leng) {
+        if( leng != width()) setSize( leng, rows());
+        _head = ( _head + rows() - 1) % rows();
+        _filled = std::min( _filled + 1, rows());
+
+        QRgb *line = reinterpret_cast<QRgb*>( _image.scanLine( static_cast<int>( _head)));
+        const float min_db = _min_db, scale = _lut_scale;
+        for( uint64_t w = 0; w < leng; ++w) {
+            const float x = std::clamp( ( input[ w] - min_db) * scale, 0.f, 255.f);
+            line[ w] = _lut[ static_cast<uint8_t>( x)];
+        }
+    }
+
+    /// @brief zeichnet alle Reihen, neueste oben (newest_on_top) oder unten, in target.
+    ///        Ab _head liegen die Reihen von neu nach alt, der Rest folgt ab Zeile 0.
+    void draw( QPainter &painter, const QRectF &target, bool newest_on_top = true) const {
+        const double rows_d = static_cast<double>( rows());
+        const double first = rows_d - _head;
+        const double height_first = target.height() * first / rows_d;
+
+        painter.save();
+        if( ! newest_on_top) {
+            painter.translate( 0, target.top() + target.bottom());
+            painter.scale( 1, -1);
+        }
+        painter.drawImage( QRectF( target.left(), target.top(), target.width(), height_first),
+                           _image, QRectF( 0, _head, width(), first));
+        if( _head)
+            painter.drawImage( QRectF( target.left(), target.top() + height_first,
+                                       target.width(), target.height() - height_first),
+                               _image, QRectF( 0, 0, width(), _head));
+        painter.restore();
+    }
 };
 
 
 
-/// @brief Ordinary Constructor for showview
-class Sonarview : public QWidget{
+/// @brief Ordinary Constructor for showview, consumes the frames of a shared StftProcessor
+///        Der Verarbeitungsthread nimmt jeden Frame in die Mittelung auf (volle Rate) und
+///        schreibt mit der Zeilenrate Reihen in den Wasserfall; ein Timer im GUI-Thread
+///        holt mit der Bildrate den neuesten Stand ab.
+class Sonarview : public QWidget, public InputPort<StftFrame> {
     Q_OBJECT
+    using clock = std::chrono::steady_clock;
 
 public:
-    explicit Sonarview( uint64_t fft_exp = 10) : _spectrogramm(nullptr),
-        _psd(nullptr), _current_line(0), _is_processing(false), _fft(nullptr),
+    explicit Sonarview() :
+        _fft_leng( 0), _visible_rows( 480), _is_processing(false), _dirty( false),
+        _row( 1024, PsdAverage::Mode::PeakHold),
+        _row_period( std::chrono::milliseconds( 40)),
+        _frames( 0), _dropped( 0), _display_width( 1024), _reduction( Reduce::Mode::Max),
+        _pending_avg( 5), _pending_avg_mode( PsdAverage::Mode::Exponential), _avg_changed( false),
+        _band_center( 0.), _band_span( 1.),
         _draw_upsidedown(true), _avg(nullptr) {
 
-        setFFTExp( fft_exp);
-        _buf_fft.resize( _fft->leng());
-        _buf_fft_abs.resize( _fft->leng());
-        _avg = new Tools::MovingAverage<float>( 5);
+        _avg = new PsdAverage( 1024, PsdAverage::Mode::Exponential, 5);
+        setFFTLeng( 1024);
 
         _qs_splitter = new QSplitter( this);
         _qs_splitter->setOrientation( Qt::Vertical);
@@ -209,59 +358,92 @@ public:
         setLayout( qvbl_main);
         setSizePolicy( QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
 
-        {
-            QMutexLocker locker( &imageMutex);
-            if( _spectrogramm && _psd) {
-                _ql_spec->setPixmap( QPixmap::fromImage( _spectrogramm->copy(
-                    0, getLine(), _spectrogramm->width(), _spectrogramm->height() / 2)));
-                _ql_psd->setPixmap( QPixmap::fromImage( *_psd));
-            }
-        }
+        // Anzeige im GUI-Thread, unabhaengig von der Rate der Frames
+        _refresh = new QTimer( this);
+        connect( _refresh, &QTimer::timeout, this, &Sonarview::refresh);
+        setRefreshRate( 25.);
+        rescaleLabels();
     }
     ~Sonarview() {
+        disconnectInput();
         stopProcessing();
         QMutexLocker locker( &imageMutex);
-        delete _fft; delete _avg;
+        delete _avg;
     }
 
 
     void startProcessing() {
         if( _is_processing) throw std::runtime_error("start a thread which is allready running");
         _is_processing = true;
+        _puff.reset();
         _proc = std::thread( &Sonarview::process, this);
     }
 
     void stopProcessing() {
         if( ! _is_processing) return;
         _is_processing = false;
+        _puff.abort();
         if( _proc.joinable())
             _proc.join();
     }
 
-    // Reset der aktuellen fft
-    void
-    setFFTExp( const uint64_t fft_exp) {
-        uint64_t leng = 1 << fft_exp;
-        if( _fft) delete _fft;
-        _fft = new FFT( leng);
-        _buf_fft.resize( leng);
-        _buf_fft_abs.resize( leng);
-        _pos_overlap = leng / 4;
-        setRows( 480);
+    /// ...push frame to buffer
+	/// ensure buffer is not overfilled, only the references to the shared blocks are queued
+    void dataIn( const StftFrame &input) override {
+        if( ! _puff.try_push( input))
+            ++_dropped;
+    }
+
+    /// @brief Setzt die Anzahl der ffts ueber die gemittelt wird; der Verarbeitungsthread
+    ///        uebernimmt die Aenderung vor dem naechsten Frame
+    void setAverage( uint64_t avg) {
+        _pending_avg = avg;
+        _avg_changed = true;
+    }
+    /// @brief Mittelwert linear / exponentiell, Max- oder Min-Hold, wie setAverage()
+    void setAverageMode( PsdAverage::Mode mode) {
+        _pending_avg_mode = mode;
+        _avg_changed = true;
+    }
+
+    /// @brief Farbtabelle und Wertebereich [dBFS] des Wasserfalls
+    void setPalette( Waterfall::Palette palette) {
+        QMutexLocker locker( &imageMutex);
+        _waterfall.setPalette( palette);
+    }
+    void setRange( float min_db, float max_db) {
+        QMutexLocker locker( &imageMutex);
+        _waterfall.setRange( min_db, max_db);
     }
 
-    /// ...push data to buffer
-	/// ensure buffer is not overfilled , and input.size() matches fft::leng
-    void dataIn( const std::vector<std::complex<float>> &input) {
-        if( _puff.size() < 1) {
-            std::vector<std::complex<float>> tmp = input;
-            tmp.resize(_fft->leng(), std::complex<float>( .0 , .0));
-            _puff.push( tmp);
+    /// @brief Bildwiederholrate der Anzeige [1/s], laeuft im GUI-Thread
+    void setRefreshRate( double fps) {
+        _refresh->start( std::max( 1, static_cast<int>( 1000. / std::max( fps, .1))));
+    }
+    /// @brief Reihen je Sekunde im Wasserfall, alle Frames dazwischen werden zusammengefasst
+    void setRowRate( double rows_per_second) {
+        _row_period = std::chrono::duration_cast<clock::duration>(
+                          std::chrono::duration<double>( 1. / std::max( rows_per_second, .1)));
+    }
+    /// @brief true: eine Reihe zeigt das Maximum (kurze Bursts bleiben sichtbar),
+    ///        false: den Mittelwert ihrer Frames. Nur bei gestopptem Thread aendern.
+    void setRowPeakHold( bool peak_hold) {
+        if( peak_hold)
+            _row.setMode( PsdAverage::Mode::PeakHold);
+        else {
+            // exponentiell mit alpha = 1 / n: bis zum reset() der exakte Mittelwert
+            _row.setMode( PsdAverage::Mode::Exponential);
+            _row.setAverage( std::numeric_limits<uint64_t>::max());
         }
     }
 
-    /// @brief Setzt die Anzahl der ffts ueber die gemittelt wird
-    void setAverage( uint64_t avg) {_avg->setLeng( avg);}
+    /// @brief Verdichtung der bins auf die Bildspalten: Max (schmale Traeger bleiben
+    ///        sichtbar), Mittelwert oder Min. Verdichtet wird die Leistung vor der dB-Wandlung.
+    void setReduction( Reduce::Mode mode) { _reduction = mode;}
+
+    /// @brief verarbeitete bzw. mangels Platz verworfene Frames
+    uint64_t getFrameCount() const { return _frames;}
+    uint64_t getDroppedFrames() const { return _dropped;}
 
     Axis _axis;
     Marker _marker;
@@ -271,23 +453,65 @@ public slots:
         this->repaint();
     }
 
+    /// @brief Zoom auf den Bereich zwischen den Markern a und b: meldet das Band relativ
+    ///        zur vollen Abtastrate ueber zoomChanged(), ein ZoomProcessor rechnet es neu
+    void setZoom() {
+        if( ! _marker.isSet()) return;
+        const double left = std::min( _marker.posA(), _marker.posB());
+        const double right = std::max( _marker.posA(), _marker.posB());
+        if( right <= left) return;
+        // Bildspalten -> Frequenz relativ zur Abtastrate, DC liegt in der Mitte
+        const double center = _band_center + ( 0.5 * ( left + right) - 0.5) * _band_span;
+        const double span = ( right - left) * _band_span;
+        _marker.clear();
+        emit zoomChanged( center, span);
+    }
+    void resetZoom() {
+        _marker.clear();
+        emit zoomChanged( 0., 1.);
+    }
+
+    /// @brief das dargestellte Band (relativ zur vollen Abtastrate), fuer Achse und Marker
+    void setBand( double center, double span) {
+        _band_center = center;
+        _band_span = span;
+        _axis.setZoom( center, span);
+        _marker.clear();
+        _dirty = true;
+    }
+
+signals:
+    /// @brief gewuenschter Zoom, span >= 1: kein Zoom
+    void zoomChanged( double center, double span);
+
 private slots:
+    /// @brief Timer: nur neu zeichnen, wenn neue Reihen vorliegen
+    void refresh() {
+        if( _dirty.exchange( false))
+            rescaleLabels();
+    }
+
     // passt die Pixmaps der tatsaechlichen Anzeige (Labels) an
     void rescaleLabels() {
-        QMutexLocker locker( &imageMutex);
+        // Bildbreite in Schritten von 128 Spalten, damit nicht jede Groessenaenderung
+        // den Wasserfall loescht
+        _display_width = std::max<uint64_t>( 128, ( static_cast<uint64_t>( _ql_spec->width()) + 127) / 128 * 128);
 
-        // Kopie des Spektrogramm auf die Fenstergroesse anpassen
-        QImage tmp = _spectrogramm->copy( 0, getLine(), _spectrogramm->width(),
-                        _spectrogramm->height() / 2).scaled(_ql_spec->size(),
-                                 Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        QMutexLocker locker( &imageMutex);
 
-        // Wasserfalldiagramm zeichnen
-        if( _draw_upsidedown) { tmp.mirror( false, true);}
+        // Wasserfall direkt in Fenstergroesse zeichnen (zwei Blits, keine Kopie)
+        QImage tmp( _ql_spec->size(), QImage::Format_RGB32);
+        {
+            QPainter qpaint( &tmp);
+            _waterfall.draw( qpaint, tmp.rect(), _draw_upsidedown);
+        }
         _marker.draw( &tmp);
         _ql_spec->setPixmap( QPixmap::fromImage( tmp));
 
-        // scales psd to label::size
-        QImage psd = _psd->scaled( _ql_psd->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        // psd direkt in Labelgroesse zeichnen
+        QImage psd( _ql_psd->size(), QImage::Format_RGB32);
+        psd.fill( Qt::white);
+        drawTrace( &psd);
 
         _marker.draw( &psd);
         _axis.draw( &psd);
@@ -297,52 +521,40 @@ private slots:
 
 protected:
 
+    /// @brief links: Marker a, rechts: Marker b, Mitte: Zoom zwischen a und b
     void mousePressEvent(QMouseEvent *event) override {
+        const double x = static_cast<double>( event->pos().x() - _qs_splitter->x())
+                       / std::max( 1, _qs_splitter->width());
         if(event->button() & Qt::LeftButton) {
-            _marker.setPosA( event->pos().x());
+            _marker.setPosA( x);
         }
-    }
-private:
-    /// @brief Fuegt dem Sonargramm eine FFT Reihe hinzu
-    /// @param input fft magnitudes in 10*log10
-    void
-    addLineToSpectrogram( const std::vector<float> &input) {
-        if( _current_line >= _visible_rows) {
-            _current_line = 0;
-            // Bild von unterer Haelfte in obere haelfte kopieren, wenn ende erreicht
-            for( int w = 0; w < _spectrogramm->width(); ++w)
-                for( uint64_t x = 0; x < _visible_rows; ++x)
-                    _spectrogramm->setPixel( w, x, _spectrogramm->pixel( w, _visible_rows + x));
-
+        else if(event->button() & Qt::RightButton) {
+            _marker.setPosB( x);
         }
-        uint64_t start_row = _visible_rows + _current_line;
-        ++_current_line;
-
-        // draw new column on spectro
-        for( uint64_t w = 0; w < input.size(); ++w) {
-            // to do: range setzen
-            double x = 255. * (input.at( w) + 30.) / 60.;
-            int i = std::clamp<int>( static_cast<int>( x) , 0, 255);
-            _spectrogramm->setPixel( w, start_row, qRgb( 255 - i, 255 - i, 255 - i));
+        else if(event->button() & Qt::MiddleButton) {
+            setZoom();
         }
+        _dirty = true;
     }
-
-    /// @brief Fuegt das PSD unter das Sonargramm hinzu
-    /// @param input 10*log10 magnitudes
+    /// @brief Doppelklick: Zoom aufheben
+    void mouseDoubleClickEvent(QMouseEvent *event) override {
+        Q_UNUSED( event);
+        resetZoom();
+    }
+private:
+    /// @brief Zeichnet das PSD (_trace, dBFS) in image
     void
-    addPSDToImage( const std::vector<float> &input) {
-        if( ! _psd) return;
-        QPainter qpaint( _psd);
+    drawTrace( QImage *image) const {
+        if( _trace.size() < 2) return;
+        QPainter qpaint( image);
         qpaint.setPen( QPen( Qt::black));
 
-        std::vector<int> tmp( input.size());
-        int height = _psd->height();
-        std::transform( std::execution::par_unseq, input.begin(), input.end(), tmp.begin(),
-                       [ height]( float val) { return static_cast<int>( height * (val-15) / -45.);});
-
-        for( uint64_t w = 0; w < tmp.size() - 1; ++w) {
-            qpaint.drawLine( w, tmp.at( w), w + 1, tmp.at( w + 1));
-        }
+        const double height = image->height();
+        const double x_step = static_cast<double>( image->width()) / static_cast<double>( _trace.size() - 1);
+        std::vector<QPointF> points( _trace.size());
+        for( uint64_t w = 0; w < _trace.size(); ++w)
+            points[ w] = QPointF( w * x_step, height * _trace[ w] / -120.);
+        qpaint.drawPolyline( points.data(), static_cast<int>( points.size()));
     }
 
     /// @brief Sets the amount of rows in the QImage
@@ -351,79 +563,93 @@ private:
         QMutexLocker locker( &imageMutex);
 
         _visible_rows = rows;
-        _current_line = rows;
 
-        _spectrogramm = std::make_unique<QImage>( _fft->leng(), 2 * _visible_rows, QImage::Format_ARGB32);
-        _spectrogramm->fill( Qt::white);
-        _psd = std::make_unique<QImage>( _fft->leng(), static_cast<uint64_t>( _visible_rows),
-                          QImage::Format_ARGB32);
+        _waterfall.setSize( std::min<uint64_t>( _fft_leng, _display_width), rows);
+        _trace.clear();
     }
 
-    /// gibt die aktuell Zeile an, auf die das PSD gezeichnet wird
-    uint64_t getLine() const {
-        if( _current_line <= _visible_rows ) {
-            if( _current_line ) {
-                return _current_line -1;
-            }
-            else {
-                return _current_line;
-            }
-        }
-        // avoid Scheiße
-        return 0;
+    /// @brief Bildbreite an eine neue FFT-Laenge anpassen. Nur im Verarbeitungsthread (bzw.
+    ///        vor startProcessing()): dessen Puffer direkt, _fft_leng, Wasserfall und Kurve
+    ///        unter imageMutex, der GUI-Thread sieht so nie einen halb umgestellten Stand
+    void
+    setFFTLeng( uint64_t leng) {
+        _buf_fft_abs.resize( leng);
+        _row.setLeng( leng);
+
+        QMutexLocker locker( &imageMutex);
+        _fft_leng = leng;
+        _waterfall.setSize( std::min<uint64_t>( leng, _display_width), _visible_rows);
+        _trace.clear();
     }
 
-    /// @brief processes data from _input_buf as long as there are any
+    /// @brief processes frames from _puff as long as there are any, the stft itself
+    ///        is calculated once by the upstream StftProcessor. Jeder Frame geht in die
+    ///        Mittelung ein, gezeichnet wird nur mit der Zeilenrate, der GUI-Thread holt
+    ///        das Ergebnis ab.
     ///        -> wird als thread ausgef
     void process() {
-        std::vector<std::complex<float>> data;
+        StftFrame frame;
+        clock::time_point next_row = clock::now();
 
         while( _is_processing) {
-            _puff.try_pop( _input_buf);
-
-            uint64_t consumed = 0;
-            while(( _input_buf.size() - consumed) >= _fft->leng()) {
-                _fft->fft( _input_buf.data() + consumed, _buf_fft.data());
-                Tools::abs<std::complex<float>, float>( _buf_fft, _buf_fft_abs);
-                Tools::center( _buf_fft_abs);
-                Tools::log10( _buf_fft_abs);
-
-                std::this_thread::sleep_for( std::chrono::milliseconds( 20));
-                _psd->fill( Qt::white);
-
-                // push result to set images
-                _avg->push( _buf_fft_abs);
-                addLineToSpectrogram( _avg->getAverage());
-                addPSDToImage( _avg->getAverage());
-                rescaleLabels();
-
-                // addLineToSpectrogram( _buf_fft_abs);
-                // addPSDToImage( _buf_fft_abs);
-
-                // update GUI
-                QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
-
-                consumed += _fft->leng();
-
+            if( ! _puff.pop( frame))
+                continue;
+            const uint64_t leng = frame.leng();
+            if( ! leng) continue;
+            if( leng != _fft_leng) setFFTLeng( leng);
+            if( _avg_changed.exchange( false)) {
+                _avg->setMode( _pending_avg_mode);
+                _avg->setAverage( _pending_avg);
             }
 
-            // Verarbeitete Samples aus dem Puffer entfernen
-            if( consumed) _input_buf.erase( _input_buf.begin(), _input_buf.begin() + consumed);
+            // jeden Frame mitteln
+            _avg->push( frame);
+            _row.push( frame);
+            frame = StftFrame();
+            ++_frames;
+
+            const clock::time_point now = clock::now();
+            if( now < next_row) continue;
+            next_row += _row_period.load();
+            if( next_row < now) next_row = now + _row_period.load();
+
+            // Leistung in FFT-Reihenfolge -> DC in die Mitte -> Bildspalten -> dBFS,
+            // der Aufwand ab hier haengt von der Bildbreite ab, nicht von der FFT-Laenge
+            const uint64_t width = std::min<uint64_t>( leng, _display_width);
+            _row.get( _buf_psd, false);
+            _row.reset();
+            toPixels( width, _buf_row);
+            _avg->get( _buf_psd, false);
+            toPixels( width, _buf_trace);
+
+            QMutexLocker locker( &imageMutex);
+            _waterfall.addLine( _buf_row.data(), width);
+            _trace.swap( _buf_trace);
+            _dirty = true;
         }
     }
 
-    /// @brief setzt die Zoomstufe auf den Graphen
-    void setZoom();
+    /// @brief _buf_psd (Leistung, FFT-Reihenfolge) zentriert auf width Spalten in dBFS
+    void toPixels( uint64_t width, std::vector<float> &output) {
+        const uint64_t leng = _buf_psd.size();
+        std::rotate_copy( _buf_psd.begin(), _buf_psd.begin() + ( leng + 1) / 2, _buf_psd.end(),
+                          _buf_fft_abs.begin());
+        output.resize( width);
+        Reduce::toWidth( _buf_fft_abs.data(), leng, output.data(), width, _reduction);
+        Decibel::fromPower( output.data(), output.data(), width);
+    }
 
 
 
-    ConditionSafeQueue<std::complex<float>> _puff;
-    std::vector<std::complex<float>> _input_buf, _buf_fft, _buf_fft_2;
-    std::vector<float> _buf_fft_abs, _sonat;
+    // ein Frame belegt nur zwei Zeiger, Luft fuer Lastspitzen der Verarbeitung
+    SpscRing<StftFrame> _puff{ 64};
+    std::vector<float> _buf_psd, _buf_fft_abs, _sonat;
+    std::vector<float> _buf_row, _buf_trace;
+    std::vector<float> _trace;          // psd fuer die Anzeige, DC in der Mitte, je Bildspalte
 
     uint64_t _file_byte_size;
     QPainter* _painter;
-    std::unique_ptr<QImage> _spectrogramm, _psd;
+    Waterfall _waterfall;
     QPixmap _pixmap;
     QSplitter *_qs_splitter;
     QLabel *_ql_psd,
@@ -431,22 +657,33 @@ private:
 
     std::fstream _file;
     uint64_t _chunk_leng;
-    uint64_t _pos_overlap;
-    uint64_t _current_line;
+    uint64_t _fft_leng;                 // schreibt nur der Verarbeitungsthread, unter imageMutex
     uint64_t _visible_rows;
 
     std::atomic_bool _is_processing;
+    std::atomic_bool _dirty;
+    QTimer *_refresh;
+
+    PsdAverage _row;                    // Frames der aktuellen Wasserfallreihe
+    std::atomic<clock::duration> _row_period;
+    std::atomic<uint64_t> _frames, _dropped;
+    std::atomic<uint64_t> _display_width;
+    std::atomic<Reduce::Mode> _reduction;
+    // Mittelung der Kurve, von setAverage()/setAverageMode() an den Verarbeitungsthread
+    std::atomic<uint64_t> _pending_avg;
+    std::atomic<PsdAverage::Mode> _pending_avg_mode;
+    std::atomic_bool _avg_changed;
+    double _band_center, _band_span;    // dargestelltes Band relativ zur Abtastrate
 
     std::thread _proc;
     QMutex imageMutex;
 
-    FFT* _fft;
     std::vector<std::ifstream> _file_reader;
     int _mode;
 
     bool _draw_upsidedown;
 
-    Tools::MovingAverage<float> *_avg;
+    PsdAverage *_avg;
 
 
 };
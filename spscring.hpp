@@ -0,0 +1,199 @@
+#ifndef SPSCRING_HPP
+#define SPSCRING_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+
+/// @brief Lock-freier Ringpuffer fuer genau einen Erzeuger und einen Verbraucher.
+///        Die Slots werden einmalig angelegt, try_push/try_pop sind wait-free. Die
+///        blockierenden Varianten schlafen ueber std::atomic::wait (unter Linux ein
+///        futex) und werden nur dann geweckt, wenn die Gegenseite wirklich wartet.
+///        Auf dem Sample-Pfad sind die Slots SampleBlockPtr, d.h. je Slot ein Block
+///        fester Laenge aus dem Pool.
+template <class T>
+class SpscRing {
+    static constexpr uint64_t CACHE_LINE = 64;
+
+    // Verbraucher-Seite
+    alignas( CACHE_LINE) std::atomic<uint64_t> _head{ 0};
+    uint64_t _tail_cache = 0;
+    // Erzeuger-Seite
+    alignas( CACHE_LINE) std::atomic<uint64_t> _tail{ 0};
+    uint64_t _head_cache = 0;
+    // Weckmechanik
+    alignas( CACHE_LINE) std::atomic<uint32_t> _data_seq{ 0};
+    std::atomic<uint32_t> _space_seq{ 0};
+    std::atomic_bool _consumer_waiting{ false};
+    std::atomic_bool _producer_waiting{ false};
+    std::atomic_bool _aborted{ false};
+
+    alignas( CACHE_LINE) std::vector<T> _slots;
+    uint64_t _mask;
+
+    void wakeConsumer() {
+        std::atomic_thread_fence( std::memory_order_seq_cst);
+        if( _consumer_waiting.load( std::memory_order_relaxed)) {
+            _data_seq.fetch_add( 1, std::memory_order_release);
+            _data_seq.notify_one();
+        }
+    }
+    void wakeProducer() {
+        std::atomic_thread_fence( std::memory_order_seq_cst);
+        if( _producer_waiting.load( std::memory_order_relaxed)) {
+            _space_seq.fetch_add( 1, std::memory_order_release);
+            _space_seq.notify_one();
+        }
+    }
+
+    bool full() {
+        const uint64_t tail = _tail.load( std::memory_order_relaxed);
+        if( tail - _head_cache < _slots.size()) return false;
+        _head_cache = _head.load( std::memory_order_acquire);
+        return tail - _head_cache >= _slots.size();
+    }
+    bool drained() {
+        const uint64_t head = _head.load( std::memory_order_relaxed);
+        if( head != _tail_cache) return false;
+        _tail_cache = _tail.load( std::memory_order_acquire);
+        return head == _tail_cache;
+    }
+
+public:
+    /// @param capacity Anzahl Slots, wird auf die naechste Zweierpotenz aufgerundet
+    explicit SpscRing( uint64_t capacity = 64) {
+        if( ! capacity) throw std::invalid_argument( "FEHLER SpscRing: capacity == 0");
+        uint64_t leng = 1;
+        while( leng < capacity) leng <<= 1;
+        _slots.resize( leng);
+        _mask = leng - 1;
+    }
+    SpscRing( const SpscRing<T> &) = delete;
+    SpscRing& operator =( const SpscRing<T> &) = delete;
+
+    uint64_t capacity() const { return _slots.size();}
+    /// @brief Momentaufnahme des Fuellstands
+    uint64_t size() const {
+        return _tail.load( std::memory_order_acquire) - _head.load( std::memory_order_acquire);
+    }
+    bool empty() const { return ! size();}
+    bool aborted() const { return _aborted;}
+
+    /// @brief Erzeuger: wait-free, false wenn voll
+    template <class U>
+    bool try_push( U &&input) {
+        if( _aborted || full()) return false;
+        const uint64_t tail = _tail.load( std::memory_order_relaxed);
+        _slots[ tail & _mask] = std::forward<U>( input);
+        _tail.store( tail + 1, std::memory_order_release);
+        wakeConsumer();
+        return true;
+    }
+
+    /// @brief Erzeuger: schreibt so viele Elemente wie Platz ist, ein einziges Freigeben
+    /// @return Anzahl uebernommener Elemente
+    uint64_t try_push_n( const T *input, uint64_t leng) {
+        if( _aborted) return 0;
+        const uint64_t tail = _tail.load( std::memory_order_relaxed);
+        if( tail - _head_cache + leng > _slots.size())
+            _head_cache = _head.load( std::memory_order_acquire);
+        const uint64_t count = std::min( leng, _slots.size() - ( tail - _head_cache));
+        for( uint64_t w = 0; w < count; ++w)
+            _slots[ ( tail + w) & _mask] = input[ w];
+        if( count) {
+            _tail.store( tail + count, std::memory_order_release);
+            wakeConsumer();
+        }
+        return count;
+    }
+
+    /// @brief Erzeuger: wartet auf einen freien Slot, false nach abort()
+    template <class U>
+    bool push( U &&input) {
+        while( ! try_push( std::forward<U>( input))) {
+            if( _aborted) return false;
+            _producer_waiting.store( true);
+            const uint32_t seq = _space_seq.load( std::memory_order_acquire);
+            std::atomic_thread_fence( std::memory_order_seq_cst);
+            if( full() && ! _aborted)
+                _space_seq.wait( seq, std::memory_order_acquire);
+            _producer_waiting.store( false, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /// @brief Verbraucher: wait-free, false wenn leer
+    bool try_pop( T &output) {
+        if( drained()) return false;
+        const uint64_t head = _head.load( std::memory_order_relaxed);
+        output = std::move( _slots[ head & _mask]);
+        _slots[ head & _mask] = T();
+        _head.store( head + 1, std::memory_order_release);
+        wakeProducer();
+        return true;
+    }
+
+    /// @brief Verbraucher: holt bis zu leng Elemente, ein einziges Freigeben
+    /// @return Anzahl geholter Elemente
+    uint64_t try_pop_n( T *output, uint64_t leng) {
+        const uint64_t head = _head.load( std::memory_order_relaxed);
+        if( _tail_cache - head < leng)
+            _tail_cache = _tail.load( std::memory_order_acquire);
+        const uint64_t count = std::min( leng, _tail_cache - head);
+        for( uint64_t w = 0; w < count; ++w) {
+            output[ w] = std::move( _slots[ ( head + w) & _mask]);
+            _slots[ ( head + w) & _mask] = T();
+        }
+        if( count) {
+            _head.store( head + count, std::memory_order_release);
+            wakeProducer();
+        }
+        return count;
+    }
+
+    /// @brief Verbraucher: wartet auf Daten, false nach abort()
+    bool pop( T &output) {
+        while( ! try_pop( output)) {
+            if( _aborted) return false;
+            _consumer_waiting.store( true);
+            const uint32_t seq = _data_seq.load( std::memory_order_acquire);
+            std::atomic_thread_fence( std::memory_order_seq_cst);
+            if( drained() && ! _aborted)
+                _data_seq.wait( seq, std::memory_order_acquire);
+            _consumer_waiting.store( false, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /// @brief Verbraucher: wartet auf mindestens ein Element und holt bis zu leng
+    uint64_t pop_n( T *output, uint64_t leng) {
+        if( ! leng || ! pop( output[ 0])) return 0;
+        return 1 + try_pop_n( output + 1, leng - 1);
+    }
+
+    /// @brief ABBRUCH: weckt beide Seiten, weitere push() werden abgewiesen
+    void abort() {
+        _aborted = true;
+        _data_seq.fetch_add( 1);
+        _data_seq.notify_all();
+        _space_seq.fetch_add( 1);
+        _space_seq.notify_all();
+    }
+
+    /// @brief Verbraucher: verwirft alle Elemente
+    void clear() {
+        T dummy;
+        while( try_pop( dummy)) {}
+    }
+
+    /// @brief nach abort() wieder freigeben, nur wenn beide Seiten ruhen
+    void reset() {
+        clear();
+        _aborted = false;
+    }
+};
+
+#endif // SPSCRING_HPP
@@ -0,0 +1,227 @@
+#ifndef STFT_HPP
+#define STFT_HPP
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "sampleblock.hpp"
+#include "ports.hpp"
+#include "baseprocessor.hpp"
+#include "fft.hpp"
+#include "fftwindows.hpp"
+#include "decibel.hpp"
+
+
+/// @brief Ein Frame der STFT. Die Bloecke stammen aus Pools und werden von allen
+///        Abonnenten geteilt, sie duerfen nicht veraendert werden.
+struct StftFrame {
+    uint64_t index = 0;             // fortlaufende Nummer des Frames
+    uint64_t sample_index = 0;      // Position des ersten Abtastwerts im Strom
+    uint64_t hop = 0;               // Vorschub zum naechsten Frame [Abtastwerte]
+    double window_sum = 0;          // Summe der Fensterkoeffizienten
+    double window_power_sum = 0;    // Summe der quadrierten Fensterkoeffizienten
+    SampleBlockPtr<std::complex<float>> spectrum;   // leng bins, FFT-Reihenfolge (bin 0 = DC)
+    SampleBlockPtr<float> magnitude;                // 10*log10(|X|^2) in FFT-Reihenfolge, leer wenn aus
+
+    uint64_t leng() const { return spectrum ? spectrum->size() : 0;}
+};
+
+
+/// @brief Streaming-STFT: nimmt Bloecke beliebiger Laenge an und erzeugt gefensterte,
+///        ueberlappende Frames mit beliebigem Vorschub (auch hop > leng). Fenster und
+///        Kopie laufen in einem Durchgang, die FFT in-place auf einem Block aus dem Pool;
+///        im eingeschwungenen Zustand wird je Frame kein Speicher angelegt.
+///        Jeder Frame wird ueber output() an alle Abonnenten verteilt, die FFT wird also
+///        nur einmal gerechnet.
+class Stft {
+public:
+    enum class Window { Rect = -1, Hamming = 0, VonHann = 1, Blackman = 2, FlatTop = 3};
+
+private:
+    uint64_t _leng, _hop;
+    Window _window_type;
+    bool _magnitude;
+
+    FFT _fft;
+    std::vector<float> _window;
+    double _window_sum, _window_power_sum;
+    // Rest des Stroms, der fuer den naechsten Frame noch gebraucht wird (< leng)
+    std::vector<std::complex<float>> _tail;
+    uint64_t _tail_fill;
+    uint64_t _tail_start;           // Stromposition von _tail[ 0]
+    uint64_t _next_start;           // Stromposition des naechsten Frames
+    uint64_t _frame_index;
+
+    SampleBlockPool<std::complex<float>> _spectrum_pool;
+    SampleBlockPool<float> _magnitude_pool;
+    OutputPort<StftFrame> _output;
+
+    void setupWindow() {
+        _window.assign( _leng, 1.f);
+        if( _window_type != Window::Rect)
+            FFTWindow().windowSignal<float>( _window.data(), _leng, static_cast<int>( _window_type));
+        _window_sum = std::accumulate( _window.begin(), _window.end(), 0.);
+        _window_power_sum = std::inner_product( _window.begin(), _window.end(), _window.begin(), 0.);
+    }
+
+    /// @brief erzeugt den Frame ab _next_start, dessen Abtastwerte teils im Rest, teils im
+    ///        neuen Block (Stromposition input_start) liegen
+    void emitFrame( const std::complex<float> *input, uint64_t input_start) {
+        std::shared_ptr<SampleBlock<std::complex<float>>> spectrum = _spectrum_pool.acquire( _leng);
+        std::complex<float> *frame = spectrum->data();
+
+        // Fenster und Kopie in einem Durchgang
+        uint64_t k = 0;
+        if( _next_start < input_start) {
+            const std::complex<float> *tail = _tail.data() + ( _next_start - _tail_start);
+            const uint64_t from_tail = std::min( _leng, input_start - _next_start);
+            for( ; k < from_tail; ++k)
+                frame[ k] = tail[ k] * _window[ k];
+        }
+        const std::complex<float> *in = input + ( _next_start + k - input_start);
+        for( uint64_t w = 0; k < _leng; ++k, ++w)
+            frame[ k] = in[ w] * _window[ k];
+
+        _fft.fft( frame, frame);
+
+        StftFrame out;
+        out.index = _frame_index++;
+        out.sample_index = _next_start;
+        out.hop = _hop;
+        out.window_sum = _window_sum;
+        out.window_power_sum = _window_power_sum;
+        if( _magnitude) {
+            std::shared_ptr<SampleBlock<float>> magnitude = _magnitude_pool.acquire( _leng);
+            Decibel::Coefficients co;
+            co.floor_db = -200.f;
+            Decibel::fromNorm( frame, magnitude->data(), _leng, co);
+            out.magnitude = std::move( magnitude);
+        }
+        out.spectrum = std::move( spectrum);
+        _output.publish( out);
+    }
+
+public:
+    /// @param leng FFT-Laenge
+    /// @param hop Vorschub zwischen zwei Frames (leng / 4: 75% Ueberlappung)
+    /// @param magnitude zusaetzlich 10*log10(|X|^2) je bin ausgeben
+    Stft( uint64_t leng = 1024, uint64_t hop = 256, Window window = Window::VonHann, bool magnitude = true)
+        : _leng( leng), _hop( hop), _window_type( window), _magnitude( magnitude), _fft( leng),
+          _window_sum( 0), _window_power_sum( 0),
+          _tail_fill( 0), _tail_start( 0), _next_start( 0), _frame_index( 0),
+          _spectrum_pool( leng), _magnitude_pool( leng) {
+        setLeng( leng, hop);
+    }
+
+    /// @brief neue Laenge/Vorschub, verwirft den angesammelten Rest
+    /// @param hop 0: leng / 4
+    void setLeng( uint64_t leng, uint64_t hop = 0) {
+        if( leng < 2) throw std::invalid_argument( "FEHLER Stft: leng < 2");
+        _leng = leng;
+        _hop = hop ? hop : std::max<uint64_t>( leng / 4, 1);
+        _fft.setLeng( leng);
+        _tail.assign( leng, std::complex<float>( 0, 0));
+        _spectrum_pool.setBlockLeng( leng);
+        _magnitude_pool.setBlockLeng( leng);
+        setupWindow();
+        reset();
+    }
+    void setHop( uint64_t hop) {
+        if( ! hop) throw std::invalid_argument( "FEHLER Stft: hop == 0");
+        _hop = hop;
+    }
+    void setWindow( Window window) {
+        _window_type = window;
+        setupWindow();
+    }
+    void setMagnitude( bool magnitude) { _magnitude = magnitude;}
+
+    uint64_t leng() const { return _leng;}
+    uint64_t hop() const { return _hop;}
+    Window window() const { return _window_type;}
+    /// @brief Summe der Fensterkoeffizienten (kohaerente Verstaerkung)
+    double windowSum() const { return _window_sum;}
+    /// @brief Summe der quadrierten Fensterkoeffizienten (Rauschleistung)
+    double windowPowerSum() const { return _window_power_sum;}
+
+    /// @brief verwirft den Rest, der naechste Frame beginnt mit dem naechsten Abtastwert
+    void reset() {
+        _tail_start += _tail_fill;
+        _next_start = _tail_start;
+        _tail_fill = 0;
+    }
+
+    /// @brief haengt leng Abtastwerte an und erzeugt alle vollstaendigen Frames
+    void push( const std::complex<float> *input, uint64_t leng) {
+        const uint64_t input_start = _tail_start + _tail_fill;
+        const uint64_t end = input_start + leng;
+
+        while( _next_start + _leng <= end) {
+            emitFrame( input, input_start);
+            _next_start += _hop;
+        }
+
+        // benoetigten Rest behalten, er ist immer kuerzer als leng
+        const uint64_t keep_from = std::max( _next_start, _tail_start);
+        if( keep_from >= end) {
+            _tail_start = end;
+            _tail_fill = 0;
+            return;
+        }
+        const uint64_t keep = end - keep_from;
+        if( keep_from < input_start) {
+            // Teil aus dem alten Rest nach vorn schieben
+            const uint64_t from_tail = input_start - keep_from;
+            std::memmove( _tail.data(), _tail.data() + ( keep_from - _tail_start),
+                          from_tail * sizeof( std::complex<float>));
+            std::copy( input, input + leng, _tail.data() + from_tail);
+        }
+        else
+            std::copy( input + ( keep_from - input_start), input + leng, _tail.data());
+        _tail_start = keep_from;
+        _tail_fill = keep;
+    }
+
+    /// @brief wie push(), input beginnt an Stromposition stream_index (SampleBlock::index()).
+    ///        Bei einer Luecke (verworfene Bloecke) wird neu aufgesetzt, statt Frames ueber
+    ///        die Luecke zu bilden; StftFrame::sample_index bezieht sich dann auf die Quelle.
+    void push( const std::complex<float> *input, uint64_t leng, uint64_t stream_index) {
+        if( stream_index != _tail_start + _tail_fill) {
+            _tail_start = _next_start = stream_index;
+            _tail_fill = 0;
+        }
+        push( input, leng);
+    }
+
+    OutputPort<StftFrame>& output() { return _output;}
+};
+
+
+/// @brief Knoten im FlowGraph: rechnet die STFT im eigenen Thread und verteilt die Frames
+///        ueber output() an alle Abonnenten (z.B. Sonarview und CarrierDetection)
+class StftProcessor : public BaseProcessor {
+    Stft _stft;
+
+    void process( const SampleBlockPtr<std::complex<float>> &input) override {
+        _stft.push( input->data(), input->size(), input->index());
+    }
+
+public:
+    StftProcessor( uint64_t leng = 1024, uint64_t hop = 256,
+                   Stft::Window window = Stft::Window::VonHann, bool magnitude = true)
+        : BaseProcessor( 256, Overflow::DropOldest), _stft( leng, hop, window, magnitude) {}
+    ~StftProcessor() {
+        stop();
+    }
+
+    /// @brief Zugriff auf die Einstellungen, nur bei gestopptem Knoten aendern
+    Stft& stft() { return _stft;}
+    OutputPort<StftFrame>& output() { return _stft.output();}
+};
+
+#endif // STFT_HPP
@@ -0,0 +1,63 @@
+// Ddc: Sperrdaempfung gegen Aliasing im nutzbaren Band (0.8 / decimation)
+
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "ddc.hpp"
+
+namespace {
+
+/// @brief Pegel [dB] eines Tons bei rel_freq nach dem Ddc, gemessen an der Frequenz, auf
+///        die er nach dem Dezimieren faellt
+double outputLevel( uint64_t decimation, double rel_freq) {
+    Ddc ddc( 0., decimation);
+    std::vector<std::complex<float>> input( decimation * 8192), output;
+    for( uint64_t n = 0; n < input.size(); ++n)
+        input[ n] = std::polar( 1., 2. * M_PI * rel_freq * static_cast<double>( n));
+    ddc.process( input.data(), input.size(), output);
+
+    double folded = rel_freq * static_cast<double>( decimation);
+    folded -= std::round( folded);
+    // Einschwingen des Filters ueberspringen
+    const uint64_t skip = ddc.taps() / decimation + 1;
+    std::complex<double> sum( 0., 0.);
+    for( uint64_t n = skip; n < output.size(); ++n)
+        sum += std::complex<double>( output[ n]) * std::polar( 1., -2. * M_PI * folded * static_cast<double>( n));
+    return 20. * std::log10( std::abs( sum) / static_cast<double>( output.size() - skip) + 1e-30);
+}
+
+} // namespace
+
+
+int main() {
+    int failed = 0;
+    for( const double span : { 0.1, 0.02, 0.005}) {
+        const uint64_t decimation = ZoomProcessor::decimationFor( span);
+        const double rate = 1. / static_cast<double>( decimation);
+        if( span > 0.8 * rate) {
+            std::cerr << "FEHLER span " << span << ": Dezimation " << decimation << " zu gross" << std::endl;
+            ++failed;
+        }
+        // Durchlass bis an den Rand des angeforderten Bandes
+        for( const double pass : { 0., 0.25 * span, 0.5 * span, -0.5 * span}) {
+            const double level = outputLevel( decimation, pass);
+            if( std::abs( level) > 0.1) {
+                std::cerr << "FEHLER span " << span << ": Durchlass bei " << pass << " " << level << " dB" << std::endl;
+                ++failed;
+            }
+        }
+        // Toene, die beim Dezimieren in das angeforderte Band falten
+        for( const double alias : { rate - 0.5 * span, rate, rate + 0.5 * span, -rate + 0.25 * span, 2. * rate}) {
+            const double level = outputLevel( decimation, alias);
+            if( level > -65.) {
+                std::cerr << "FEHLER span " << span << ": Alias bei " << alias << " nur " << level << " dB" << std::endl;
+                ++failed;
+            }
+        }
+    }
+    if( ! failed) std::cout << "ddc_test: OK" << std::endl;
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
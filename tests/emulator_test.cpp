@@ -0,0 +1,200 @@
+// MouseEmulator -> MouseSource -> FlowGraph: Anzahl, Stromposition und Inhalt der Bloecke
+// an den rohen (int16) und gewandelten (cf32) Ausgaengen
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mouseemulator.hpp"
+#include "mousesource.hpp"
+#include "flowgraph.hpp"
+
+namespace {
+
+constexpr uint32_t TRANSFER = 4096;
+constexpr float SCALE = 1.f / 32767.f;
+
+/// @brief gesammelte Bloecke einer Senke, aus deren Thread befuellt
+template <typename T>
+struct Collected {
+    std::mutex mutexer;
+    std::vector<SampleBlockPtr<T>> blocks;
+
+    std::function<void( const SampleBlockPtr<T> &)> sink() {
+        return [ this]( const SampleBlockPtr<T> &input) {
+            std::lock_guard<std::mutex> lock( mutexer);
+            blocks.push_back( input);
+        };
+    }
+};
+
+/// @brief wartet, bis die Quelle fertig ist (Dateiende) oder count Bloecke je Senke
+///        verarbeitet sind und alle Senken ihre Warteschlange abgearbeitet haben
+bool drain( MouseSource &source, const FlowGraph &graph, uint64_t count) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 20);
+    while( std::chrono::steady_clock::now() < deadline) {
+        bool done = true;
+        for( const auto &node : graph.nodes()) {
+            const ProcessorNode::Statistics stat = node->getStatistics();
+            done = done && stat.queued == 0 && stat.processed == stat.received
+                   && ( ! source.device().isAsyncStreaming() || stat.processed >= count);
+        }
+        if( done) return true;
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10));
+    }
+    return false;
+}
+
+/// @brief Bloecke luecken- und ueberlappungsfrei ab Stromposition 0
+template <typename T>
+int checkIndices( const char *name, const std::vector<SampleBlockPtr<T>> &blocks) {
+    uint64_t index = 0;
+    for( const SampleBlockPtr<T> &block : blocks) {
+        if( block->index() != index) {
+            std::cerr << "FEHLER " << name << ": Block bei " << block->index() << " statt " << index << std::endl;
+            return 1;
+        }
+        index += block->size();
+    }
+    return 0;
+}
+
+/// @brief Mitschnitt ohne loop: genau die Datei, dann Ende wie ein abgezogenes Geraet
+int testFile() {
+    int failed = 0;
+    // Rampe, die in keinem Block gleich aussieht, dazu ein kurzer letzter Block
+    const uint64_t leng = 10 * TRANSFER + 1000;
+    std::vector<std::complex<int16_t>> samples( leng);
+    for( uint64_t n = 0; n < leng; ++n)
+        samples[ n] = { static_cast<int16_t>( n % 65536 - 32768), static_cast<int16_t>( -static_cast<int64_t>( n % 30011))};
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "emulator_test.sc16";
+    std::ofstream( path, std::ios::binary).write( reinterpret_cast<const char*>( samples.data()),
+                                                  samples.size() * sizeof( samples[ 0]));
+
+    MouseEmulator::Config conf;
+    conf.mode = MouseEmulator::Mode::File;
+    conf.path = path.string();
+    conf.loop = false;
+    conf.paced = false;
+    MouseSource source( TRANSFER, std::make_unique<MouseEmulator>( conf));
+    if( source.open()) {
+        std::cerr << "FEHLER " << source.getError() << std::endl;
+        return 1;
+    }
+
+    // Block: die Senken lassen die Quelle warten, statt Bloecke zu verwerfen
+    FlowGraph graph;
+    Collected<std::complex<int16_t>> raw;
+    Collected<std::complex<float>> converted;
+    auto raw_sink = graph.addSink<SampleBlockPtr<std::complex<int16_t>>>( raw.sink(), 256, ProcessorNode::Overflow::Block);
+    auto sink = graph.addSink( converted.sink(), 256, ProcessorNode::Overflow::Block);
+    graph.connect( source.rawOutput(), *raw_sink);
+    graph.connect( source.output(), *sink);
+    graph.start();
+    source.startStreaming();
+    if( ! drain( source, graph, std::numeric_limits<uint64_t>::max())) {
+        std::cerr << "FEHLER Mitschnitt: Zeitueberschreitung" << std::endl;
+        ++failed;
+    }
+    graph.disconnectAll();
+    graph.stop();
+    source.close();
+    std::filesystem::remove( path);
+
+    const uint64_t expected = ( leng + TRANSFER - 1) / TRANSFER;
+    if( raw.blocks.size() != expected || converted.blocks.size() != expected) {
+        std::cerr << "FEHLER Mitschnitt: " << raw.blocks.size() << " / " << converted.blocks.size()
+                  << " Bloecke statt " << expected << std::endl;
+        return failed + 1;
+    }
+    failed += checkIndices( "roh", raw.blocks) + checkIndices( "cf32", converted.blocks);
+    if( source.getSampleCount() != leng) {
+        std::cerr << "FEHLER Mitschnitt: " << source.getSampleCount() << " Abtastwerte statt " << leng << std::endl;
+        ++failed;
+    }
+    for( uint64_t b = 0; b < expected && ! failed; ++b) {
+        const SampleBlockPtr<std::complex<int16_t>> &in = raw.blocks[ b];
+        const SampleBlockPtr<std::complex<float>> &out = converted.blocks[ b];
+        for( uint64_t w = 0; w < in->size(); ++w) {
+            const std::complex<int16_t> want = samples[ in->index() + w];
+            const std::complex<float> scaled( want.real() * SCALE, want.imag() * SCALE);
+            if( in->data()[ w] != want || std::abs( out->data()[ w] - scaled) > 1e-6f) {
+                std::cerr << "FEHLER Mitschnitt: Abtastwert " << in->index() + w << std::endl;
+                ++failed;
+                break;
+            }
+        }
+    }
+    return failed;
+}
+
+/// @brief ein Ton ohne Rauschen: jeder Wert ist amplitude * exp( j 2 pi f n / fs)
+int testTone() {
+    int failed = 0;
+    MouseEmulator::Config conf;
+    conf.mode = MouseEmulator::Mode::Tone;
+    conf.tones = { 3125.};
+    conf.amplitude = .5;
+    conf.noise = 0.;
+    conf.paced = false;
+    conf.filter_index = 6;
+    MouseSource source( TRANSFER, std::make_unique<MouseEmulator>( conf));
+    if( source.open() || source.setFilter( 6) != 31250) {
+        std::cerr << "FEHLER Ton: open()/setFilter()" << std::endl;
+        return 1;
+    }
+
+    const uint64_t count = 8;
+    FlowGraph graph;
+    Collected<std::complex<float>> converted;
+    auto sink = graph.addSink( converted.sink(), 256, ProcessorNode::Overflow::Block);
+    graph.connect( source.output(), *sink);
+    graph.start();
+    source.startStreaming();
+    if( ! drain( source, graph, count)) {
+        std::cerr << "FEHLER Ton: Zeitueberschreitung" << std::endl;
+        ++failed;
+    }
+    // Senke zuerst abhaengen, danach ankommende Bloecke werden nicht mehr gesammelt
+    graph.disconnectAll();
+    source.close();
+    graph.stop();
+
+    if( converted.blocks.size() < count) {
+        std::cerr << "FEHLER Ton: " << converted.blocks.size() << " Bloecke statt " << count << std::endl;
+        return failed + 1;
+    }
+    failed += checkIndices( "Ton", converted.blocks);
+    // int16-Rundung plus Drift der Drehzeiger
+    const double step = 2. * M_PI * 3125. / 31250.;
+    for( uint64_t b = 0; b < count && ! failed; ++b) {
+        const SampleBlockPtr<std::complex<float>> &out = converted.blocks[ b];
+        for( uint64_t w = 0; w < out->size(); ++w) {
+            const std::complex<double> want = std::polar( .5, step * static_cast<double>( out->index() + w));
+            if( std::abs( std::complex<double>( out->data()[ w]) - want) > 1e-4) {
+                std::cerr << "FEHLER Ton: Abtastwert " << out->index() + w << " " << out->data()[ w]
+                          << " statt " << want << std::endl;
+                ++failed;
+                break;
+            }
+        }
+    }
+    return failed;
+}
+
+} // namespace
+
+
+int main() {
+    const int failed = testFile() + testTone();
+    if( ! failed) std::cout << "emulator_test: OK" << std::endl;
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -5,10 +5,11 @@
 #include <algorithm>
 #include <complex>
 #include <cstdint>
-#include <deque>
 #include <iostream>
 #include <execution>
 
+#include "decibel.hpp"
+
 namespace Tools {
 
 template <typename T>
@@ -33,49 +34,78 @@ void norm( const std::vector<std::complex<float>> &input, std::vector<T> &output
 //    return lsr;
 //}
 
-/// @brief applies a moving average
-///
+/// @brief applies a moving average (or max / min) over the last leng vectors
+///        the vectors are kept in a preallocated ring, the mean costs O(1) per element
 template <class T>
 class MovingAverage {
-    std::deque<std::vector<T>> _buffer;
-    std::vector<T> _cum_sum, _output;
-    uint64_t _leng;
+public:
+    enum class Mode { Mean, Max, Min};
+
+private:
+    std::vector<T> _ring, _cum_sum, _output;
+    uint64_t _leng, _size, _pos, _fill;
+    Mode _mode;
+
+    void resize( uint64_t size) {
+        _size = size;
+        _ring.assign( _leng * size, static_cast<T>( 0.0));
+        _cum_sum.assign( size, static_cast<T>( 0.0));
+        _output.assign( size, static_cast<T>( 0.0));
+        _pos = 0;
+        _fill = 0;
+    }
 
 public:
-    MovingAverage( uint64_t leng) : _leng( leng) {
+    MovingAverage( uint64_t leng, Mode mode = Mode::Mean)
+        : _leng( std::max<uint64_t>( leng, 1)), _size( 0), _pos( 0), _fill( 0), _mode( mode) {
     }
 
     uint64_t getLeng() const { return _leng;}
-    void setLeng( uint64_t leng) { _leng = leng;}
+    /// @brief neue Laenge, verwirft die gespeicherten Vektoren
+    void setLeng( uint64_t leng) {
+        _leng = std::max<uint64_t>( leng, 1);
+        resize( _size);
+    }
 
     /// @brief Ausgabe Mittelwert
-    void average( std::vector<T> &output) { output = getAverage(); }
-    std::vector<T> getAverage() const { return _output;}
+    void average( std::vector<T> &output) { output = _output; }
+    const std::vector<T>& getAverage() const { return _output;}
 
-    // may implement Max / Min / Avg
-    void setMode() {
-        throw std::runtime_error("not implemented");
+    /// @brief Mittelwert, Maximum oder Minimum je Element
+    void setMode( Mode mode) {
+        _mode = mode;
+        resize( _size);
     }
 
     /// @brief checkinput - buffer size, moving average
     void push( const std::vector<T> &input) {
-        std::vector<T> tmp = input;
-        if( _cum_sum.size() != input.size()) {
-            _cum_sum = std::vector<T>( input.size(), static_cast<T>( 0.0));
-            _buffer.resize( 0);
-            std::cerr << " size mismatch" << std::endl;
+        if( _size != input.size())
+            resize( input.size());
+
+        T *slot = _ring.data() + _pos * _size;
+        if( _fill == _leng)
+            std::transform( _cum_sum.begin(), _cum_sum.end(), slot, _cum_sum.begin(), std::minus<T>());
+        else
+            ++_fill;
+        std::copy( input.begin(), input.end(), slot);
+        std::transform( _cum_sum.begin(), _cum_sum.end(), input.begin(), _cum_sum.begin(), std::plus<T>());
+        _pos = ( _pos + 1) % _leng;
+
+        if( _mode == Mode::Mean) {
+            const T siz = static_cast<T>( _fill);
+            std::transform( _cum_sum.begin(), _cum_sum.end(), _output.begin(), [ siz] (const T &val)
+                           {return val / siz;});
+            return;
         }
-        _buffer.push_back( tmp);
-        std::transform( std::execution::par, _cum_sum.begin(), _cum_sum.end(), _buffer.back().begin(), _cum_sum.begin(), std::plus<float>());
-        if(_buffer.size() > _leng) {
-            std::transform( std::execution::par, _cum_sum.begin(), _cum_sum.end(),  _buffer.front().begin(), _cum_sum.begin(), std::minus<float>());
-            _buffer.pop_front();
+        // Max / Min ueber die gespeicherten Vektoren
+        std::copy( _ring.begin(), _ring.begin() + _size, _output.begin());
+        for( uint64_t r = 1; r < _fill; ++r) {
+            const T *row = _ring.data() + r * _size;
+            if( _mode == Mode::Max)
+                std::transform( _output.begin(), _output.end(), row, _output.begin(), []( T a, T b) { return std::max( a, b);});
+            else
+                std::transform( _output.begin(), _output.end(), row, _output.begin(), []( T a, T b) { return std::min( a, b);});
         }
-        _output.resize( _cum_sum.size());
-
-        const float siz = static_cast<float>( _buffer.size());
-        std::transform( std::execution::par, _cum_sum.begin(), _cum_sum.end(), _output.begin(), [ siz] (const float &val)
-                       {return val / siz;});
     }
 };
 
@@ -199,18 +229,15 @@ nPow(const std::vector<T> &input, int pow = 2) {
 }
 
 /// @brief Berechnet fuer jeden Wert des Vektors: 10.0 * std::log10(Value).
-///        Prueft auf isinfinite
+///        Vektorisiert (Decibel::fromPower, Fehler < 0.01 dB), 0 ergibt -120
 /// @param input Eingangsvektor
 /// @return Ausgangsvektor double
 template <typename T = double>
 static void
 log10(  std::vector<float> &input) {
-    for( uint64_t w = 0; w < input.size(); ++w) {
-        if( std::isinf( input.at( w)))
-            input[ w] = -120.;
-        else
-            input[ w] = 10 * std::log10( input.at( w));
-    }
+    Decibel::Coefficients co;
+    co.floor_db = -120.f;
+    Decibel::fromPower( input.data(), input.data(), input.size(), co);
 }
 /// @brief Berechnet fuer jeden Wert des Vektors: 10.0 * std::log10(Value).
 /// @param input Eingangsvektor
@@ -0,0 +1,203 @@
+#ifndef TRIGGERRECORDER_HPP
+#define TRIGGERRECORDER_HPP
+
+#include <string>
+#include <deque>
+#include <complex>
+#include <chrono>
+#include <ctime>
+#include <sstream>
+#include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+
+#include "sampleblock.hpp"
+#include "baseprocessor.hpp"
+#include "recording.hpp"
+
+
+/// @brief Aufnahme mit Vorlauf: haelt die letzten pre_trigger Sekunden als geteilte Bloecke
+///        im Speicher (keine Kopie, die Bloecke gehen erst beim Verdraengen an ihren Pool
+///        zurueck). trigger() - aus der Carrier-Erkennung, der API oder der GUI - schreibt
+///        den Vorlauf und danach alles bis post_trigger Sekunden nach dem letzten Trigger
+///        in eine eigene Datei "<prefix><zeit>_<nr>.sigmf-data" (plus .sigmf-meta).
+///        Ein Trigger waehrend der Aufnahme verlaengert sie. Zwischen den Ereignissen wird
+///        nichts geschrieben.
+///        T: complex<int16_t> (rohe Bloecke, SC16/SC8) oder complex<float> (CF32)
+template <typename T>
+class TriggeredRecorder : public BasicProcessor<SampleBlockPtr<T>> {
+    Recorder _recorder;
+    std::mutex _mutexer;
+    std::string _prefix;
+    RecordMeta _meta;
+    std::atomic<double> _samp_rate;
+
+    std::atomic<double> _pre_trigger, _post_trigger;    // [s]
+    std::atomic_bool _armed;
+    std::atomic<uint64_t> _trigger_requests;
+    uint64_t _triggers_handled;
+
+    // nur im Verarbeitungsthread
+    std::deque<SampleBlockPtr<T>> _history;
+    uint64_t _history_samples;
+    bool _recording;
+    uint64_t _record_until;     // Stromposition, bis zu der geschrieben wird
+    std::atomic<uint64_t> _files;
+    std::string _last_path;
+    bool _ring_ready;           // Ring des FileWriter angelegt
+    std::atomic_bool _ring_pending; // Vorlauf, Abtastrate oder Scharfschalten geaendert
+
+    uint64_t seconds( double secs) const {
+        return static_cast<uint64_t>( std::max( 0., secs) * _samp_rate);
+    }
+
+    std::string nextPath() {
+        const std::time_t now = std::chrono::system_clock::to_time_t( std::chrono::system_clock::now());
+        std::tm tm_now{};
+        gmtime_r( &now, &tm_now);
+        std::ostringstream name;
+        name << _prefix << std::put_time( &tm_now, "%Y_%m_%d_%H_%M_%S") << "_" << _files << ".sigmf-data";
+        return name.str();
+    }
+
+    void process( const SampleBlockPtr<T> &input) override {
+        if( ! _armed) {
+            if( _recording) stopRecording();
+            _history.clear();
+            _history_samples = 0;
+            if( _ring_ready && ! _recorder.writer().release()) _ring_ready = false;
+            return;
+        }
+        // Ring hier im Verarbeitungsthread anlegen, nicht in der GUI und nicht erst beim Trigger
+        if( ! _recording && _samp_rate > 0 && _ring_pending.exchange( false))
+            resizeRing();
+        const uint64_t requests = _trigger_requests;
+        const bool triggered = requests != _triggers_handled;
+        _triggers_handled = requests;
+
+        if( _recording) {
+            if( triggered)
+                _record_until = input->index() + seconds( _post_trigger);
+            _recorder.write( input);
+            if( input->index() + input->size() >= _record_until)
+                stopRecording();
+            return;
+        }
+
+        // Vorlauf: Bloecke halten, bis pre_trigger Sekunden erreicht sind
+        _history.push_back( input);
+        _history_samples += input->size();
+        const uint64_t keep = seconds( _pre_trigger);
+        while( _history.size() > 1 && _history_samples - _history.front()->size() >= keep) {
+            _history_samples -= _history.front()->size();
+            _history.pop_front();
+        }
+        if( ! triggered) return;
+
+        if( startRecording()) {
+            for( const SampleBlockPtr<T> &block : _history)
+                _recorder.write( block);
+            _record_until = input->index() + input->size() + seconds( _post_trigger);
+        }
+        _history.clear();
+        _history_samples = 0;
+    }
+
+    /// @brief der Ring des FileWriter muss den ganzen Vorlauf auf einmal aufnehmen und
+    ///        daneben den laufenden Strom puffern, bis der Vorlauf geschrieben ist: doppelter
+    ///        Vorlauf. Scharf geschaltet vorab angelegt, damit ein Trigger nur noch die Datei
+    ///        oeffnet; nur im Verarbeitungsthread, nicht waehrend einer Aufnahme.
+    void resizeRing() {
+        const uint64_t history_bytes = ( seconds( _pre_trigger) + 1) * sizeof( T);
+        _recorder.writer().setBufferSize( 2 * history_bytes);
+        _ring_ready = ! _recorder.writer().reserve();
+    }
+
+    /// @return false, wenn die Datei nicht angelegt werden konnte (siehe getError())
+    bool startRecording() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _meta.samp_rate = _samp_rate;
+        _last_path = nextPath();
+        if( _recorder.open( _last_path, false, _meta)) return false;
+        _recording = true;
+        ++_files;
+        return true;
+    }
+
+    void stopRecording() {
+        _recorder.close();
+        _recording = false;
+    }
+
+public:
+    /// @param prefix Verzeichnis (mit '/') und Namensanfang der Dateien
+    /// @param pre_trigger Vorlauf [s], post_trigger Nachlauf nach dem letzten Trigger [s]
+    TriggeredRecorder( const std::string &prefix = "", double pre_trigger = 5., double post_trigger = 5.)
+        : BasicProcessor<SampleBlockPtr<T>>( 1024, ProcessorNode::Overflow::DropNewest),
+          _prefix( prefix), _samp_rate( 0), _pre_trigger( pre_trigger), _post_trigger( post_trigger), _armed( true),
+          _trigger_requests( 0), _triggers_handled( 0), _history_samples( 0), _recording( false),
+          _record_until( 0), _files( 0), _ring_ready( false), _ring_pending( true) {
+        if constexpr( std::is_same_v<T, std::complex<float>>)
+            _recorder.setFormat( RecordFormat::CF32);
+        // bis zur Abtastrate nur die Mindestgroesse, nicht die 256 MiB des FileWriter
+        _recorder.writer().setBufferSize( 2 * sizeof( T));
+    }
+    ~TriggeredRecorder() {
+        this->stop();
+        _recorder.close();
+    }
+
+    /// @brief Abtastrate und Mittenfrequenz, gelten ab der naechsten Datei
+    void setSampleRate( double samp_rate) {
+        _samp_rate = samp_rate;
+        _ring_pending = true;
+    }
+    void setCenterFrequency( double center_freq) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _meta.center_freq = center_freq;
+        _recorder.setCenterFrequency( center_freq);
+    }
+    void setPrefix( const std::string &prefix) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _prefix = prefix;
+    }
+    void setPreTrigger( double secs) {
+        _pre_trigger = secs;
+        _ring_pending = true;
+    }
+    void setPostTrigger( double secs) { _post_trigger = secs;}
+
+    /// @brief false: kein Vorlauf, Trigger werden verworfen, eine laufende Aufnahme endet und
+    ///        der Ring wird freigegeben; true legt ihn mit dem naechsten Block neu an
+    void setArmed( bool armed) {
+        if( armed && ! _armed) _ring_pending = true;
+        _armed = armed;
+    }
+    bool isArmed() const { return _armed;}
+
+    /// @brief startet bzw. verlaengert die Aufnahme, aus jedem Thread
+    void trigger() {
+        if( _armed) ++_trigger_requests;
+    }
+
+    /// @brief siehe Recorder::annotate(), nur waehrend einer Aufnahme
+    bool annotate( uint64_t global_start, uint64_t sample_count, double freq_lower, double freq_upper,
+                   const std::string &label, const std::string &comment = "") {
+        return _recorder.annotate( global_start, sample_count, freq_lower, freq_upper, label, comment);
+    }
+
+    bool isRecording() const { return _recorder.isRecording();}
+    uint64_t getFileCount() const { return _files;}
+    std::string getLastPath() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return _last_path;
+    }
+    std::string getError() { return _recorder.getError();}
+
+    /// @brief Format (nur T = complex<int16_t>: SC16 oder SC8), O_DIRECT; die Groesse des
+    ///        Rings folgt aus Vorlauf und Abtastrate und wird nur scharf geschaltet belegt
+    Recorder& recorder() { return _recorder;}
+};
+
+#endif // TRIGGERRECORDER_HPP
@@ -0,0 +1,558 @@
+#ifndef UDPSENDER_HPP
+#define UDPSENDER_HPP
+
+#include <string>
+#include <vector>
+#include <complex>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <endian.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "vrt.hpp"
+#include "sampleencoder.hpp"
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103     // linux/udp.h, ab Linux 4.18
+#endif
+
+
+/// @brief Format der Abtastwerte hinter dem Kopf
+enum class UdpSampleFormat : uint8_t {
+    Raw      = 0,   // Bytes ohne Deutung
+    CF32     = 1,   // complex<float>
+    SC16     = 2,   // complex<int16_t>
+    SC8      = 3,   // complex<int8_t>
+    SC8Bfp   = 4,   // SampleEncoding::SC8Bfp, ein Exponent je Datagramm
+    Lossless = 5    // SampleEncoding::Lossless, je Datagramm eine Einheit
+};
+
+/// @brief Paketformat auf der Leitung
+enum class UdpProtocol {
+    Mouse,      // UdpHeader + Abtastwerte, Little Endian
+    Vrt         // VITA-49.0 Signal Data + Context, Big Endian
+};
+
+template <typename T>
+constexpr UdpSampleFormat udpFormatOf() {
+    if constexpr( std::is_same_v<T, std::complex<float>>) return UdpSampleFormat::CF32;
+    else if constexpr( std::is_same_v<T, std::complex<int16_t>>) return UdpSampleFormat::SC16;
+    else if constexpr( std::is_same_v<T, std::complex<int8_t>>) return UdpSampleFormat::SC8;
+    else return UdpSampleFormat::Raw;
+}
+
+
+/// @brief Kopf vor jedem Datagramm, 24 Byte, Little Endian wie die Abtastwerte:
+///        0 magic "MO" (0x4f4d) | 2 version | 3 format | 4 sequence (u32, laeuft ueber)
+///        8 sample_index (u64, Stromposition des ersten Werts) | 16 timestamp_ns (u64, UTC)
+///        Der Empfaenger erkennt Verluste und Vertauschungen an sequence, die Lage im
+///        Strom an sample_index.
+struct UdpHeader {
+    static constexpr uint16_t magic = 0x4f4d;
+    static constexpr uint8_t version = 1;
+    static constexpr uint64_t size = 24;
+
+    UdpSampleFormat format = UdpSampleFormat::Raw;
+    uint32_t sequence = 0;
+    uint64_t sample_index = 0;
+    uint64_t timestamp_ns = 0;
+
+    void encode( uint8_t *out) const {
+        const uint16_t mag = htole16( magic);
+        const uint32_t seq = htole32( sequence);
+        const uint64_t idx = htole64( sample_index);
+        const uint64_t stamp = htole64( timestamp_ns);
+        std::memcpy( out, &mag, 2);
+        out[ 2] = version;
+        out[ 3] = static_cast<uint8_t>( format);
+        std::memcpy( out + 4, &seq, 4);
+        std::memcpy( out + 8, &idx, 8);
+        std::memcpy( out + 16, &stamp, 8);
+    }
+
+    /// @return false: zu kurz, falsches magic oder unbekannte Version
+    static bool decode( const uint8_t *in, uint64_t leng, UdpHeader &hdr) {
+        if( leng < size) return false;
+        uint16_t mag;
+        uint32_t seq;
+        uint64_t idx, stamp;
+        std::memcpy( &mag, in, 2);
+        std::memcpy( &seq, in + 4, 4);
+        std::memcpy( &idx, in + 8, 8);
+        std::memcpy( &stamp, in + 16, 8);
+        if( le16toh( mag) != magic || in[ 2] != version) return false;
+        hdr.format = static_cast<UdpSampleFormat>( in[ 3]);
+        hdr.sequence = le32toh( seq);
+        hdr.sample_index = le64toh( idx);
+        hdr.timestamp_ns = le64toh( stamp);
+        return true;
+    }
+};
+
+
+// Der eigentlche UDP Verbindungsvorgang wird OHNE Qt gemacht, die GUI-Klasse steht in udpsink.hpp
+//
+/// @brief schneidet Bloecke in Datagramme (Kopf + ganze Abtastwerte, passend zur MTU) und
+///        sendet sie gebuendelt mit sendmmsg(), wo moeglich als UDP GSO: ein Aufruf
+///        uebergibt bis zu 64 KiB, der Kernel bzw. die Netzwerkkarte zerlegt. Kopf und
+///        Nutzdaten gehen als getrennte iovec hinaus, die Abtastwerte werden nicht kopiert.
+///        Optional wird auf eine Datenrate gedrosselt (Empfaenger und Switches ohne
+///        grosse Puffer). Mit UdpProtocol::Vrt gehen statt des eigenen Kopfs VITA-49
+///        Pakete hinaus (siehe vrt.hpp). setEncoding() kodiert cf32- und sc16-Bloecke
+///        vor dem Senden um (sampleencoder.hpp), jedes Datagramm bleibt einzeln dekodierbar.
+class UDPSender {
+    struct sockaddr_in _dest_addr{};
+    int _sockfd;
+
+    uint64_t _mtu;                  // IP-Paket inkl. 28 Byte IP/UDP
+    uint64_t _batch;                // Nachrichten je sendmmsg()
+    std::atomic_bool _gso;          // transmit() schaltet bei Fehlern ab, getStatistics() liest
+    double _rate;                   // [Byte/s], 0: ungedrosselt
+    double _samp_rate;              // [Sps], fuer die Zeitstempel innerhalb eines Blocks
+    std::chrono::steady_clock::time_point _next_send;
+    uint32_t _sequence;
+
+    UdpProtocol _protocol;
+    Vrt::Encoder _vrt;
+    Vrt::Context _context;          // unter _mutexer
+    std::atomic_bool _context_pending;
+    bool _context_changed;
+    uint64_t _next_context;         // Stromposition des naechsten wiederholten Context-Pakets
+
+    std::optional<SampleEncoding> _encoding;    // leer: Bloecke gehen unveraendert hinaus
+    SampleCodec::Encoder _encoder;
+    std::vector<uint8_t> _encoded;
+    std::vector<uint64_t> _offsets;
+
+    // wiederverwendet, kein new je Block
+    std::vector<uint8_t> _headers;
+    std::vector<struct iovec> _iovs;
+    std::vector<struct mmsghdr> _msgs;
+    std::vector<uint8_t> _cmsgs;
+
+    std::atomic<uint64_t> _packets, _bytes, _syscalls, _errors;
+    std::atomic<uint64_t> _samples, _payload;   // Abtastwerte, ihre Bytes auf der Leitung
+    std::mutex _mutexer;
+    std::string _error;
+
+    static constexpr uint64_t ip_udp_header = 28;
+    static constexpr uint64_t max_gso_bytes = 65507;
+    static constexpr uint64_t max_gso_segments = 64;
+
+    /// @brief wartet, bis bytes bei _rate gesendet werden duerfen
+    void pace( uint64_t bytes) {
+        if( _rate <= 0.) return;
+        using clock = std::chrono::steady_clock;
+        const clock::time_point now = clock::now();
+        // nach einer Pause nicht aufholen
+        if( _next_send < now - std::chrono::milliseconds( 10)) _next_send = now;
+        if( _next_send > now) std::this_thread::sleep_until( _next_send);
+        _next_send += std::chrono::duration_cast<clock::duration>(
+                          std::chrono::duration<double>( static_cast<double>( bytes) / _rate));
+    }
+
+    void account( uint64_t samples, uint64_t payload) {
+        _samples += samples;
+        _payload += payload;
+    }
+
+    /// @brief sendet npackets Datagramme: Kopf p liegt in _headers ab p * header_size, die
+    ///        Nutzlast ist zusammenhaengend und wird alle payload_per_packet Byte geteilt,
+    ///        mit offsets (npackets + 1 Eintraege) an beliebigen Stellen - dann ohne GSO
+    int transmit( uint64_t npackets, uint64_t header_size, const uint8_t *payload,
+                  uint64_t payload_per_packet, uint64_t payload_total, const uint64_t *offsets = nullptr) {
+        const uint16_t segment = static_cast<uint16_t>( header_size + payload_per_packet);
+        int ret = 0;
+        uint64_t packet = 0;
+        while( packet < npackets) {
+            // GSO: mehrere Datagramme gleicher Groesse je Nachricht, nur das letzte darf kuerzer sein
+            const uint64_t per_msg = _gso && ! offsets ? std::max<uint64_t>( 1, std::min( max_gso_segments, max_gso_bytes / segment)) : 1;
+            const uint64_t nmsgs = std::min( _batch, ( npackets - packet + per_msg - 1) / per_msg);
+            const uint64_t cmsg_space = CMSG_SPACE( sizeof( uint16_t));
+            _iovs.resize( 2 * nmsgs * per_msg);
+            _msgs.assign( nmsgs, mmsghdr{});
+            _cmsgs.assign( nmsgs * cmsg_space, 0);
+
+            uint64_t p = packet, iov = 0, batch_bytes = 0;
+            for( uint64_t m = 0; m < nmsgs; ++m) {
+                const uint64_t first_iov = iov;
+                const uint64_t last = std::min( npackets, p + per_msg);
+                for( ; p < last; ++p) {
+                    const uint64_t offset = offsets ? offsets[ p] : p * payload_per_packet;
+                    const uint64_t count = offsets ? offsets[ p + 1] - offset
+                                                   : std::min( payload_per_packet, payload_total - offset);
+                    _iovs[ iov++] = { &_headers[ p * header_size], header_size};
+                    _iovs[ iov++] = { const_cast<uint8_t*>( payload + offset), count};
+                    batch_bytes += header_size + count + ip_udp_header;
+                }
+                struct msghdr &msg = _msgs[ m].msg_hdr;
+                msg.msg_iov = &_iovs[ first_iov];
+                msg.msg_iovlen = iov - first_iov;
+                if( _gso && iov - first_iov > 2) {
+                    msg.msg_control = &_cmsgs[ m * cmsg_space];
+                    msg.msg_controllen = cmsg_space;
+                    struct cmsghdr *cmsg = CMSG_FIRSTHDR( &msg);
+                    cmsg->cmsg_level = SOL_UDP;
+                    cmsg->cmsg_type = UDP_SEGMENT;
+                    cmsg->cmsg_len = CMSG_LEN( sizeof( uint16_t));
+                    std::memcpy( CMSG_DATA( cmsg), &segment, sizeof( segment));
+                }
+            }
+
+            pace( batch_bytes);
+            uint64_t sent_msgs = 0;
+            while( sent_msgs < nmsgs) {
+                const int res = sendmmsg( _sockfd, &_msgs[ sent_msgs], static_cast<unsigned>( nmsgs - sent_msgs), 0);
+                ++_syscalls;
+                if( res > 0) {
+                    for( int m = 0; m < res; ++m) {
+                        const struct msghdr &msg = _msgs[ sent_msgs + m].msg_hdr;
+                        _packets += msg.msg_iovlen / 2;
+                        _bytes += _msgs[ sent_msgs + m].msg_len;
+                    }
+                    sent_msgs += res;
+                    continue;
+                }
+                if( errno == EINTR) continue;
+                if( _gso && ( errno == EIO || errno == EINVAL || errno == ENOPROTOOPT || errno == EOPNOTSUPP)) {
+                    // Karte oder Treiber ohne GSO: ab hier einzelne Datagramme
+                    _gso = false;
+                    break;
+                }
+                // z.B. ECONNREFUSED (kein Empfaenger) oder EMSGSIZE (MTU zu gross): Nachricht verwerfen
+                ++_errors;
+                {
+                    const std::string error = std::string( "FEHLER UDPSender::sendData(): ") + std::strerror( errno);
+                    std::lock_guard<std::mutex> lock( _mutexer);
+                    _error = error;
+                }
+                ret = -1;
+                ++sent_msgs;
+            }
+            // weiter hinter der letzten vollstaendig behandelten Nachricht
+            for( uint64_t m = 0; m < sent_msgs; ++m)
+                packet += _msgs[ m].msg_hdr.msg_iovlen / 2;
+        }
+        return ret;
+    }
+
+    /// @brief VITA-49: bei Bedarf zuerst ein Context-Paket, dann Signal-Data-Pakete
+    template< typename T>
+    int sendVrt( const T *input, uint64_t leng, uint64_t sample_index,
+                 std::chrono::system_clock::time_point stamp) {
+        if( ! _vrt.hasTimeReference()) {
+            _vrt.setSampleRate( _samp_rate);
+            _vrt.setTimeReference( sample_index, stamp);
+        }
+        int ret = 0;
+        const bool periodic = _samp_rate > 0. && sample_index >= _next_context;
+        if( _context_pending || periodic) {
+            Vrt::Context ctx;
+            bool changed;
+            {
+                std::lock_guard<std::mutex> lock( _mutexer);
+                ctx = _context;
+                changed = _context_changed;
+                _context_pending = _context_changed = false;
+            }
+            if( ctx.samp_rate <= 0.) ctx.samp_rate = _samp_rate;
+            _headers.resize( Vrt::Encoder::context_size);
+            _vrt.encodeContext<T>( _headers.data(), ctx, changed, sample_index);
+            ret = transmit( 1, Vrt::Encoder::context_size, nullptr, 0, 0);
+            _next_context = sample_index + static_cast<uint64_t>( _samp_rate);
+        }
+
+        const uint64_t per_packet = samplesPerPacket<T>();
+        const uint64_t npackets = ( leng + per_packet - 1) / per_packet;
+        _headers.resize( npackets * Vrt::Encoder::data_header_size);
+        for( uint64_t p = 0; p < npackets; ++p) {
+            const uint64_t offset = p * per_packet;
+            _vrt.encodeDataHeader<T>( &_headers[ p * Vrt::Encoder::data_header_size],
+                                      std::min( per_packet, leng - offset), sample_index + offset);
+        }
+        const uint8_t *payload = _vrt.payload( input, leng);
+        account( leng, leng * sizeof( T));
+        return transmit( npackets, Vrt::Encoder::data_header_size, payload, per_packet * sizeof( T),
+                         leng * sizeof( T)) ? -1 : ret;
+    }
+
+    /// @brief eigener Kopf, Nutzlast je Datagramm fuer sich kodiert; Lossless ergibt
+    ///        Datagramme unterschiedlicher Laenge (ohne GSO)
+    template< typename T>
+    int sendEncoded( const T *input, uint64_t leng, uint64_t sample_index, uint64_t stamp_ns) {
+        const SampleEncoding encoding = *_encoding;
+        const uint64_t per_packet = std::max<uint64_t>(
+            1, SampleCodec::maxSamples( encoding, _mtu - ip_udp_header - UdpHeader::size));
+        const uint64_t npackets = ( leng + per_packet - 1) / per_packet;
+        const uint64_t max_packet = SampleCodec::maxBytes( encoding, per_packet, per_packet);
+        _encoder.setEncoding( encoding);
+        _encoder.setBfpBlock( per_packet);
+        _encoded.resize( npackets * max_packet);
+        _offsets.resize( npackets + 1);
+        _headers.resize( npackets * UdpHeader::size);
+        UdpHeader hdr;
+        hdr.format = static_cast<UdpSampleFormat>( encoding);
+        uint64_t pos = 0;
+        for( uint64_t p = 0; p < npackets; ++p) {
+            const uint64_t offset = p * per_packet;
+            _offsets[ p] = pos;
+            pos += _encoder.encode( input + offset, std::min( per_packet, leng - offset), _encoded.data() + pos);
+            hdr.sequence = _sequence++;
+            hdr.sample_index = sample_index + offset;
+            hdr.timestamp_ns = stamp_ns + ( _samp_rate > 0.
+                                            ? static_cast<uint64_t>( 1e9 * static_cast<double>( offset) / _samp_rate) : 0);
+            hdr.encode( &_headers[ p * UdpHeader::size]);
+        }
+        _offsets[ npackets] = pos;
+        account( leng, pos);
+        // feste Laenge je vollem Datagramm: gleichmaessig geteilt, GSO moeglich
+        if( encoding != SampleEncoding::Lossless)
+            return transmit( npackets, UdpHeader::size, _encoded.data(), max_packet, pos);
+        return transmit( npackets, UdpHeader::size, _encoded.data(), 0, pos, _offsets.data());
+    }
+
+public:
+    UDPSender( std::string ip, uint16_t port)
+        : _mtu( 1500), _batch( 64), _gso( false), _rate( 0), _samp_rate( 0), _sequence( 0),
+          _protocol( UdpProtocol::Mouse), _context_pending( true), _context_changed( false), _next_context( 0),
+          _packets( 0), _bytes( 0), _syscalls( 0), _errors( 0), _samples( 0), _payload( 0) {
+		// setzte ip:port und validiere
+		_dest_addr.sin_family = AF_INET;
+		_dest_addr.sin_port = htons(port);
+		if ( inet_pton( AF_INET, ip.c_str(), &_dest_addr.sin_addr) <= 0) {
+			throw std::invalid_argument("FEHLER UDPSender: ungueltige Adresse " + ip);
+		}
+
+		// socket erstellen
+        if( 0 > (_sockfd = socket( AF_INET, SOCK_DGRAM, 0))) {
+			throw std::runtime_error("FEHLER kann socket nicht erstellen ");
+		}
+
+		// verbindung herstellen
+		if( connect( _sockfd, (struct sockaddr *)&_dest_addr, sizeof( _dest_addr)) < 0) {
+            ::close( _sockfd);
+			throw std::runtime_error("FEHLER UDP::connect");
+		}
+
+        // nicht fragmentieren: eine zu grosse MTU faellt als EMSGSIZE auf, statt still
+        // in IP-Fragmenten zu enden
+        int pmtu = IP_PMTUDISC_DO;
+        setsockopt( _sockfd, IPPROTO_IP, IP_MTU_DISCOVER, &pmtu, sizeof( pmtu));
+        setSendBuffer( 4 << 20);
+        // Multicast: nur im lokalen Netz, Empfaenger auf demselben Rechner erlaubt
+        if( isMulticast()) {
+            setMulticastTtl( 1);
+            int loop = 1;
+            setsockopt( _sockfd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof( loop));
+        }
+        // GSO vorhanden, wenn der Kernel die Option kennt
+        int segment = 0;
+        socklen_t optlen = sizeof( segment);
+        _gso = ! getsockopt( _sockfd, SOL_UDP, UDP_SEGMENT, &segment, &optlen);
+    }
+    UDPSender( const UDPSender &) = delete;
+    UDPSender& operator =( const UDPSender &) = delete;
+
+	~UDPSender() {
+        ::close(_sockfd);
+	}
+
+    /// @brief Ziel ist eine Multicast-Gruppe (224.0.0.0/4): beliebig viele Empfaenger treten
+    ///        der Gruppe bei, gesendet wird der Strom nur einmal
+    bool isMulticast() const { return IN_MULTICAST( ntohl( _dest_addr.sin_addr.s_addr));}
+
+    /// @brief Reichweite der Multicast-Pakete in Routern, 1: nur das lokale Netz
+    void setMulticastTtl( int ttl) {
+        if( setsockopt( _sockfd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof( ttl)) < 0)
+            throw std::runtime_error( "FEHLER UDPSender::setMulticastTtl(): " + std::string( std::strerror( errno)));
+    }
+    /// @brief Schnittstelle (deren IPv4-Adresse), ueber die die Gruppe bedient wird
+    void setMulticastInterface( const std::string &ip) {
+        struct in_addr addr{};
+        if( inet_pton( AF_INET, ip.c_str(), &addr) <= 0)
+            throw std::invalid_argument( "FEHLER UDPSender: ungueltige Schnittstelle " + ip);
+        if( setsockopt( _sockfd, IPPROTO_IP, IP_MULTICAST_IF, &addr, sizeof( addr)) < 0)
+            throw std::runtime_error( "FEHLER UDPSender::setMulticastInterface(): " + std::string( std::strerror( errno)));
+    }
+
+    /// @brief IP-MTU der Strecke, 1500 (Ethernet) bis 9000 (Jumbo-Frames) oder mehr
+    void setMtu( uint64_t mtu) {
+        if( mtu < ip_udp_header + UdpHeader::size + 8 || mtu > 65535)
+            throw std::invalid_argument( "FEHLER UDPSender::setMtu(): " + std::to_string( mtu));
+        _mtu = mtu;
+    }
+    uint64_t getMtu() const { return _mtu;}
+
+    /// @brief Datenrate auf der Leitung (Kopf + Nutzdaten) [Byte/s], 0: ungedrosselt.
+    ///        Gedrosselt wird je sendmmsg(); zusaetzlich wird SO_MAX_PACING_RATE gesetzt,
+    ///        mit fq als qdisc glaettet der Kernel dann auch innerhalb der Buendel.
+    void setRate( double bytes_per_sec) {
+        _rate = std::max( 0., bytes_per_sec);
+        _next_send = std::chrono::steady_clock::now();
+        const uint64_t rate = _rate > 0. ? static_cast<uint64_t>( _rate) : ~uint64_t( 0);
+        setsockopt( _sockfd, SOL_SOCKET, SO_MAX_PACING_RATE, &rate, sizeof( rate));
+    }
+    double getRate() const { return _rate;}
+
+    /// @brief Zeitstempel der Datagramme hinter dem ersten eines Blocks aus sample_index
+    void setSampleRate( double samp_rate) {
+        _samp_rate = samp_rate;
+        _vrt.setSampleRate( samp_rate);
+    }
+
+    /// @brief Nachrichten je sendmmsg() (1: ein Systemaufruf je Datagramm bzw. GSO-Buendel)
+    void setBatch( uint64_t batch) { _batch = std::clamp<uint64_t>( batch, 1, 1024);}
+    /// @brief false: kein UDP GSO, z.B. fuer Empfaenger hinter Geraeten, die es verschlucken
+    void setGso( bool gso) {
+        int segment = 0;
+        socklen_t optlen = sizeof( segment);
+        _gso = gso && ! getsockopt( _sockfd, SOL_UDP, UDP_SEGMENT, &segment, &optlen);
+    }
+    bool isGso() const { return _gso;}
+
+    /// @return tatsaechliche Groesse des Sendepuffers
+    int setSendBuffer( int bytes) {
+        setsockopt( _sockfd, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof( bytes));
+        int actual = 0;
+        socklen_t optlen = sizeof( actual);
+        getsockopt( _sockfd, SOL_SOCKET, SO_SNDBUF, &actual, &optlen);
+        return actual;
+    }
+
+    /// @brief Abtastwerte je Datagramm bei der eingestellten MTU und dem Protokoll
+    template< typename T>
+    uint64_t samplesPerPacket() const {
+        if( _protocol == UdpProtocol::Vrt) {
+            const uint64_t payload = std::min( Vrt::Encoder::max_payload,
+                                               _mtu - ip_udp_header - Vrt::Encoder::data_header_size);
+            return std::max<uint64_t>( 1, payload / sizeof( T));
+        }
+        return std::max<uint64_t>( 1, ( _mtu - ip_udp_header - UdpHeader::size) / sizeof( T));
+    }
+
+    /// @brief Paketformat: eigener 24-Byte-Kopf oder VITA-49 (VRT)
+    void setProtocol( UdpProtocol protocol) {
+        _protocol = protocol;
+        _context_pending = true;
+    }
+    UdpProtocol getProtocol() const { return _protocol;}
+
+    /// @brief Kodierung der cf32- und sc16-Bloecke auf der Leitung (z.B. cf32 als SC8Bfp
+    ///        bei einem Viertel der Bytes), std::nullopt: unveraendert. Mit VRT sind nur CF32
+    ///        und SC16 moeglich, die uebrigen Kodierungen gehen dort unveraendert hinaus.
+    ///        Gilt ab dem naechsten Block.
+    void setEncoding( std::optional<SampleEncoding> encoding) {
+        _encoding = encoding;
+        _context_pending = true;
+    }
+    std::optional<SampleEncoding> getEncoding() const { return _encoding;}
+
+    /// @brief VRT: Stream ID der Signal-Data- und Context-Pakete
+    void setStreamId( uint32_t stream_id) { _vrt.setStreamId( stream_id);}
+
+    /// @brief VRT: Abtastrate, Mittenfrequenz und Bandbreite; eine Aenderung geht vor dem
+    ///        naechsten Block als Context-Paket mit gesetztem Change Indicator hinaus, sonst
+    ///        wird der Context einmal je Sekunde im Strom wiederholt (spaet startende Empfaenger)
+    void setContext( const Vrt::Context &ctx) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _context = ctx;
+        _context_pending = true;
+        _context_changed = true;
+    }
+
+    /// @brief zerlegt die Daten in Datagramme mit Kopf und ganzen Abtastwerten, das letzte
+    ///        ist kuerzer. Sequenznummern zaehlen ueber Bloecke hinweg, ein verworfenes
+    ///        Datagramm hinterlaesst eine Luecke.
+    /// @param sample_index Stromposition von input[ 0] (SampleBlock::index())
+    /// @return 0: alles gesendet, -1: Datagramme verloren (siehe getError())
+	template< typename T>
+    int sendData( const T *input, uint64_t leng, uint64_t sample_index = 0,
+                  std::chrono::system_clock::time_point stamp = std::chrono::system_clock::now()) {
+        if( ! leng) return 0;
+        const uint64_t stamp_ns = static_cast<uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                             stamp.time_since_epoch()).count());
+        if constexpr( std::is_same_v<T, std::complex<float>> || std::is_same_v<T, std::complex<int16_t>>) {
+            const SampleEncoding native = std::is_same_v<T, std::complex<float>> ? SampleEncoding::CF32
+                                                                                 : SampleEncoding::SC16;
+            const std::optional<SampleEncoding> encoding = _encoding;
+            if( encoding && *encoding != native) {
+                if( _protocol == UdpProtocol::Mouse)
+                    return sendEncoded( input, leng, sample_index, stamp_ns);
+                // VRT: als Festkomma bzw. Gleitkomma neu gewandelt
+                _encoder.setEncoding( *encoding);
+                if( *encoding == SampleEncoding::SC16) {
+                    _encoder.encode( input, leng, _encoded);
+                    return sendVrt( reinterpret_cast<const std::complex<int16_t>*>( _encoded.data()), leng, sample_index, stamp);
+                }
+                if( *encoding == SampleEncoding::CF32) {
+                    _encoder.encode( input, leng, _encoded);
+                    return sendVrt( reinterpret_cast<const std::complex<float>*>( _encoded.data()), leng, sample_index, stamp);
+                }
+            }
+        }
+        if( _protocol == UdpProtocol::Vrt)
+            return sendVrt( input, leng, sample_index, stamp);
+
+        const uint64_t per_packet = samplesPerPacket<T>();
+        const uint64_t npackets = ( leng + per_packet - 1) / per_packet;
+        _headers.resize( npackets * UdpHeader::size);
+        UdpHeader hdr;
+        hdr.format = udpFormatOf<T>();
+        for( uint64_t p = 0; p < npackets; ++p) {
+            const uint64_t offset = p * per_packet;
+            hdr.sequence = _sequence++;
+            hdr.sample_index = sample_index + offset;
+            hdr.timestamp_ns = stamp_ns + ( _samp_rate > 0.
+                                            ? static_cast<uint64_t>( 1e9 * static_cast<double>( offset) / _samp_rate) : 0);
+            hdr.encode( &_headers[ p * UdpHeader::size]);
+        }
+        account( leng, leng * sizeof( T));
+        return transmit( npackets, UdpHeader::size, reinterpret_cast<const uint8_t*>( input),
+                         per_packet * sizeof( T), leng * sizeof( T));
+	}
+	template< typename T>
+    int sendData( const std::vector<T> &input, uint64_t sample_index = 0) {
+        return sendData( input.data(), input.size(), sample_index);
+	}
+
+    struct Statistics {
+        uint64_t packets;       // Datagramme
+        uint64_t bytes;         // UDP-Nutzlast inkl. Kopf
+        uint64_t syscalls;      // sendmmsg()
+        uint64_t errors;        // verworfene Nachrichten
+        bool gso;
+        uint64_t samples;       // uebergebene Abtastwerte
+        uint64_t payload;       // ihre Bytes nach der Kodierung, ohne Koepfe
+        /// @brief cf32-Bytes je Byte Nutzlast (CF32: 1, SC16: 2, SC8Bfp: knapp 4)
+        double ratio() const {
+            return payload ? 8. * static_cast<double>( samples) / static_cast<double>( payload) : 0.;
+        }
+    };
+    Statistics getStatistics() const {
+        return { _packets.load(), _bytes.load(), _syscalls.load(), _errors.load(), _gso,
+                 _samples.load(), _payload.load()};
+    }
+    std::string getError() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return _error;
+    }
+};
+
+#endif // UDPSENDER_HPP
@@ -0,0 +1,444 @@
+#ifndef UDPSERVER_HPP
+#define UDPSERVER_HPP
+
+#include <string>
+#include <vector>
+#include <complex>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+#include <optional>
+#include <cmath>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "sampleblock.hpp"
+#include "baseprocessor.hpp"
+#include "udpsender.hpp"
+#include "ddc.hpp"
+
+
+/// @brief UDP-Streaming-Server am cf32-Ausgang der Quelle: der volle Strom geht einmal an
+///        eine (Multicast-)Gruppe, daneben bekommt jeder Abonnent nur sein Band - mit
+///        eigenem Ddc gemischt, gefiltert und dezimiert - als eigenen Strom. Abonnenten
+///        entstehen ueber die API (z.B. je Carrier der CarrierDetection) oder ueber den
+///        Steuerport (Text per UDP, eine Zeile je Datagramm):
+///          [AUTH <token>] SUBSCRIBE <freq_hz> <bandwidth_hz> [port]  -> OK <id> <samp_rate> <decimation>
+///          [AUTH <token>] UNSUBSCRIBE <id>                            -> OK
+///          [AUTH <token>] LIST                                        -> SUB <id> <ip>:<port> <freq> <bw> <rate>...
+///        Gesendet wird nur an die Absenderadresse (bzw. deren port ab 1024). Abos ueber den
+///        Steuerport verfallen nach lease Sekunden, ein erneutes SUBSCRIBE verlaengert sie;
+///        UNSUBSCRIBE und LIST sehen nur die Abos des eigenen Absenders (ip:port). Anfragen
+///        ohne gueltiges Token bzw. von Adressen ausserhalb der Freigabeliste bleiben ohne
+///        Antwort, damit der Port nicht als Reflektor taugt. Anzahl und Summenrate der Abos
+///        sind begrenzt (setLimits()).
+class UdpStreamServer : public BaseProcessor {
+public:
+    struct Subscription {
+        uint32_t id;
+        std::string ip;
+        uint16_t port;
+        double freq;            // [Hz], absolut
+        double bandwidth;       // [Hz], angefordert
+        double samp_rate;       // [Sps] des Teilstroms
+        uint64_t decimation;
+    };
+
+private:
+    struct Subscriber {
+        Subscription info;
+        std::unique_ptr<UDPSender> sender;
+        Ddc ddc;
+        std::vector<std::complex<float>> buf;
+        uint64_t generation = ~uint64_t( 0);    // Stand der Mittenfrequenz im Ddc
+        uint64_t expected_index = 0;            // Stromposition des naechsten Eingangsblocks
+        uint64_t out_index = 0;                 // Stromposition im dezimierten Teilstrom
+        bool started = false;
+        bool leased = false;
+        std::chrono::steady_clock::time_point expires;
+        std::string owner;                      // ip:port am Steuerport, leer: ueber die API
+    };
+
+    std::mutex _mutexer;
+    std::vector<std::shared_ptr<Subscriber>> _subscribers;
+    std::shared_ptr<UDPSender> _wideband;
+    uint32_t _next_id;
+
+    // Vorgaben fuer neue Teilstroeme, Zugang und Grenzen: unter _mutexer, die Setter
+    // duerfen jederzeit laufen, Steuerthread und addSubscriber() lesen mit
+    uint64_t _mtu;
+    UdpProtocol _protocol;
+    std::optional<SampleEncoding> _encoding;
+    double _lease;              // [s]
+
+    // Zugang und Grenzen des Steuerports
+    std::string _token;
+    std::vector<std::string> _allowed;
+    uint64_t _max_subscribers;
+    double _max_rate;           // [Sps], Summe der Teilstroeme, 0: Abtastrate der Quelle
+
+    std::atomic<double> _samp_rate, _center_freq;
+    std::atomic<uint64_t> _generation;
+
+    int _control_fd;
+    std::thread _control;
+    std::atomic_bool _control_running;
+    std::string _error;
+
+    // nur im Verarbeitungsthread
+    std::vector<std::shared_ptr<Subscriber>> _active;
+
+    void process( const SampleBlockPtr<std::complex<float>> &input) override {
+        std::shared_ptr<UDPSender> wideband;
+        {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            const auto now = std::chrono::steady_clock::now();
+            std::erase_if( _subscribers, [ now]( const std::shared_ptr<Subscriber> &sub)
+                           { return sub->leased && sub->expires < now;});
+            _active = _subscribers;
+            wideband = _wideband;
+        }
+        if( wideband)
+            wideband->sendData( input->data(), input->size(), input->index());
+
+        const uint64_t generation = _generation;
+        const double samp_rate = _samp_rate;
+        const double center_freq = _center_freq;
+        // Teilstroeme nacheinander, je eigener Ddc und eigener Socket
+        for( const std::shared_ptr<Subscriber> &sub : _active) {
+            if( sub->generation != generation) {
+                // neue Abtastrate der Quelle: gleiche Dezimation, andere Rate im Teilstrom
+                const double sub_rate = samp_rate / static_cast<double>( sub->info.decimation);
+                if( sub_rate != sub->info.samp_rate) {
+                    sub->sender->setSampleRate( sub_rate);
+                    std::lock_guard<std::mutex> lock( _mutexer);
+                    sub->info.samp_rate = sub_rate;
+                }
+                sub->ddc.setFrequency( ( sub->info.freq - center_freq) / samp_rate);
+                Vrt::Context ctx;
+                ctx.samp_rate = sub->info.samp_rate;
+                ctx.center_freq = sub->info.freq;
+                ctx.bandwidth = sub->info.bandwidth;
+                sub->sender->setContext( ctx);
+                sub->generation = generation;
+            }
+            // Luecke im Eingang: Filter neu beginnen, Stromposition nachziehen
+            const uint64_t decimation = sub->info.decimation;
+            if( ! sub->started || input->index() != sub->expected_index) {
+                sub->ddc.reset();
+                sub->out_index = ( input->index() + decimation - 1) / decimation;
+                sub->started = true;
+            }
+            sub->expected_index = input->index() + input->size();
+            sub->buf.clear();
+            sub->ddc.process( input->data(), input->size(), sub->buf);
+            sub->sender->sendData( sub->buf.data(), sub->buf.size(), sub->out_index);
+            sub->out_index += sub->buf.size();
+        }
+        _active.clear();
+    }
+
+    void controlLoop() {
+        std::vector<char> buf( 1500);
+        while( _control_running) {
+            struct sockaddr_in from{};
+            socklen_t fromlen = sizeof( from);
+            const ssize_t leng = recvfrom( _control_fd, buf.data(), buf.size() - 1, 0,
+                                           reinterpret_cast<struct sockaddr*>( &from), &fromlen);
+            if( leng <= 0) continue;     // Zeitueberschreitung: _control_running pruefen
+            buf[ leng] = '\0';
+            char ip[ INET_ADDRSTRLEN] = {};
+            inet_ntop( AF_INET, &from.sin_addr, ip, sizeof( ip));
+            if( ! admitted( ip)) continue;
+            std::istringstream in( buf.data());
+            std::string token;
+            {
+                std::lock_guard<std::mutex> lock( _mutexer);
+                token = _token;
+            }
+            if( ! token.empty()) {
+                std::string auth, given;
+                in >> auth >> given;
+                if( auth != "AUTH" || ! tokenMatches( given, token)) continue;
+            }
+            const std::string reply = handleCommand( in, ip, ntohs( from.sin_port));
+            sendto( _control_fd, reply.data(), reply.size(), 0,
+                    reinterpret_cast<struct sockaddr*>( &from), fromlen);
+        }
+    }
+
+    bool admitted( const std::string &ip) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return _allowed.empty() || std::find( _allowed.begin(), _allowed.end(), ip) != _allowed.end();
+    }
+
+    /// @brief Vergleich ohne fruehen Abbruch, die Laufzeit verraet keine Praefixe
+    static bool tokenMatches( const std::string &given, const std::string &token) {
+        if( given.size() != token.size()) return false;
+        unsigned char diff = 0;
+        for( uint64_t w = 0; w < given.size(); ++w)
+            diff |= static_cast<unsigned char>( given[ w] ^ token[ w]);
+        return diff == 0;
+    }
+
+    std::string handleCommand( std::istringstream &in, const std::string &ip, uint16_t from_port) {
+        const std::string owner = ip + ":" + std::to_string( from_port);
+        std::string cmd;
+        in >> cmd;
+        std::ostringstream out;
+        try {
+            if( cmd == "SUBSCRIBE") {
+                double freq = 0, bandwidth = 0;
+                uint32_t port = from_port, requested = 0;
+                if( ! ( in >> freq >> bandwidth))
+                    return "ERR SUBSCRIBE <freq_hz> <bandwidth_hz> [port]\n";
+                if( in >> requested) port = requested;
+                if( port < 1024 || port > 65535) return "ERR ungueltiger port\n";
+                double lease;
+                {
+                    std::lock_guard<std::mutex> lock( _mutexer);
+                    lease = _lease;
+                }
+                const Subscription sub = subscribe( owner, ip, static_cast<uint16_t>( port), freq, bandwidth, lease);
+                out << "OK " << sub.id << " " << sub.samp_rate << " " << sub.decimation << "\n";
+            }
+            else if( cmd == "UNSUBSCRIBE") {
+                uint32_t id = 0;
+                in >> id;
+                std::lock_guard<std::mutex> lock( _mutexer);
+                return std::erase_if( _subscribers, [ id, &owner]( const std::shared_ptr<Subscriber> &sub)
+                                      { return sub->info.id == id && sub->owner == owner;}) > 0
+                       ? "OK\n" : "ERR unbekannte id\n";
+            }
+            else if( cmd == "LIST") {
+                std::lock_guard<std::mutex> lock( _mutexer);
+                for( const std::shared_ptr<Subscriber> &sub : _subscribers)
+                    if( sub->owner == owner)
+                        out << "SUB " << sub->info.id << " " << sub->info.ip << ":" << sub->info.port << " "
+                            << sub->info.freq << " " << sub->info.bandwidth << " " << sub->info.samp_rate << "\n";
+                out << "OK\n";
+            }
+            else
+                return "ERR unbekanntes Kommando\n";
+        }
+        catch( const std::exception &e) {
+            return std::string( "ERR ") + e.what() + "\n";
+        }
+        return out.str();
+    }
+
+    /// @brief Abo ueber den Steuerport: gleiches Ziel verlaengert bzw. ersetzt das Abo desselben
+    ///        Absenders; Anzahl und Summenrate aller Abos ueber den Steuerport sind begrenzt
+    Subscription subscribe( const std::string &owner, const std::string &ip, uint16_t port, double freq,
+                            double bandwidth, double lease) {
+        const double samp_rate = _samp_rate;
+        if( samp_rate <= 0. || bandwidth <= 0.)
+            throw std::invalid_argument( "Band ausserhalb des Stroms");
+        {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            const double max_rate = _max_rate > 0. ? _max_rate : samp_rate;
+            uint64_t count = 0;
+            double rate = samp_rate / static_cast<double>( ZoomProcessor::decimationFor( bandwidth / samp_rate));
+            for( const std::shared_ptr<Subscriber> &sub : _subscribers) {
+                if( sub->info.ip == ip && sub->info.port == port) {
+                    if( sub->owner != owner)
+                        throw std::runtime_error( "Ziel belegt");
+                    if( sub->info.freq == freq && sub->info.bandwidth == bandwidth) {
+                        sub->expires = std::chrono::steady_clock::now()
+                                       + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                             std::chrono::duration<double>( lease));
+                        return sub->info;
+                    }
+                    continue;       // wird ersetzt
+                }
+                if( sub->owner.empty()) continue;
+                ++count;
+                rate += sub->info.samp_rate;
+            }
+            if( count >= _max_subscribers)
+                throw std::runtime_error( "zu viele Abos");
+            if( rate > max_rate)
+                throw std::runtime_error( "Summenrate ueberschritten");
+            std::erase_if( _subscribers, [ &]( const std::shared_ptr<Subscriber> &sub)
+                           { return sub->info.ip == ip && sub->info.port == port;});
+        }
+        return addSubscriber( ip, port, freq, bandwidth, lease, owner);
+    }
+
+public:
+    UdpStreamServer()
+        : BaseProcessor( 256, Overflow::DropOldest), _next_id( 1), _mtu( 1500), _protocol( UdpProtocol::Mouse),
+          _lease( 60), _max_subscribers( 8), _max_rate( 0), _samp_rate( 0), _center_freq( 0), _generation( 0), _control_fd( -1),
+          _control_running( false) {}
+    ~UdpStreamServer() {
+        stopControl();
+        stop();
+    }
+
+    /// @brief Abtastrate und Mittenfrequenz der Quelle; Umstimmen verschiebt die Teilstroeme
+    ///        nicht, sie bleiben auf ihrer absoluten Frequenz. Ein Filterwechsel behaelt die
+    ///        Dezimation, die Rate der Teilstroeme aendert sich mit.
+    void setSampleRate( double samp_rate) { _samp_rate = samp_rate; ++_generation;}
+    void setCenterFrequency( double center_freq) { _center_freq = center_freq; ++_generation;}
+
+    /// @brief Vorgaben fuer neue Teilstroeme, bestehende behalten ihre
+    void setMtu( uint64_t mtu) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _mtu = mtu;
+    }
+    void setProtocol( UdpProtocol protocol) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _protocol = protocol;
+    }
+    void setEncoding( std::optional<SampleEncoding> encoding) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _encoding = encoding;
+    }
+    void setLease( double secs) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _lease = secs;
+    }
+
+    /// @brief Zugang zum Steuerport: Anfragen muessen mit "AUTH <token>" beginnen bzw. von
+    ///        einer der Adressen kommen; leer: keine Pruefung. startControl() verlangt ausserhalb
+    ///        von Loopback eins von beiden.
+    void setToken( const std::string &token) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _token = token;
+    }
+    void setAllowed( const std::vector<std::string> &ips) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _allowed = ips;
+    }
+    /// @brief Grenzen fuer Abos ueber den Steuerport
+    /// @param max_rate Summe der Abtastraten aller Teilstroeme [Sps], 0: Abtastrate der Quelle
+    void setLimits( uint64_t max_subscribers, double max_rate) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _max_subscribers = max_subscribers;
+        _max_rate = max_rate;
+    }
+
+    /// @brief voller Strom, typischerweise an eine Multicast-Gruppe; nullptr: keiner
+    void setWideband( std::shared_ptr<UDPSender> sender) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _wideband = std::move( sender);
+    }
+
+    /// @brief neuer Teilstrom um freq (absolut) mit mindestens bandwidth; die Dezimation ist
+    ///        die groesste, deren aliasfreier Teil bandwidth noch ueberdeckt
+    /// @param lease Sekunden bis zum Verfall, 0: bis removeSubscriber()
+    /// @return Beschreibung mit id, Abtastrate und Dezimation des Teilstroms
+    Subscription addSubscriber( const std::string &ip, uint16_t port, double freq, double bandwidth,
+                                double lease = 0, const std::string &owner = std::string()) {
+        const double samp_rate = _samp_rate;
+        if( samp_rate <= 0.)
+            throw std::runtime_error( "FEHLER UdpStreamServer: Abtastrate unbekannt");
+        if( bandwidth <= 0. || std::abs( freq - _center_freq) + bandwidth / 2 > samp_rate / 2)
+            throw std::invalid_argument( "FEHLER UdpStreamServer: Band ausserhalb des Stroms");
+
+        auto sub = std::make_shared<Subscriber>();
+        sub->info.ip = ip;
+        sub->info.port = port;
+        sub->info.freq = freq;
+        sub->info.bandwidth = bandwidth;
+        sub->info.decimation = ZoomProcessor::decimationFor( bandwidth / samp_rate);
+        sub->info.samp_rate = samp_rate / static_cast<double>( sub->info.decimation);
+        sub->ddc.setDecimation( sub->info.decimation);
+        sub->sender = std::make_unique<UDPSender>( ip, port);
+        {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            sub->sender->setMtu( _mtu);
+            sub->sender->setProtocol( _protocol);
+            sub->sender->setEncoding( _encoding);
+        }
+        sub->sender->setSampleRate( sub->info.samp_rate);
+        sub->owner = owner;
+        sub->leased = lease > 0.;
+        sub->expires = std::chrono::steady_clock::now()
+                       + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                             std::chrono::duration<double>( lease));
+
+        std::lock_guard<std::mutex> lock( _mutexer);
+        sub->info.id = _next_id++;
+        sub->sender->setStreamId( sub->info.id);
+        _subscribers.push_back( sub);
+        return sub->info;
+    }
+
+    /// @return false: keine solche id
+    bool removeSubscriber( uint32_t id) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return std::erase_if( _subscribers, [ id]( const std::shared_ptr<Subscriber> &sub)
+                              { return sub->info.id == id;}) > 0;
+    }
+
+    std::vector<Subscription> subscriptions() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        std::vector<Subscription> subs;
+        for( const std::shared_ptr<Subscriber> &sub : _subscribers)
+            subs.push_back( sub->info);
+        return subs;
+    }
+    uint64_t getSubscriberCount() {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        return _subscribers.size();
+    }
+
+    /// @brief oeffnet den Steuerport fuer SUBSCRIBE/UNSUBSCRIBE/LIST; ausserhalb von
+    ///        Loopback nur mit Token oder Freigabeliste
+    /// @return 0: alles normal, -1: Fehler (siehe getError())
+    int startControl( uint16_t port, const std::string &bind_ip = "127.0.0.1") {
+        stopControl();
+        struct sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons( port);
+        if( inet_pton( AF_INET, bind_ip.c_str(), &addr.sin_addr) <= 0) {
+            _error = "FEHLER UdpStreamServer: ungueltige Adresse " + bind_ip;
+            return -1;
+        }
+        const bool loopback = ( ntohl( addr.sin_addr.s_addr) >> 24) == 127;
+        bool open_access;
+        {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            open_access = _token.empty() && _allowed.empty();
+        }
+        if( ! loopback && open_access) {
+            _error = "FEHLER UdpStreamServer: Steuerport auf " + bind_ip + " nur mit Token oder Freigabeliste";
+            return -1;
+        }
+        if( ( _control_fd = socket( AF_INET, SOCK_DGRAM, 0)) < 0) {
+            _error = "FEHLER UdpStreamServer: kann socket nicht erstellen";
+            return -1;
+        }
+        // kurze Zeitueberschreitung, damit stopControl() den Thread beenden kann
+        struct timeval timeout{ 0, 200000};
+        setsockopt( _control_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof( timeout));
+        if( bind( _control_fd, reinterpret_cast<struct sockaddr*>( &addr), sizeof( addr)) < 0) {
+            _error = "FEHLER UdpStreamServer::bind(): " + std::string( std::strerror( errno));
+            ::close( _control_fd);
+            _control_fd = -1;
+            return -1;
+        }
+        _control_running = true;
+        _control = std::thread( &UdpStreamServer::controlLoop, this);
+        return 0;
+    }
+    void stopControl() {
+        _control_running = false;
+        if( _control.joinable()) _control.join();
+        if( _control_fd >= 0) ::close( _control_fd);
+        _control_fd = -1;
+    }
+
+    std::string getError() const { return _error;}
+};
+
+#endif // UDPSERVER_HPP
@@ -8,67 +8,30 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QLabel>
+#include <QComboBox>
+#include <QTimer>
 #include <QUdpSocket>
 
 #include <complex>
 #include <vector>
-#include <unistd.h>
-#include <arpa/inet.h>
-#include <sys/socket.h>
-#include <iostream>
+#include <memory>
+#include <mutex>
 
+#include "sampleblock.hpp"
+#include "udpsender.hpp"
 
-// Der eigentlche UDP Verbindungsvorgang wird OHNE Qt gemacht, die notwendige GUI-Klasse folg unten
-class UDPSender {
-	struct sockaddr_in _dest_addr{};
-	int _sockfd;
-
-    // MTU 1500
-    const uint64_t max_send_bytes = 1472;
-
-public:
-    UDPSender( std::string ip, uint16_t port) {
-		// socket erstellen
-        if( 0 > (_sockfd = socket( AF_INET, SOCK_DGRAM, 0))) {
-			throw std::runtime_error("FEHLER kann socket nicht erstellen ");
-		}
-		
-		// setzte ip:port und validiere
-		_dest_addr.sin_family = AF_INET;
-        //_dest_addr.sin_addr.s_addr =
-		_dest_addr.sin_port = htons(port);
-		if ( inet_pton( AF_INET, ip.c_str(), &_dest_addr.sin_addr) <= 0) {
-			std::cerr << "Invalid address or address not supported: " << ip << std::endl;
-			return;	
-		}
-		
-		// verbindung herstellen
-		if( connect( _sockfd, (struct sockaddr *)&_dest_addr, sizeof( _dest_addr)) < 0) {
-			throw std::runtime_error("FEHLER UDP::connect");
-		}
-    }
-	
-	~UDPSender() {
-        close(_sockfd);;
-	}
-
-	template< typename T>
-    void sendData( const std::vector<T> &input) {
-        uint64_t cnt = 0;
-        while( cnt + max_send_bytes < input.size() * sizeof( T)) {
-            send( _sockfd, &(reinterpret_cast<const char*>( input.data()))[cnt], max_send_bytes, 0);
-            cnt += max_send_bytes;
-        }
-        if( cnt % max_send_bytes)
-            send( _sockfd, &(reinterpret_cast<const char*>( input.data()))[cnt], cnt % max_send_bytes, 0);
-	}
-};
 
 // Der GUI Teil vom eientlichen UDP Vorgang entkoppelt
 class UDPSenderWidget : public QWidget {
     Q_OBJECT
 
-    UDPSender *_udp;
+    // die Senke sendet ueber eine Kopie des Zeigers ausserhalb von _mutexer, ein langsames
+    // oder gedrosseltes Senden haelt den GUI-Thread damit nicht auf
+    std::shared_ptr<UDPSender> _udp;
+    std::mutex _mutexer;
+    double _samp_rate = 0;
+    bool _rate_changed = false;     // setSampleRate() wirkt im Thread der Senke
+    Vrt::Context _context;
 
 public:
     UDPSenderWidget(QWidget *parent = nullptr) : QWidget(parent) {
@@ -80,6 +43,38 @@ public:
         portInput = new QLineEdit("12345");
         qhbl->addWidget(portInput);
 
+        // Jumbo-Frames nur, wenn die ganze Strecke sie durchlaesst
+        mtuInput = new QComboBox;
+        mtuInput->addItem( "MTU 1500", 1500);
+        mtuInput->addItem( "MTU 9000", 9000);
+        mtuInput->setEditable( true);
+        qhbl->addWidget( mtuInput);
+        rateInput = new QLineEdit( "0");
+        rateInput->setToolTip( "Datenrate in MB/s, 0: ungedrosselt");
+        rateInput->setMaximumWidth( 60);
+        qhbl->addWidget( new QLabel( "MB/s:"));
+        qhbl->addWidget( rateInput);
+
+        // VITA-49 fuer fremde DSP-Server, sonst der eigene Kopf
+        protocolInput = new QComboBox;
+        protocolInput->addItem( "MOUSE", static_cast<int>( UdpProtocol::Mouse));
+        protocolInput->addItem( "VITA-49", static_cast<int>( UdpProtocol::Vrt));
+        qhbl->addWidget( protocolInput);
+        streamIdInput = new QLineEdit( "1");
+        streamIdInput->setToolTip( "VRT Stream ID");
+        streamIdInput->setMaximumWidth( 80);
+        qhbl->addWidget( streamIdInput);
+
+        // Kodierung der Abtastwerte, 0: so wie der Block ankommt
+        encodingInput = new QComboBox;
+        encodingInput->addItem( "nativ", 0);
+        encodingInput->addItem( "cf32", static_cast<int>( SampleEncoding::CF32));
+        encodingInput->addItem( "sc16", static_cast<int>( SampleEncoding::SC16));
+        encodingInput->addItem( "sc8 bfp", static_cast<int>( SampleEncoding::SC8Bfp));
+        encodingInput->addItem( "verlustfrei", static_cast<int>( SampleEncoding::Lossless));
+        encodingInput->setToolTip( "Kodierung auf der Leitung, VITA-49 nur cf32 und sc16");
+        qhbl->addWidget( encodingInput);
+
         startButton = new QPushButton("Start");
         stopButton = new QPushButton("Stop");
         stopButton->setEnabled(false);
@@ -88,6 +83,10 @@ public:
 
         statusLabel = new QLabel("Status: Stopped");
         qhbl->addWidget(statusLabel);
+        statsLabel = new QLabel;
+        qhbl->addWidget( statsLabel);
+        timer = new QTimer( this);
+        connect( timer, &QTimer::timeout, this, &UDPSenderWidget::updateInfo);
 
         // Connect signals and slots
         connect(startButton, &QPushButton::clicked, this, &UDPSenderWidget::startSending);
@@ -96,34 +95,77 @@ public:
         setLayout(qhbl);
     }
 
+	/// @brief wird im Thread der Senke aufgerufen, der Block geht ohne Kopie hinaus
 	template<typename T>
-    void sendData( const std::vector<T> &input) {
-        if( startButton->isEnabled()) {return ;}
-        _udp->sendData<T>( input);
-        std::cerr << "senddata: " << input.size() << std::endl;
-
-        // std::cerr << "input: " << input.size() << std::endl;
-        // _udp_socket->writeDatagram( reinterpret_cast<const char*>( input.data()),
-        //                            input.size() / 2 * sizeof(std::complex<float>),
-        //                            targetIP, targetPort);
-        // _udp_socket->writeDatagram( reinterpret_cast<const char*>( &input.data()[input.size()/ 2]),
-        //                            input.size() / 2 * sizeof(std::complex<float>),
-        //                            targetIP, targetPort);
-        // std::cerr << _udp_socket->errorString().toStdString() << std::endl;
+    void sendData( const SampleBlockPtr<T> &input) {
+        std::shared_ptr<UDPSender> udp;
+        double samp_rate = 0;
+        bool rate_changed = false;
+        {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            udp = _udp;
+            std::swap( rate_changed, _rate_changed);
+            samp_rate = _samp_rate;
+        }
+        if( ! udp) {return ;}
+        if( rate_changed) udp->setSampleRate( samp_rate);
+        udp->sendData<T>( input->data(), input->size(), input->index());
+    }
+
+public slots:
+    /// @brief fuer die Zeitstempel der Datagramme, z.B. von MouseGUI::bandwidthChanged
+    void setSampleRate( int32_t samp_rate) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _samp_rate = samp_rate;
+        _context.samp_rate = samp_rate;
+        _context.bandwidth = samp_rate;
+        _rate_changed = true;
+        if( _udp) _udp->setContext( _context);
+    }
+    /// @brief VRT: geht als Context-Paket hinaus, z.B. von MouseGUI::centerFreqChanged
+    void setCenterFrequency( int32_t center_freq) {
+        std::lock_guard<std::mutex> lock( _mutexer);
+        _context.center_freq = center_freq;
+        if( _udp) _udp->setContext( _context);
     }
 
 private slots:
     void startSending() {
         // Get IP and port from input fields
-        _udp = new UDPSender( ipInput->text().toStdString(), portInput->text().toUInt());
+        try {
+            std::shared_ptr<UDPSender> udp = std::make_shared<UDPSender>(
+                        ipInput->text().toStdString(), portInput->text().toUInt());
+            const QString mtu = mtuInput->currentText().remove( "MTU").trimmed();
+            udp->setMtu( mtu.toULongLong());
+            udp->setRate( rateInput->text().toDouble() * 1e6);
+            udp->setProtocol( static_cast<UdpProtocol>( protocolInput->currentData().toInt()));
+            udp->setStreamId( streamIdInput->text().toUInt( nullptr, 0));
+            const int encoding = encodingInput->currentData().toInt();
+            if( encoding) udp->setEncoding( static_cast<SampleEncoding>( encoding));
+            std::lock_guard<std::mutex> lock( _mutexer);
+            udp->setSampleRate( _samp_rate);
+            udp->setContext( _context);
+            _udp = std::move( udp);
+            _last_bytes = 0;
+        }
+        catch( const std::exception &e) {
+            statusLabel->setText( QString( "Status: ") + e.what());
+            return;
+        }
 
         // Enable/disable buttons
         startButton->setEnabled(false);
         stopButton->setEnabled(true);
         statusLabel->setText("Status: Sending messages");
+        timer->start( 1000);
     }
 
     void stopSending() {
+        timer->stop();
+        {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            _udp.reset();
+        }
         // Enable/disable buttons
         startButton->setEnabled(true);
         stopButton->setEnabled(false);
@@ -131,12 +173,40 @@ private slots:
         statusLabel->setText("Status: Stopped");
     }
 
+    void updateInfo() {
+        std::shared_ptr<UDPSender> udp;
+        {
+            std::lock_guard<std::mutex> lock( _mutexer);
+            udp = _udp;
+        }
+        if( ! udp) return;
+        // Zaehler sind atomar, getError() hat einen eigenen Mutex
+        const UDPSender::Statistics stat = udp->getStatistics();
+        const double mbytes = static_cast<double>( stat.bytes - _last_bytes) / 1e6;
+        _last_bytes = stat.bytes;
+        statsLabel->setText( QString( "%1 MB/s | %2 Pakete | %3 Fehler | Kompression %4x%5")
+                                 .arg( mbytes, 0, 'f', 1)
+                                 .arg( stat.packets)
+                                 .arg( stat.errors)
+                                 .arg( stat.ratio(), 0, 'f', 2)
+                             + ( stat.gso ? " | GSO" : ""));
+        statsLabel->setToolTip( QString::fromStdString( udp->getError()));
+    }
+
 private:
     QLineEdit *ipInput;
     QLineEdit *portInput;
+    QComboBox *mtuInput;
+    QLineEdit *rateInput;
+    QComboBox *protocolInput;
+    QLineEdit *streamIdInput;
+    QComboBox *encodingInput;
     QPushButton *startButton;
     QPushButton *stopButton;
     QLabel *statusLabel;	
+    QLabel *statsLabel;
+    QTimer *timer;
+    uint64_t _last_bytes = 0;
 };
 
 #endif // UDPSINK_HPP
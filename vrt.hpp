@@ -0,0 +1,195 @@
+#ifndef VRT_HPP
+#define VRT_HPP
+
+#include <vector>
+#include <complex>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <endian.h>
+
+
+/// @brief VITA-49.0 (VRT) Signal-Data- und Context-Pakete, wie sie gaengige DSP-Server
+///        und Analysatoren direkt annehmen. Alle Worte in Netzwerk-Reihenfolge (Big Endian),
+///        Zeitstempel als UTC-Sekunden (TSI) plus Pikosekunden (TSF real time). Die Zeit
+///        eines Pakets folgt aus der Stromposition seines ersten Werts, nicht aus der
+///        Ankunft des Blocks.
+namespace Vrt {
+
+/// @brief Paketarten im Kopfwort, Bits 31..28
+enum class PacketType : uint32_t {
+    SignalData = 0x1,   // IF Data mit Stream ID
+    Context    = 0x4    // IF Context
+};
+
+/// @brief Angaben im Context-Paket, gesendet bei jeder Aenderung
+struct Context {
+    double samp_rate = 0;       // [Sps]
+    double center_freq = 0;     // [Hz], RF Reference Frequency
+    double bandwidth = 0;       // [Hz]
+};
+
+/// @brief Festkomma mit 20 Nachkommabits (Frequenzen, Abtastrate, Bandbreite)
+inline uint64_t
+fixed20( double value) {
+    return static_cast<uint64_t>( static_cast<int64_t>( std::llround( value * 1048576.)));
+}
+
+/// @brief Data Item Format und Groesse im Data Payload Format Feld
+template <typename T>
+constexpr uint32_t itemFormat() {
+    if constexpr( std::is_same_v<T, std::complex<float>>) return 0x0e;   // IEEE-754 single
+    else return 0x00;                                                   // signed fixed point
+}
+
+class Encoder {
+    uint32_t _stream_id;
+    uint32_t _data_count, _context_count;   // 4-bit Paketzaehler je Paketart
+    // Zeitbezug: Stromposition _ref_index entspricht _ref_time
+    uint64_t _ref_index;
+    std::chrono::system_clock::time_point _ref_time;
+    bool _has_ref;
+    double _samp_rate;
+    std::vector<uint8_t> _swapped;
+
+    static void put32( uint8_t *&out, uint32_t word) {
+        const uint32_t be = htobe32( word);
+        std::memcpy( out, &be, 4);
+        out += 4;
+    }
+    static void put64( uint8_t *&out, uint64_t word) {
+        put32( out, static_cast<uint32_t>( word >> 32));
+        put32( out, static_cast<uint32_t>( word));
+    }
+
+    /// @brief Kopfwort: Typ, C = 0 (keine Class ID), T = 0 (kein Trailer), TSI = UTC,
+    ///        TSF = real time (ps), Zaehler, Groesse in 32-bit Worten
+    static uint32_t headerWord( PacketType type, uint32_t count, uint64_t words) {
+        return ( static_cast<uint32_t>( type) << 28) | ( 1u << 22) | ( 2u << 20)
+               | ( ( count & 0xf) << 16) | static_cast<uint32_t>( words & 0xffff);
+    }
+
+    /// @brief UTC-Sekunden und Pikosekunden der Stromposition index
+    void timestamp( uint64_t index, uint32_t &secs, uint64_t &picos) const {
+        const int64_t ref_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   _ref_time.time_since_epoch()).count();
+        const int64_t ref_secs = ref_ns / 1000000000;
+        // Nachkommateil getrennt rechnen, double reicht sonst nicht fuer Pikosekunden
+        double frac = static_cast<double>( ref_ns % 1000000000) * 1e-9;
+        if( _samp_rate > 0.)
+            frac += static_cast<double>( static_cast<int64_t>( index - _ref_index)) / _samp_rate;
+        const double whole = std::floor( frac);
+        secs = static_cast<uint32_t>( ref_secs + static_cast<int64_t>( whole));
+        picos = static_cast<uint64_t>( std::llround( ( frac - whole) * 1e12));
+        if( picos >= 1000000000000ull) {
+            ++secs;
+            picos -= 1000000000000ull;
+        }
+    }
+
+public:
+    /// @brief Header, Stream ID, TSI, 2 x TSF
+    static constexpr uint64_t data_header_size = 5 * 4;
+    /// @brief Header, Stream ID, TSI, 2 x TSF, CIF0, Bandbreite, RF-Frequenz, Abtastrate,
+    ///        Data Payload Format (je 2 Worte)
+    static constexpr uint64_t context_size = ( 6 + 4 * 2) * 4;
+    /// @brief groesste Nutzlast eines Pakets (16-bit Wortzaehler)
+    static constexpr uint64_t max_payload = 0xffff * 4 - data_header_size;
+
+    Encoder( uint32_t stream_id = 1)
+        : _stream_id( stream_id), _data_count( 0), _context_count( 0), _ref_index( 0),
+          _has_ref( false), _samp_rate( 0) {}
+
+    void setStreamId( uint32_t stream_id) { _stream_id = stream_id;}
+    uint32_t streamId() const { return _stream_id;}
+
+    /// @brief Abtastrate fuer die Zeitstempel, setzt den Zeitbezug zurueck
+    void setSampleRate( double samp_rate) {
+        _samp_rate = samp_rate;
+        _has_ref = false;
+    }
+    /// @brief legt fest, dass Stromposition index zur Zeit time gehoert; ohne Aufruf gilt
+    ///        der erste Block als Bezug
+    void setTimeReference( uint64_t index, std::chrono::system_clock::time_point time) {
+        _ref_index = index;
+        _ref_time = time;
+        _has_ref = true;
+    }
+    bool hasTimeReference() const { return _has_ref;}
+
+    /// @brief Kopf eines Signal-Data-Pakets mit samples Werten vom Typ T
+    template <typename T>
+    void encodeDataHeader( uint8_t *out, uint64_t samples, uint64_t sample_index) {
+        static_assert( sizeof( T) % 4 == 0, "VRT: Abtastwert muss ganze 32-bit Worte belegen");
+        uint32_t secs;
+        uint64_t picos;
+        timestamp( sample_index, secs, picos);
+        put32( out, headerWord( PacketType::SignalData, _data_count++,
+                                data_header_size / 4 + samples * sizeof( T) / 4));
+        put32( out, _stream_id);
+        put32( out, secs);
+        put64( out, picos);
+    }
+
+    /// @brief vollstaendiges Context-Paket
+    /// @param changed Context Field Change Indicator, true nach Umstimmen oder Filterwechsel
+    /// @return Groesse in Byte (context_size)
+    template <typename T>
+    uint64_t encodeContext( uint8_t *out, const Context &ctx, bool changed, uint64_t sample_index) {
+        uint32_t secs;
+        uint64_t picos;
+        timestamp( sample_index, secs, picos);
+        put32( out, headerWord( PacketType::Context, _context_count++, context_size / 4));
+        put32( out, _stream_id);
+        put32( out, secs);
+        put64( out, picos);
+        // CIF0: 31 change, 29 bandwidth, 27 RF reference frequency, 21 sample rate,
+        //       15 data packet payload format; Felder in absteigender Bitfolge
+        put32( out, ( changed ? 1u << 31 : 0u) | ( 1u << 29) | ( 1u << 27) | ( 1u << 21) | ( 1u << 15));
+        put64( out, fixed20( ctx.bandwidth));
+        put64( out, fixed20( ctx.center_freq));
+        put64( out, fixed20( ctx.samp_rate));
+        // processing-efficient, komplex kartesisch, Datenformat, Item-Groesse je Komponente
+        const uint32_t item_bits = static_cast<uint32_t>( sizeof( T) / 2 * 8);
+        put32( out, ( 1u << 29) | ( itemFormat<T>() << 24) | ( ( item_bits - 1) << 6) | ( item_bits - 1));
+        put32( out, 0);     // Repeat Count 1, Vector Size 1
+        return context_size;
+    }
+
+    /// @brief Nutzlast in Netzwerk-Reihenfolge: auf Big-Endian-Rechnern der Block selbst,
+    ///        sonst eine byteweise gedrehte Kopie in einem wiederverwendeten Puffer
+    template <typename T>
+    const uint8_t* payload( const T *input, uint64_t leng) {
+        if constexpr( __BYTE_ORDER == __BIG_ENDIAN) {
+            return reinterpret_cast<const uint8_t*>( input);
+        }
+        else {
+            using Component = typename T::value_type;
+            const uint64_t count = 2 * leng;
+            _swapped.resize( count * sizeof( Component));
+            const Component *in = reinterpret_cast<const Component*>( input);
+            if constexpr( sizeof( Component) == 4) {
+                uint32_t *out = reinterpret_cast<uint32_t*>( _swapped.data());
+                for( uint64_t w = 0; w < count; ++w) {
+                    uint32_t bits;
+                    std::memcpy( &bits, &in[ w], 4);
+                    out[ w] = __builtin_bswap32( bits);
+                }
+            }
+            else if constexpr( sizeof( Component) == 2) {
+                uint16_t *out = reinterpret_cast<uint16_t*>( _swapped.data());
+                for( uint64_t w = 0; w < count; ++w)
+                    out[ w] = __builtin_bswap16( static_cast<uint16_t>( in[ w]));
+            }
+            else {
+                std::memcpy( _swapped.data(), in, count * sizeof( Component));
+            }
+            return _swapped.data();
+        }
+    }
+};
+
+}
+
+#endif // VRT_HPP